@@ -7,10 +7,29 @@ const MQTT_BROKER = 'wss://ceff3b2fc9074ac487a7ba2d62c24ef5.s1.eu.hivemq.cloud:8
 const STATE_TOPIC = 'wheelchair/state';
 const MOTOR_CMD_TOPIC = 'wheelchair/command/motor';
 const EMERGENCY_CMD_TOPIC = 'wheelchair/command/emergency';
+const PROBE_TOPIC = 'wheelchair/diag/probe';
+const ECHO_TOPIC = 'wheelchair/diag/echo';
+const LINK_TOPIC = 'wheelchair/diag/link';
+
+// Link probes: one per second, lost after 2 s, stats over the last 64
+const PROBE_PERIOD_MS = 1000;
+const PROBE_TIMEOUT_MS = 2000;
+const PROBE_WINDOW = 64;
+
+// Motor commands are sent on change only. While the output holds steady a
+// keepalive repeats the last command just inside the chair's watchdog
+// (CONFIG_MOTOR_DECAY_MS, default 300 ms) so the drive does not decay.
+const CMD_SAMPLE_MS = 30;     // how often the joystick output is sampled
+const CMD_DEADBAND = 2;       // % per field that counts as a change
+const CMD_KEEPALIVE_MS = 250; // must stay below CONFIG_MOTOR_DECAY_MS
 
 let client;
 let isConnected = false;
 let periodicInterval = null;
+let probeInterval = null;
+let probeId = 0;
+const probePending = new Map();   // id -> send time (ms)
+const probeWindow = [];           // RTT in ms, null = lost
 
 // DOM Elements
 let statusEl, connContainer;
@@ -18,7 +37,9 @@ let manualLeftEl, manualRightEl, manualSendBtn;
 let periodicLeftEl, periodicRightEl, periodicIntervalEl, periodicToggleBtn;
 let emergencyStopBtn, emergencyStartBtn;
 let stateLeftEl, stateRightEl;
-let joystickMinEl, joystickMaxEl, joystickZone;
+let cmdRateEl;
+let joystickMaxEl, joystickZone;
+let linkWebEl, linkChairEl, linkStateEl, linkRssiEl;
 
 // Initialize on DOM ready
 window.addEventListener('DOMContentLoaded', () => {
@@ -40,11 +61,16 @@ window.addEventListener('DOMContentLoaded', () => {
 
   stateLeftEl = document.getElementById('state-left');
   stateRightEl = document.getElementById('state-right');
+  cmdRateEl = document.getElementById('cmd-rate');
 
-  joystickMinEl = document.getElementById('joystick-min');
   joystickMaxEl = document.getElementById('joystick-max');
   joystickZone = document.getElementById('joystick-zone');
 
+  linkWebEl = document.getElementById('link-web');
+  linkChairEl = document.getElementById('link-chair');
+  linkStateEl = document.getElementById('link-state');
+  linkRssiEl = document.getElementById('link-rssi');
+
   // Setup UI callbacks
   manualSendBtn.addEventListener('click', sendManualCommand);
   periodicToggleBtn.addEventListener('click', togglePeriodic);
@@ -53,6 +79,7 @@ window.addEventListener('DOMContentLoaded', () => {
 
   // Initialize joystick control
   setupJoystick();
+  setInterval(showCommandRate, 1000);
 
   // Connect to MQTT
   connectMQTT();
@@ -85,11 +112,17 @@ function onConnect() {
   updateStatus(true);
   // Subscribe to state topic
   client.subscribe(STATE_TOPIC, { qos: 1 });
+  // Link probes: echo the chair's, time our own
+  client.subscribe(PROBE_TOPIC, { qos: 0 });
+  client.subscribe(ECHO_TOPIC, { qos: 0 });
+  client.subscribe(LINK_TOPIC, { qos: 0 });
+  startProbes();
 }
 
 function onConnectionLost(responseObject) {
   console.warn('MQTT connection lost:', responseObject.errorMessage);
   updateStatus(false);
+  stopProbes();
   // Optionally try reconnect
 }
 
@@ -103,6 +136,12 @@ function onMessageArrived(message) {
     } catch (e) {
       console.error('Invalid JSON in state message:', e);
     }
+  } else if (message.destinationName === PROBE_TOPIC) {
+    handleProbe(message.payloadString);
+  } else if (message.destinationName === ECHO_TOPIC) {
+    handleEcho(message.payloadString);
+  } else if (message.destinationName === LINK_TOPIC) {
+    showChairLink(message.payloadString);
   }
 }
 
@@ -135,23 +174,86 @@ function publishJSON(topic, obj) {
 function sendManualCommand() {
   const left = parseInt(manualLeftEl.value, 10) || 0;
   const right = parseInt(manualRightEl.value, 10) || 0;
-  publishJSON(MOTOR_CMD_TOPIC, { left, right });
+  motorSender.send({ left, right });
+}
+
+// Motor command sender: send on change beyond the deadband, a keepalive
+// while steady, and one repeat right after a change so the chair's
+// playout sees the output settle instead of extrapolating the last step.
+// Commands are { left, right } or a twist { v, w }; both have two fields.
+const motorSender = {
+  last: null,        // command last sent
+  lastSentAt: 0,
+  settlePending: false,
+  sent: 0,
+  skipped: 0,
+  sentAt: [],        // send times over the last second, for the rate display
+
+  // Offer the current output; called every CMD_SAMPLE_MS while active
+  offer(cmd) {
+    const now = Date.now();
+    const changed = !this.last ||
+      Object.keys(cmd).some(k => !(k in this.last) ||
+        Math.abs(cmd[k] - this.last[k]) >= CMD_DEADBAND ||
+        ((cmd[k] === 0) !== (this.last[k] === 0)));
+
+    if (changed) {
+      this.send(cmd, now);
+      this.settlePending = true;
+    } else if (this.settlePending || now - this.lastSentAt >= CMD_KEEPALIVE_MS) {
+      this.send(this.last, now);
+      this.settlePending = false;
+    } else {
+      this.skipped++;
+    }
+  },
+
+  // Send unconditionally (stop, manual command)
+  send(cmd, now = Date.now()) {
+    publishJSON(MOTOR_CMD_TOPIC, cmd);
+    this.last = cmd;
+    this.lastSentAt = now;
+    this.sent++;
+    this.sentAt.push(now);
+  },
+
+  // Output released: send the final stop and forget the last command
+  stop() {
+    this.send({ left: 0, right: 0 });
+    this.last = null;
+    this.settlePending = false;
+  },
+
+  rate() {
+    const cutoff = Date.now() - 1000;
+    while (this.sentAt.length && this.sentAt[0] < cutoff) this.sentAt.shift();
+    return this.sentAt.length;
+  }
+};
+
+function showCommandRate() {
+  const total = motorSender.sent + motorSender.skipped;
+  const saved = total ? Math.round(100 * motorSender.skipped / total) : 0;
+  cmdRateEl.textContent = `${motorSender.rate()} msg/s (${motorSender.sent} sent, ${saved} % suppressed)`;
 }
 
 // Periodic command
 function togglePeriodic() {
   if (periodicInterval === null) {
+    // The interval is how often the inputs are sampled; commands go out
+    // on change plus the keepalive
     const interval = parseInt(periodicIntervalEl.value, 10) || 200;
     periodicToggleBtn.textContent = 'Stop';
     periodicInterval = setInterval(() => {
       const left = parseInt(periodicLeftEl.value, 10) || 0;
       const right = parseInt(periodicRightEl.value, 10) || 0;
-      publishJSON(MOTOR_CMD_TOPIC, { left, right });
-    }, interval);
+      motorSender.offer({ left, right });
+    }, Math.min(interval, CMD_KEEPALIVE_MS));
   } else {
     clearInterval(periodicInterval);
     periodicInterval = null;
     periodicToggleBtn.textContent = 'Start';
+    motorSender.stop();
   }
 }
 
@@ -167,7 +269,7 @@ function setupJoystick() {
   });
 
   const maxDistance = manager.options.size / 2;
-  const intervalTime = 30; // ms - Send command interval
+  const intervalTime = CMD_SAMPLE_MS; // ms - Output sample interval
   let joystickInterval = null;
   let isJoystickActive = false;
   let currentJoystickData = null; // Store the latest joystick data
@@ -182,19 +284,16 @@ function setupJoystick() {
     let factor = currentJoystickData.distance / maxDistance;
     if (factor > 1) factor = 1;
 
-    const minSpeed = parseInt(joystickMinEl.value, 10) || 0;
     const maxSpeed = parseInt(joystickMaxEl.value, 10) || 100;
 
-    // Mix for differential drive (Flipped Left/Right)
+    // Twist command, mixed to wheel speeds on the chair (min speed, turn
+    // gain and saturation are firmware settings, CONFIG_MOTOR_TWIST_*).
     // Y-axis (normY) controls forward/backward speed.
-    // X-axis (normX) controls turning.
-    let leftNorm = (normY - normX) / 2 * factor;  // Steering: Positive X (right) decreases left speed
-    let rightNorm = (normY + normX) / 2 * factor; // Steering: Positive X (right) increases right speed
+    // X-axis (normX) controls turning: positive X speeds up the right wheel.
+    const v = Math.round(normY * factor * maxSpeed);
+    const w = Math.round(normX * factor * maxSpeed);
 
-    const leftSpeed = Math.sign(leftNorm) * (minSpeed + (maxSpeed - minSpeed) * Math.abs(leftNorm));
-    const rightSpeed = Math.sign(rightNorm) * (minSpeed + (maxSpeed - minSpeed) * Math.abs(rightNorm));
-
-    publishJSON(MOTOR_CMD_TOPIC, { left: Math.round(leftSpeed), right: Math.round(rightSpeed) });
+    motorSender.offer({ v, w });
   }
 
   manager.on('start', (evt, data) => {
@@ -203,7 +302,7 @@ function setupJoystick() {
     currentJoystickData = data; // Store initial data
     // Clear any previous interval just in case
     if (joystickInterval) clearInterval(joystickInterval);
-    // Start sending periodically
+    // Sample the output periodically; the sender decides what goes out
     joystickInterval = setInterval(publishJoystickPosition, intervalTime);
   });
 
@@ -222,6 +321,82 @@ function setupJoystick() {
       joystickInterval = null;
     }
     // Send a final stop command
-    publishJSON(MOTOR_CMD_TOPIC, { left: 0, right: 0 });
+    motorSender.stop();
   });
-} 
\ No newline at end of file
+} 
+
+// Link quality probes
+function startProbes() {
+  stopProbes();
+  probeInterval = setInterval(sendProbe, PROBE_PERIOD_MS);
+}
+
+function stopProbes() {
+  if (probeInterval) {
+    clearInterval(probeInterval);
+    probeInterval = null;
+  }
+  probePending.clear();
+}
+
+function recordProbe(rtt) {
+  probeWindow.push(rtt);
+  if (probeWindow.length > PROBE_WINDOW) probeWindow.shift();
+}
+
+function sendProbe() {
+  const now = Date.now();
+  // Expire unanswered probes as lost
+  for (const [id, sent] of probePending) {
+    if (now - sent >= PROBE_TIMEOUT_MS) {
+      probePending.delete(id);
+      recordProbe(null);
+    }
+  }
+  const id = probeId++;
+  probePending.set(id, now);
+  publishJSON(PROBE_TOPIC, { src: 'web', id, t: now });
+  showWebLink();
+}
+
+function handleProbe(payload) {
+  try {
+    const probe = JSON.parse(payload);
+    if (probe.src === 'chair') publishSimple(ECHO_TOPIC, payload); // echo verbatim
+  } catch (e) {
+    console.error('Invalid probe:', e);
+  }
+}
+
+function handleEcho(payload) {
+  try {
+    const echo = JSON.parse(payload);
+    if (echo.src !== 'web' || !probePending.has(echo.id)) return;
+    probePending.delete(echo.id);
+    recordProbe(Date.now() - echo.t);
+  } catch (e) {
+    console.error('Invalid echo:', e);
+  }
+}
+
+function showWebLink() {
+  const rtts = probeWindow.filter((v) => v !== null).sort((a, b) => a - b);
+  const lost = probeWindow.length - rtts.length;
+  if (!probeWindow.length) return;
+  const rank = (q) => rtts[Math.max(0, Math.ceil(q * rtts.length) - 1)];
+  const loss = (100 * lost / probeWindow.length).toFixed(1);
+  linkWebEl.textContent = rtts.length
+    ? `p50 ${rank(0.5)} ms, p99 ${rank(0.99)} ms, loss ${loss} %`
+    : `loss ${loss} %`;
+}
+
+function showChairLink(payload) {
+  try {
+    const m = JSON.parse(payload);
+    linkChairEl.textContent = `p50 ${m.rtt[0]} ms, p99 ${m.rtt[2]} ms, loss ${(m.loss / 10).toFixed(1)} %`;
+    linkStateEl.textContent = m.state;
+    linkRssiEl.textContent = m.rssi ? `${m.rssi} dBm` : '-';
+  } catch (e) {
+    console.error('Invalid link metrics:', e);
+  }
+}
@@ -0,0 +1,228 @@
+/*=====================================================================
+ * bench.c — Hot‑path micro‑benchmarks (target and host)
+ *====================================================================*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "bench.h"
+
+#if CONFIG_BENCH_SUITE || defined(BENCH_HOST)
+
+#include "motor_control.h"
+#include "motor_cmd.h"
+#include "env_parser.h"
+#include "topic_router.h"
+#include "cmd_arbiter.h"
+
+#ifdef BENCH_HOST
+#include <time.h>
+#define BENCH_PLATFORM          "host"
+static uint64_t bench_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+static uint32_t bench_cycles(void) { return 0; }
+#else
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#define BENCH_PLATFORM          CONFIG_IDF_TARGET
+static uint64_t bench_ns(void) { return (uint64_t)esp_timer_get_time() * 1000ULL; }
+static uint32_t bench_cycles(void) { return esp_cpu_get_cycle_count(); }
+#endif
+
+typedef struct {
+    const char *name;
+    void      (*fn)(void);
+    uint32_t    iters;
+} bench_case_t;
+
+static volatile const char *g_sink;             // keeps lookups alive
+static volatile int g_sink_int;
+
+/* -------- cases ----------------------------------------------------- */
+
+static void bench_motor_command(void)
+{
+    static const char payload[] = "{\"left\":0,\"right\":0}";
+    motor_cmd_t cmd;
+    if (motor_cmd_parse(payload, sizeof(payload) - 1, &cmd) == MOTOR_CMD_OK) {
+        motor_submit_speeds(CMD_SRC_MQTT, cmd.left, cmd.right); // zero — never moves the chair
+    }
+}
+
+static void bench_twist_command(void)
+{
+    static const char payload[] = "{\"v\":0,\"w\":0}";
+    motor_cmd_t cmd;
+    if (motor_cmd_parse(payload, sizeof(payload) - 1, &cmd) == MOTOR_CMD_OK) {
+        motor_submit_twist(CMD_SRC_MQTT, cmd.v, cmd.w);         // zero as well
+    }
+}
+
+static void bench_state_encode(void)
+{
+    static char buf[MOTOR_STATE_PAYLOAD_MAX];
+    g_sink_int = motor_state_encode(buf, sizeof(buf), -100, 73);
+}
+
+/* A full table: the built-in command topics plus per-device filters. */
+static topic_router_t g_router;
+
+static void bench_route_noop(const char *topic, int topic_len,
+                             const char *data, int data_len, void *ctx) {}
+
+static void bench_load_routes(void)
+{
+    static const char *const filters[TOPIC_ROUTER_MAX_ROUTES] = {
+        "wheelchair/command/motor", "wheelchair/command/emergency",
+        "wheelchair/command/ota", "wheelchair/config/set", "wheelchair/telemetry/get",
+        "wheelchair/a/1", "wheelchair/a/2", "wheelchair/a/3", "wheelchair/a/4",
+        "wheelchair/a/5", "wheelchair/a/6", "wheelchair/a/7", "wheelchair/a/8",
+        "wheelchair/a/9", "wheelchair/dev/+/config", "wheelchair/dev/+/cmd/#",
+    };
+    topic_router_init(&g_router);
+    for (int i = 0; i < TOPIC_ROUTER_MAX_ROUTES; i++) {
+        topic_router_add(&g_router, filters[i], 1, bench_route_noop, NULL);
+    }
+}
+
+static void bench_route_exact(void)
+{
+    static const char topic[] = "wheelchair/command/motor";
+    g_sink_int = topic_router_match(&g_router, topic, sizeof(topic) - 1, 24) != NULL;
+}
+
+static void bench_route_wildcard(void)
+{
+    static const char topic[] = "wheelchair/dev/chair-01/cmd/seat";
+    g_sink_int = topic_router_match(&g_router, topic, sizeof(topic) - 1, 24) != NULL;
+}
+
+/* Control‑tick source pick with every slot written and live. */
+static cmd_arbiter_t g_arbiter;
+
+static void bench_load_sources(void)
+{
+    cmd_source_cfg_t cfg[CMD_SRC_COUNT];
+    for (int i = 0; i < CMD_SRC_COUNT; i++) {
+        cfg[i] = (cmd_source_cfg_t){ .timeout_us = INT32_MAX, .claim_neutral = false };
+    }
+    cmd_arbiter_init(&g_arbiter, cfg, 5);
+    for (int i = 0; i < CMD_SRC_COUNT; i++) {
+        cmd_arbiter_submit(&g_arbiter, (cmd_source_t)i, 1, 0, 0);     // all neutral
+    }
+    cmd_arbiter_submit(&g_arbiter, CMD_SRC_HTTP, 1, 40, 40);           // lowest claims
+}
+
+static void bench_arbiter_select(void)
+{
+    cmd_pick_t pick;
+    g_sink_int = cmd_arbiter_select(&g_arbiter, 2, &pick);
+}
+
+static void bench_env_hit(void)  { g_sink = get_env_value("WIFI_PASS"); }
+static void bench_env_miss(void) { g_sink = get_env_value("NOT_CONFIGURED"); }
+
+static const bench_case_t k_cases[] = {
+    { "motor_command", bench_motor_command, 2000   },
+    { "twist_command", bench_twist_command, 2000   },
+    { "state_encode",  bench_state_encode,  10000  },
+    { "topic_route_exact",    bench_route_exact,    100000 },
+    { "topic_route_wildcard", bench_route_wildcard, 100000 },
+    { "arbiter_select", bench_arbiter_select, 100000 },
+    { "slew",          motor_bench_slew,    100000 },
+    { "apply",         motor_bench_apply,   10000  },
+    { "env_lookup_hit",  bench_env_hit,     100000 },
+    { "env_lookup_miss", bench_env_miss,    100000 },
+};
+
+#ifdef BENCH_HOST
+/* The target benchmarks the real .env table; the host gets a full one
+ * with the looked‑up key last. */
+static void bench_load_env_fixture(void)
+{
+    static const char fixture[] =
+        "MQTT_BROKER_URI=mqtts://broker.example.com:8883\n"
+        "MQTT_LAN_URI=mqtt://192.168.1.10:1883\n"
+        "MQTT_USERNAME=wheelchair\n"
+        "MQTT_PASSWORD=\"secret-password\"\n"
+        "DEVICE_NAME=chair-01\n"
+        "KEY_6=v\nKEY_7=v\nKEY_8=v\n"
+        "WIFI_SSID=home-network\n"
+        "WIFI_PASS=\"wifi-password\"\n";
+    FILE *f = fmemopen((void *)fixture, sizeof(fixture) - 1, "r");
+    if (f) {
+        parse_env_stream(f);
+        fclose(f);
+    }
+}
+#endif
+
+/* -------- runner ---------------------------------------------------- */
+
+#define BENCH_CASES     (sizeof(k_cases) / sizeof(k_cases[0]))
+
+void bench_run(FILE *out)
+{
+    static uint64_t best_ns[BENCH_CASES];
+    static uint32_t best_cycles[BENCH_CASES];
+
+#ifdef BENCH_HOST
+    bench_load_env_fixture();
+#endif
+    bench_load_routes();
+    bench_load_sources();
+
+    for (size_t c = 0; c < BENCH_CASES; c++) {
+        best_ns[c] = UINT64_MAX;
+        best_cycles[c] = UINT32_MAX;
+        k_cases[c].fn();                        // warm caches / arena
+    }
+
+    // Round-robin over the cases, so a slow stretch of the machine costs
+    // every case one batch instead of all of one case's batches
+    for (int b = 0; b < BENCH_BATCHES; b++) {
+        for (size_t c = 0; c < BENCH_CASES; c++) {
+            const bench_case_t *bc = &k_cases[c];
+            const uint32_t iters = bc->iters * BENCH_ITER_SCALE;
+            uint64_t t0 = bench_ns();
+            uint32_t c0 = bench_cycles();
+            for (uint32_t i = 0; i < iters; i++) {
+                bc->fn();
+            }
+            uint32_t cycles = bench_cycles() - c0;
+            uint64_t ns = bench_ns() - t0;
+            if (ns < best_ns[c]) best_ns[c] = ns;
+            if (cycles < best_cycles[c]) best_cycles[c] = cycles;
+        }
+    }
+
+    fprintf(out, "{\"platform\":\"%s\",\"results\":[", BENCH_PLATFORM);
+    for (size_t c = 0; c < BENCH_CASES; c++) {
+        const uint32_t iters = k_cases[c].iters * BENCH_ITER_SCALE;
+        fprintf(out, "%s{\"name\":\"%s\",\"iters\":%u,\"ns\":%.1f,\"cycles\":%.1f}",
+                c ? "," : "", k_cases[c].name, (unsigned)iters,
+                (double)best_ns[c] / iters, (double)best_cycles[c] / iters);
+    }
+    fprintf(out, "]}\n");
+}
+
+#endif /* CONFIG_BENCH_SUITE || BENCH_HOST */
+
+#ifndef BENCH_HOST
+void bench_init(void)
+{
+#if CONFIG_BENCH_SUITE
+    ESP_LOGW("BENCH", "Running hot-path benchmark (drives are commanded to 0)");
+    fputs(BENCH_LOG_PREFIX, stdout);
+    bench_run(stdout);
+    fflush(stdout);
+    motor_emergency_stop();                     // drop the benchmark's commands
+#endif
+}
+#endif
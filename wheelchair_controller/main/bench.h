@@ -0,0 +1,62 @@
+/*=====================================================================
+ * bench.h — Micro‑benchmarks of the firmware hot paths
+ *
+ * Cases: motor command parse + dispatch, state encoding, one slew pass,
+ * one apply pass and .env lookups (hit / miss).  Each case runs
+ * BENCH_BATCHES batches of iters × BENCH_ITER_SCALE operations; the
+ * fastest batch is reported, in ns per operation and (on target) CPU
+ * cycles per operation.  Batches run round-robin over the cases, and
+ * the minimum filters out preemption and cache noise, which only ever
+ * makes a batch slower.
+ *
+ * Output is one JSON object on one line:
+ *   {"platform":"esp32","results":[{"name":"slew","iters":N,
+ *     "ns":<ns/op>,"cycles":<cycles/op>},...]}
+ * On target it is printed after BENCH_LOG_PREFIX; compare against a
+ * stored baseline with tools/bench/bench_compare.py.
+ *
+ * The same file builds on the host (tools/bench, -DBENCH_HOST).
+ *====================================================================*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+
+#define BENCH_LOG_PREFIX        "BENCH: "
+
+/* The host shares its CPU and is far noisier than the idle target at
+ * boot: more and longer batches there (~5 s per run). */
+#ifdef BENCH_HOST
+#ifndef BENCH_BATCHES
+#define BENCH_BATCHES           25
+#endif
+#ifndef BENCH_ITER_SCALE
+#define BENCH_ITER_SCALE        10
+#endif
+#else
+#ifndef BENCH_BATCHES
+#define BENCH_BATCHES           9
+#endif
+#ifndef BENCH_ITER_SCALE
+#define BENCH_ITER_SCALE        1
+#endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Run every case and write the JSON report line to @p out. */
+void bench_run(FILE *out);
+
+/** Target: run the suite once at boot (no‑op unless CONFIG_BENCH_SUITE).
+ *  Call before networking starts: the command cases parse through the
+ *  json_pool arena, which only one task may use at a time. */
+void bench_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BENCH_H */
@@ -0,0 +1,306 @@
+/*=====================================================================
+ * broker_select.c — TCP connect‑time probing and broker scoring
+ *====================================================================*/
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "lwip/sockets.h"
+#include "lwip/dns.h"
+#include "lwip/tcpip.h"
+#include "broker_select.h"
+
+#define BACKOFF_MAX_SHIFT   4           // back‑off doubles per failure, up to ×16
+
+static const char *TAG = "BROKER_SEL";
+
+static broker_t g_brokers[BROKER_MAX];
+static int g_count = 0;
+
+/* One DNS lookup at a time, run in the lwIP thread so the caller can
+ * give up after the probe timeout (getaddrinfo blocks for the full DNS
+ * retry schedule). A lookup that timed out stays "busy" until lwIP
+ * finishes it; until then further lookups fail at once. */
+static struct {
+    const char       *host;
+    ip_addr_t         addr;
+    volatile bool     ok;
+    volatile bool     busy;
+    SemaphoreHandle_t done;
+    StaticSemaphore_t done_buf;
+} s_dns;
+
+/* MQTT 3.1.1 CONNECT, clean session, keepalive 5 s, client id "wcprobe" */
+static const uint8_t k_probe_connect[] = {
+    0x10, 19, 0, 4, 'M', 'Q', 'T', 'T', 4, 0x02, 0, 5,
+    0, 7, 'w', 'c', 'p', 'r', 'o', 'b', 'e',
+};
+static const uint8_t k_probe_disconnect[] = { 0xE0, 0 };
+
+/*---------------------------------------------------------------------
+ * Helpers
+ *-------------------------------------------------------------------*/
+
+/* scheme://host[:port][/path] → host, port (scheme default if absent) */
+static bool parse_uri(const char *uri, char *host, size_t host_len,
+                      uint16_t *port, bool *plain)
+{
+    static const struct { const char *scheme; uint16_t port; } k_schemes[] = {
+        { "mqtt://",  1883 },
+        { "mqtts://", 8883 },
+        { "ws://",    80   },
+        { "wss://",   443  },
+    };
+
+    const char *p = NULL;
+    for (size_t i = 0; i < sizeof(k_schemes) / sizeof(k_schemes[0]); i++) {
+        size_t n = strlen(k_schemes[i].scheme);
+        if (strncmp(uri, k_schemes[i].scheme, n) == 0) {
+            p = uri + n;
+            *port = k_schemes[i].port;
+            *plain = i == 0;
+            break;
+        }
+    }
+    if (p == NULL) return false;
+
+    size_t n = strcspn(p, ":/");
+    if (n == 0 || n >= host_len) return false;
+    memcpy(host, p, n);
+    host[n] = '\0';
+
+    if (p[n] == ':') {
+        long v = strtol(p + n + 1, NULL, 10);
+        if (v <= 0 || v > 65535) return false;
+        *port = (uint16_t)v;
+    }
+    return true;
+}
+
+static void dns_found(const char *name, const ip_addr_t *ip, void *arg)
+{
+    if (ip) {
+        s_dns.addr = *ip;
+        s_dns.ok = true;
+    }
+    xSemaphoreGive(s_dns.done);
+    s_dns.busy = false;                 // after the give: see resolve()
+}
+
+static void dns_start(void *arg)
+{
+    err_t e = dns_gethostbyname_addrtype(s_dns.host, &s_dns.addr, dns_found, NULL,
+                                         LWIP_DNS_ADDRTYPE_IPV4);
+    if (e == ERR_INPROGRESS) return;
+    s_dns.ok = (e == ERR_OK);           // literal address or cached
+    xSemaphoreGive(s_dns.done);
+    s_dns.busy = false;
+}
+
+/* IPv4 address of @p host within @p timeout_ms */
+static bool resolve(const char *host, uint32_t timeout_ms, struct sockaddr_in *out)
+{
+    if (s_dns.busy) return false;       // an abandoned lookup is still running
+    if (s_dns.done == NULL) s_dns.done = xSemaphoreCreateBinaryStatic(&s_dns.done_buf);
+    xSemaphoreTake(s_dns.done, 0);      // not busy: no give can still arrive
+
+    s_dns.host = host;
+    s_dns.ok = false;
+    s_dns.busy = true;
+    if (tcpip_callback(dns_start, NULL) != ERR_OK) {
+        s_dns.busy = false;
+        return false;
+    }
+    if (xSemaphoreTake(s_dns.done, pdMS_TO_TICKS(timeout_ms)) != pdTRUE || !s_dns.ok) {
+        return false;
+    }
+    memset(out, 0, sizeof(*out));
+    out->sin_family = AF_INET;
+    inet_addr_from_ip4addr(&out->sin_addr, ip_2_ip4(&s_dns.addr));
+    return true;
+}
+
+/* Wait until @p s is readable / writable, at most until @p deadline_us */
+static bool wait_fd(int s, bool write, int64_t deadline_us)
+{
+    int64_t left = deadline_us - esp_timer_get_time();
+    if (left <= 0) return false;
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(s, &fds);
+    struct timeval tv = { .tv_sec = left / 1000000, .tv_usec = left % 1000000 };
+    return select(s + 1, write ? NULL : &fds, write ? &fds : NULL, NULL, &tv) == 1;
+}
+
+/* A CONNACK (any return code) proves the broker itself is serving, not
+ * just the kernel accepting TCP on its behalf (a hung broker still does) */
+static bool probe_connack(int s, int64_t deadline_us)
+{
+    if (send(s, k_probe_connect, sizeof(k_probe_connect), 0) != (int)sizeof(k_probe_connect)) {
+        return false;
+    }
+    uint8_t ack[4];
+    int got = 0;
+    while (got < (int)sizeof(ack) && wait_fd(s, false, deadline_us)) {
+        int n = recv(s, ack + got, sizeof(ack) - got, 0);
+        if (n <= 0) return false;
+        got += n;
+    }
+    if (got < (int)sizeof(ack) || ack[0] != 0x20) return false;
+    if (ack[3] == 0) send(s, k_probe_disconnect, sizeof(k_probe_disconnect), 0);
+    return true;
+}
+
+/* TCP connect time in ms, −1 if unreachable within the probe timeout
+ * (DNS included); with @p mqtt the broker must also answer a CONNECT */
+static int32_t probe_rtt_ms(const char *host, uint16_t port, bool mqtt)
+{
+    const int64_t deadline = esp_timer_get_time() +
+                             (int64_t)CONFIG_MQTT_BROKER_PROBE_TIMEOUT_MS * 1000;
+    struct sockaddr_in addr;
+
+    if (!resolve(host, CONFIG_MQTT_BROKER_PROBE_TIMEOUT_MS, &addr)) {
+        ESP_LOGW(TAG, "DNS lookup failed for %s", host);
+        return -1;
+    }
+    addr.sin_port = htons(port);
+
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s < 0) return -1;
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+
+    int64_t t0 = esp_timer_get_time();
+    int r = connect(s, (struct sockaddr *)&addr, sizeof(addr));
+
+    int32_t rtt = -1;
+    if (r == 0 || (errno == EINPROGRESS && wait_fd(s, true, deadline))) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(s, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err == 0) {
+            rtt = (int32_t)((esp_timer_get_time() - t0) / 1000);
+            if (mqtt && !probe_connack(s, deadline)) {
+                ESP_LOGW(TAG, "%s:%u accepts TCP but sends no CONNACK", host, port);
+                rtt = -1;
+            }
+        }
+    }
+    close(s);
+    return rtt;
+}
+
+static bool backing_off(const broker_t *b, int64_t now)
+{
+    return now < b->backoff_until_us;
+}
+
+static int32_t score(int index)
+{
+    return g_brokers[index].rtt_ms + index * CONFIG_MQTT_BROKER_PREFER_MARGIN_MS;
+}
+
+/*=====================================================================
+ * Public API implementation
+ *====================================================================*/
+
+void broker_list_reset(void)
+{
+    memset(g_brokers, 0, sizeof(g_brokers));
+    g_count = 0;
+}
+
+int broker_add(const char *uri)
+{
+    if (uri == NULL || uri[0] == '\0' || g_count >= BROKER_MAX) return -1;
+    if (strlen(uri) >= BROKER_URI_MAX) return -1;
+
+    broker_t *b = &g_brokers[g_count];
+    if (!parse_uri(uri, b->host, sizeof(b->host), &b->port, &b->plain)) {
+        ESP_LOGE(TAG, "Invalid broker URI: %s", uri);
+        return -1;
+    }
+    strcpy(b->uri, uri);
+    b->rtt_ms = -1;
+
+    ESP_LOGI(TAG, "Broker %d: %s (%s:%u)", g_count, b->uri, b->host, b->port);
+    return g_count++;
+}
+
+int broker_count(void)
+{
+    return g_count;
+}
+
+const broker_t *broker_get(int index)
+{
+    return (index >= 0 && index < g_count) ? &g_brokers[index] : NULL;
+}
+
+int broker_probe_select(void)
+{
+    int64_t now = esp_timer_get_time();
+    int best = -1;
+    bool skipped = false;
+
+    for (int pass = 0; pass < 2 && best < 0; pass++) {
+        for (int i = 0; i < g_count; i++) {
+            broker_t *b = &g_brokers[i];
+            bool off = backing_off(b, now);
+            /* First pass skips backing‑off brokers, the second only probes them. */
+            if (off != (pass == 1)) {
+                skipped |= off;
+                continue;
+            }
+            b->rtt_ms = probe_rtt_ms(b->host, b->port, false);
+            ESP_LOGI(TAG, "Broker %d RTT: %" PRId32 " ms", i, b->rtt_ms);
+            if (b->rtt_ms >= 0 && (best < 0 || score(i) < score(best))) {
+                best = i;
+            }
+        }
+        if (!skipped) break;            // nothing left for a second pass
+    }
+    return best;
+}
+
+int broker_probe_better(int current)
+{
+    int64_t now = esp_timer_get_time();
+    int best = current;
+
+    for (int i = 0; i < current && i < g_count; i++) {
+        broker_t *b = &g_brokers[i];
+        if (backing_off(b, now) || !b->plain) continue;     // CONNACK probe: mqtt:// only
+        b->rtt_ms = probe_rtt_ms(b->host, b->port, true);
+        if (b->rtt_ms >= 0 &&
+            (g_brokers[current].rtt_ms < 0 || score(i) < score(best))) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+void broker_mark_failed(int index)
+{
+    if (index < 0 || index >= g_count) return;
+    broker_t *b = &g_brokers[index];
+    b->failures++;
+    int shift = b->streak < BACKOFF_MAX_SHIFT ? b->streak : BACKOFF_MAX_SHIFT;
+    b->streak++;
+    int32_t backoff_s = CONFIG_MQTT_BROKER_BACKOFF_S << shift;
+    b->backoff_until_us = esp_timer_get_time() + (int64_t)backoff_s * 1000000;
+    ESP_LOGW(TAG, "Broker %d failed (%" PRIu32 " total, %" PRIu32 " in a row), backing off %" PRId32 " s",
+             index, b->failures, b->streak, backoff_s);
+}
+
+void broker_mark_ok(int index)
+{
+    if (index < 0 || index >= g_count) return;
+    g_brokers[index].backoff_until_us = 0;
+    g_brokers[index].streak = 0;
+}
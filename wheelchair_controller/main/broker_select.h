@@ -0,0 +1,79 @@
+/*=====================================================================
+ * broker_select.h — Prioritised MQTT broker list with RTT probing
+ *
+ * Brokers are kept in priority order (LAN first, cloud last).  A probe
+ * measures the TCP connect time to every broker; selection picks the
+ * reachable broker with the lowest score, where
+ *     score = RTT + priority index × MQTT_BROKER_PREFER_MARGIN_MS
+ * so a higher‑priority broker wins unless it is clearly slower.
+ * Brokers whose MQTT session failed are skipped for
+ * MQTT_BROKER_BACKOFF_S seconds, doubling per failure in a row up to
+ * ×16 (a hung broker still accepts TCP).
+ * The periodic switch back to a higher‑priority broker needs an MQTT
+ * level answer (CONNACK to a probe CONNECT), so it is only offered for
+ * plain mqtt:// brokers (the LAN one); TLS brokers are used again when
+ * the current session fails. DNS is bounded by the probe timeout too.
+ *====================================================================*/
+
+#ifndef BROKER_SELECT_H
+#define BROKER_SELECT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BROKER_MAX          3
+#define BROKER_URI_MAX      96
+#define BROKER_HOST_MAX     64
+
+typedef struct {
+    char     uri[BROKER_URI_MAX];
+    char     host[BROKER_HOST_MAX];
+    uint16_t port;
+    int32_t  rtt_ms;                // last probe, −1 = unreachable
+    int64_t  backoff_until_us;      // skip until then after a failure
+    uint32_t failures;
+    uint32_t streak;                // failures since the last good session
+    bool     plain;                 // mqtt:// (CONNACK probe possible)
+} broker_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Clear the list. */
+void broker_list_reset(void);
+
+/**
+ * Append a broker (lowest priority so far).
+ * @return index, or −1 if the URI is empty/invalid or the list is full
+ */
+int broker_add(const char *uri);
+
+int broker_count(void);
+const broker_t *broker_get(int index);
+
+/**
+ * Probe every broker (bounded by count × probe timeout) and return the
+ * index of the best reachable one, or −1.  Brokers in back‑off are only
+ * considered when no other broker is reachable.
+ */
+int broker_probe_select(void);
+
+/**
+ * Probe only brokers with a higher priority than @p current and return
+ * one that beats it and answers an MQTT CONNECT, or @p current if none
+ * does.
+ */
+int broker_probe_better(int current);
+
+/** Put a broker into back‑off after its MQTT session failed. */
+void broker_mark_failed(int index);
+
+/** Clear the failure back‑off after a successful MQTT session. */
+void broker_mark_ok(int index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BROKER_SELECT_H */
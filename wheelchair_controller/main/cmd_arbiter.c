@@ -0,0 +1,150 @@
+/*=====================================================================
+ * cmd_arbiter.c — Sequence‑locked source slots, priority/ownership pick
+ *
+ * Integer‑only and loop bounds are compile‑time constants, so it can
+ * run from the control tick in any context.
+ *====================================================================*/
+
+#include "cmd_arbiter.h"
+
+#define ARB_READ_RETRIES    4
+
+typedef enum { SLOT_EMPTY, SLOT_OK, SLOT_BUSY } slot_read_t;
+
+void cmd_arbiter_init(cmd_arbiter_t *a, const cmd_source_cfg_t cfg[CMD_SRC_COUNT],
+                      int16_t deadband)
+{
+    *a = (cmd_arbiter_t){
+        .deadband = deadband,
+        .owner    = CMD_SRC_NONE,
+        .stats    = { .owner = CMD_SRC_NONE, .prev_owner = CMD_SRC_NONE },
+    };
+    for (int i = 0; i < CMD_SRC_COUNT; i++) a->cfg[i] = cfg[i];
+}
+
+void cmd_arbiter_submit(cmd_arbiter_t *a, cmd_source_t src, int64_t now_us,
+                        int16_t left, int16_t right)
+{
+    if ((unsigned)src >= CMD_SRC_COUNT) return;
+    cmd_slot_t *s = &a->slot[src];
+
+    uint32_t seq = s->seq;
+    __atomic_store_n(&s->seq, seq + 1, __ATOMIC_RELAXED);       // odd: busy
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    s->value[0] = left;
+    s->value[1] = right;
+    s->stamp_us = now_us;
+    __atomic_store_n(&s->seq, seq + 2, __ATOMIC_RELEASE);       // even: done
+}
+
+void cmd_arbiter_expire(cmd_arbiter_t *a, cmd_source_t src, int64_t now_us)
+{
+    if ((unsigned)src >= CMD_SRC_COUNT) return;
+    /* a neutral command already as old as the timeout */
+    cmd_arbiter_submit(a, src, now_us - a->cfg[src].timeout_us, 0, 0);
+}
+
+static slot_read_t read_slot(cmd_arbiter_t *a, int i, cmd_snapshot_t *c)
+{
+    const cmd_slot_t *s = &a->slot[i];
+    for (int r = 0; r < ARB_READ_RETRIES; r++) {
+        uint32_t s1 = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+        if (s1 & 1) continue;
+        c->seq      = s1;
+        c->value[0] = s->value[0];
+        c->value[1] = s->value[1];
+        c->stamp_us = s->stamp_us;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&s->seq, __ATOMIC_RELAXED) == s1) {
+            return s1 ? SLOT_OK : SLOT_EMPTY;
+        }
+    }
+    a->stats.torn_reads++;
+    return SLOT_BUSY;
+}
+
+static inline bool is_neutral(const cmd_arbiter_t *a, const int16_t v[2])
+{
+    int16_t l = v[0] < 0 ? -v[0] : v[0];
+    int16_t r = v[1] < 0 ? -v[1] : v[1];
+    return l <= a->deadband && r <= a->deadband;
+}
+
+bool cmd_arbiter_select(cmd_arbiter_t *a, int64_t now_us, cmd_pick_t *out)
+{
+    cmd_snapshot_t c[CMD_SRC_COUNT];
+    uint32_t live = 0, claim = 0;
+
+    for (int i = 0; i < CMD_SRC_COUNT; i++) {
+        slot_read_t r = read_slot(a, i, &c[i]);
+        if (r == SLOT_BUSY && i == a->owner) {
+            c[i] = a->last;                     // writer mid‑update: keep the last
+        } else if (r != SLOT_OK) {
+            continue;                           // others get the next tick
+        }
+        if (now_us - c[i].stamp_us >= a->cfg[i].timeout_us) continue;
+        live |= 1u << i;
+        if (a->cfg[i].claim_neutral || !is_neutral(a, c[i].value)) claim |= 1u << i;
+    }
+
+    cmd_source_t owner = a->owner;
+
+    /* Owner resting at neutral long enough lets go */
+    if (owner != CMD_SRC_NONE && (live & (1u << owner)) && a->cfg[owner].release_us > 0) {
+        if (!is_neutral(a, c[owner].value)) {
+            a->neutral_since_us = 0;
+        } else if (a->neutral_since_us == 0) {
+            a->neutral_since_us = now_us;
+        } else if (now_us - a->neutral_since_us >= a->cfg[owner].release_us) {
+            live &= ~(1u << owner);
+        }
+    }
+
+    if (owner == CMD_SRC_NONE || !(live & (1u << owner))) {
+        owner = claim ? (cmd_source_t)__builtin_ctz(claim) : CMD_SRC_NONE;
+    } else {
+        uint32_t above = claim & ((1u << owner) - 1);          // higher priority
+        if (above) owner = (cmd_source_t)__builtin_ctz(above);
+    }
+
+    out->switched = owner != a->owner;
+    if (out->switched) {
+        cmd_arbiter_stats_t *st = &a->stats;
+        st->prev_owner = a->owner;
+        st->owner = owner;
+        st->switches++;
+        if (owner != CMD_SRC_NONE) {
+            int64_t lat = now_us - c[owner].stamp_us;
+            st->last_switch_us = lat > 0 ? (int32_t)lat : 0;
+            if (st->last_switch_us > st->max_switch_us) st->max_switch_us = st->last_switch_us;
+        }
+        st->last_handover_us = a->owner != CMD_SRC_NONE
+                             ? (int32_t)(now_us - a->last.stamp_us) : 0;
+        a->owner = owner;
+        a->last.seq = 0;
+        a->neutral_since_us = 0;
+    }
+
+    out->source = owner;
+    if (owner == CMD_SRC_NONE) {
+        out->value[0] = out->value[1] = 0;
+        out->stamp_us = 0;
+        out->fresh = false;
+        return false;
+    }
+
+    out->value[0] = c[owner].value[0];
+    out->value[1] = c[owner].value[1];
+    out->stamp_us = c[owner].stamp_us;
+    out->fresh    = c[owner].seq != a->last.seq;
+    a->last = c[owner];
+    return true;
+}
+
+const char *cmd_source_name(cmd_source_t src)
+{
+    static const char *const names[CMD_SRC_COUNT] = {
+        "attendant", "local", "mqtt", "http",
+    };
+    return (unsigned)src < CMD_SRC_COUNT ? names[src] : "none";
+}
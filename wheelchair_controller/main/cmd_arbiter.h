@@ -0,0 +1,122 @@
+/*=====================================================================
+ * cmd_arbiter.h — Drive command sources, one lock‑free slot each
+ *
+ *  • Every source (attendant, local joystick, MQTT, HTTP) writes its
+ *    newest command into its own slot under a sequence lock: writers
+ *    never block and never wait for the control tick, and one source's
+ *    traffic cannot keep another source's command alive.
+ *    One writer per source (the task that owns that input).
+ *  • The control tick calls cmd_arbiter_select() once: a fixed pass
+ *    over CMD_SRC_COUNT slots, each read retried a bounded number of
+ *    times — constant time in any context.
+ *  • Selection, slot order = priority (ATTENDANT highest):
+ *      – a source is LIVE while its newest command is younger than its
+ *        timeout;
+ *      – a live source CLAIMS when it is deflected beyond the deadband,
+ *        or always if claim_neutral is set (attendant, remote apps);
+ *      – the owner keeps control while live, unless a higher‑priority
+ *        source claims; a source with release_us > 0 (local joystick)
+ *        gives up ownership after resting at neutral that long, so a
+ *        released joystick still holds the chair before handing over;
+ *      – without an owner the highest‑priority claiming source wins.
+ *  • Each switch records its latency (tick − winning command's write
+ *    time) and the handover gap (tick − old owner's last command).
+ *
+ * Pure C, no ESP‑IDF dependencies; GCC atomics for the slot barriers.
+ *====================================================================*/
+
+#ifndef CMD_ARBITER_H
+#define CMD_ARBITER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    CMD_SRC_ATTENDANT = 0,      // override, e.g. an attendant's controls
+    CMD_SRC_LOCAL,              // wired joystick on the chair
+    CMD_SRC_MQTT,               // remote app
+    CMD_SRC_HTTP,               // /control on the local web server
+    CMD_SRC_COUNT,
+    CMD_SRC_NONE = -1,
+} cmd_source_t;
+
+typedef struct {
+    int32_t timeout_us;         // live while the newest command is younger
+    int32_t release_us;         // 0 = keep ownership while live
+    bool    claim_neutral;      // claim even at neutral
+} cmd_source_cfg_t;
+
+typedef struct {
+    volatile uint32_t seq;      // odd while being written, 0 = never
+    volatile int16_t  value[2]; // left, right (%)
+    volatile int64_t  stamp_us;
+} cmd_slot_t;
+
+typedef struct {
+    uint32_t seq;
+    int16_t  value[2];
+    int64_t  stamp_us;
+} cmd_snapshot_t;
+
+/** A selected command; @c fresh is set once per new command. */
+typedef struct {
+    cmd_source_t source;
+    int16_t      value[2];
+    int64_t      stamp_us;
+    bool         fresh;
+    bool         switched;      // owner changed this tick
+} cmd_pick_t;
+
+typedef struct {
+    cmd_source_t owner;
+    cmd_source_t prev_owner;
+    uint32_t     switches;
+    int32_t      last_switch_us;
+    int32_t      last_handover_us;
+    int32_t      max_switch_us;
+    uint32_t     torn_reads;    // slot busy on every retry
+} cmd_arbiter_stats_t;
+
+typedef struct {
+    cmd_slot_t       slot[CMD_SRC_COUNT];
+    cmd_source_cfg_t cfg[CMD_SRC_COUNT];
+    int16_t          deadband;
+
+    /* tick‑side state */
+    cmd_source_t     owner;
+    cmd_snapshot_t   last;              // owner's newest consumed command
+    int64_t          neutral_since_us;  // owner resting at neutral, 0 = no
+    cmd_arbiter_stats_t stats;
+} cmd_arbiter_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void cmd_arbiter_init(cmd_arbiter_t *a, const cmd_source_cfg_t cfg[CMD_SRC_COUNT],
+                      int16_t deadband);
+
+/** Publish a command from @p src (its single writer). */
+void cmd_arbiter_submit(cmd_arbiter_t *a, cmd_source_t src, int64_t now_us,
+                        int16_t left, int16_t right);
+
+/**
+ * Drop @p src's pending command so the source is no longer live (e.g.
+ * its link went down). Same single‑writer rule as cmd_arbiter_submit().
+ */
+void cmd_arbiter_expire(cmd_arbiter_t *a, cmd_source_t src, int64_t now_us);
+
+/**
+ * Pick the owner for this tick.
+ * @return false (source CMD_SRC_NONE) when no source owns the drive
+ */
+bool cmd_arbiter_select(cmd_arbiter_t *a, int64_t now_us, cmd_pick_t *out);
+
+/** Short lowercase name for logs and telemetry. */
+const char *cmd_source_name(cmd_source_t src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CMD_ARBITER_H */
@@ -0,0 +1,129 @@
+/*=====================================================================
+ * cmd_playout.c — Jitter estimation, hold/extrapolate, adaptive grace
+ *
+ * Integer‑only so it can run from the control tick in any context.
+ *====================================================================*/
+
+#include "cmd_playout.h"
+
+#define PLAYOUT_MEAN_SHIFT      3       // mean   += (gap − mean)   / 8
+#define PLAYOUT_JITTER_SHIFT    4       // jitter += (|d| − jitter) / 16
+#define PLAYOUT_PEAK_TAU_US     5000000 // peak decays with a 5 s time constant
+#define PLAYOUT_HOLD_JITTERS    2       // hold until mean + 2·jitter
+#define PLAYOUT_GRACE_JITTERS   4       // grace ≥ mean + 4·jitter
+
+void cmd_playout_init(cmd_playout_t *p, int32_t min_grace_us,
+                      int32_t max_grace_us, int32_t max_extrap_us)
+{
+    *p = (cmd_playout_t){
+        .min_grace_us  = min_grace_us,
+        .max_grace_us  = max_grace_us > min_grace_us ? max_grace_us : min_grace_us,
+        .max_extrap_us = max_extrap_us,
+    };
+}
+
+void cmd_playout_reset(cmd_playout_t *p)
+{
+    p->active      = false;
+    p->prev_gap_us = 0;
+    for (int i = 0; i < CMD_PLAYOUT_CHANNELS; i++) {
+        p->value[i] = 0;
+        p->prev[i]  = 0;
+    }
+}
+
+void cmd_playout_push(cmd_playout_t *p, int64_t now_us,
+                      int16_t left, int16_t right)
+{
+    int64_t gap = p->last_us ? now_us - p->last_us : 0;
+
+    /* Gaps longer than the longest grace are a new session, not jitter. */
+    if (gap > 0 && gap <= p->max_grace_us) {
+        int32_t g = (int32_t)gap;
+        if (p->mean_gap_us == 0) {
+            p->mean_gap_us = g;
+        } else {
+            int32_t d = g - p->mean_gap_us;
+            p->mean_gap_us += d >> PLAYOUT_MEAN_SHIFT;
+            int32_t ad = d < 0 ? -d : d;    // no libc call — may run from IRAM
+            p->jitter_us   += (ad - p->jitter_us) >> PLAYOUT_JITTER_SHIFT;
+        }
+        /* Decay per elapsed time, not per arrival: at a 4 Hz keepalive
+         * a per-arrival factor would hold a stall's peak for minutes. */
+        if (g > p->peak_gap_us) {
+            p->peak_gap_us = g;
+        } else {
+            int32_t dt = g < PLAYOUT_PEAK_TAU_US ? g : PLAYOUT_PEAK_TAU_US;
+            p->peak_gap_us -= (int32_t)((int64_t)(p->peak_gap_us - g) * dt / PLAYOUT_PEAK_TAU_US);
+        }
+        p->prev_gap_us = g;
+    } else {
+        p->prev_gap_us = 0;             // no usable trend
+    }
+
+    p->prev[0]  = p->value[0];
+    p->prev[1]  = p->value[1];
+    p->value[0] = left;
+    p->value[1] = right;
+    p->last_us  = now_us;
+    p->active   = true;
+    p->arrivals++;
+}
+
+int32_t cmd_playout_grace_us(const cmd_playout_t *p)
+{
+    /* Cover both steady jitter and the stalls seen recently. */
+    int32_t grace = p->mean_gap_us + PLAYOUT_GRACE_JITTERS * p->jitter_us;
+    int32_t peak  = p->peak_gap_us + p->mean_gap_us + 2 * p->jitter_us;
+    if (peak > grace) grace = peak;
+    if (grace < p->min_grace_us) grace = p->min_grace_us;
+    if (grace > p->max_grace_us) grace = p->max_grace_us;
+    return grace;
+}
+
+/* Linear extrapolation, clamped between 0 and the newest value. */
+static int16_t extrapolate(int16_t prev, int16_t cur, int32_t extra_us,
+                           int32_t gap_us)
+{
+    int32_t v = cur + (int32_t)((int64_t)(cur - prev) * extra_us / gap_us);
+    if (cur >= 0) {
+        if (v > cur) v = cur;
+        if (v < 0)   v = 0;
+    } else {
+        if (v < cur) v = cur;
+        if (v > 0)   v = 0;
+    }
+    return (int16_t)v;
+}
+
+bool cmd_playout_sample(cmd_playout_t *p, int64_t now_us,
+                        int16_t out[CMD_PLAYOUT_CHANNELS])
+{
+    if (!p->active) {
+        out[0] = out[1] = 0;
+        return false;
+    }
+
+    int64_t age = now_us - p->last_us;
+    if (age >= cmd_playout_grace_us(p)) {
+        p->expiries++;
+        cmd_playout_reset(p);
+        out[0] = out[1] = 0;
+        return false;
+    }
+
+    int64_t hold = (int64_t)p->mean_gap_us + PLAYOUT_HOLD_JITTERS * p->jitter_us;
+    if (age <= hold || p->prev_gap_us == 0 || p->max_extrap_us <= 0) {
+        out[0] = p->value[0];
+        out[1] = p->value[1];
+        return true;
+    }
+
+    int32_t extra = (int32_t)(age - hold);
+    if (extra > p->max_extrap_us) extra = p->max_extrap_us;
+    for (int i = 0; i < CMD_PLAYOUT_CHANNELS; i++) {
+        out[i] = extrapolate(p->prev[i], p->value[i], extra, p->prev_gap_us);
+    }
+    p->extrapolated_ticks++;
+    return true;
+}
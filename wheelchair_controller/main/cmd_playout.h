@@ -0,0 +1,86 @@
+/*=====================================================================
+ * cmd_playout.h — Adaptive playout stage for network motor commands
+ *
+ * Sits between command arrival and the control loop's target:
+ *  • Estimates the command inter‑arrival time and its jitter online
+ *    (EWMA, RFC 3550 style).
+ *  • Holds the newest command while the next one is "due", then
+ *    extrapolates the recent trend for a bounded time — only ever
+ *    towards zero, never beyond the last commanded magnitude.
+ *  • Derives the watchdog grace period from the observed jitter and
+ *    the recent worst gap (fast attack, decay over a few seconds
+ *    whatever the command rate), clamped to [min_grace, max_grace].
+ *
+ * Pure C, no ESP‑IDF dependencies: time is passed in by the caller so
+ * the same code runs in the host simulation (tools/host_sim).
+ * Not thread‑safe — the caller serialises push/sample.
+ *====================================================================*/
+
+#ifndef CMD_PLAYOUT_H
+#define CMD_PLAYOUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CMD_PLAYOUT_CHANNELS    2       /* left, right */
+
+typedef struct {
+    /* configuration */
+    int32_t  min_grace_us;
+    int32_t  max_grace_us;
+    int32_t  max_extrap_us;
+
+    /* arrival statistics */
+    int64_t  last_us;                   // arrival of newest command, 0 = none
+    bool     active;                    // false after expiry / reset
+    int32_t  mean_gap_us;               // EWMA inter‑arrival time, 0 = unknown
+    int32_t  jitter_us;                 // EWMA |gap − mean|
+    int32_t  peak_gap_us;               // decaying maximum gap
+    int32_t  prev_gap_us;               // spacing of the two newest, 0 = n/a
+
+    /* command history */
+    int16_t  value[CMD_PLAYOUT_CHANNELS];
+    int16_t  prev[CMD_PLAYOUT_CHANNELS];
+
+    /* counters */
+    uint32_t arrivals;
+    uint32_t extrapolated_ticks;
+    uint32_t expiries;
+} cmd_playout_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Reset statistics and history.
+ * @param min_grace_us   shortest watchdog grace period (normal decay time)
+ * @param max_grace_us   longest grace period allowed under heavy jitter
+ * @param max_extrap_us  how long past the expected arrival to extrapolate
+ */
+void cmd_playout_init(cmd_playout_t *p, int32_t min_grace_us,
+                      int32_t max_grace_us, int32_t max_extrap_us);
+
+/** Drop the current command (e.g. after an emergency stop); the
+ *  arrival statistics are kept. */
+void cmd_playout_reset(cmd_playout_t *p);
+
+/** Record a command that arrived at @p now_us. */
+void cmd_playout_push(cmd_playout_t *p, int64_t now_us,
+                      int16_t left, int16_t right);
+
+/**
+ * Compute the target for the control tick at @p now_us.
+ * @return false (and zeros in @p out) when the watchdog grace expired
+ */
+bool cmd_playout_sample(cmd_playout_t *p, int64_t now_us,
+                        int16_t out[CMD_PLAYOUT_CHANNELS]);
+
+/** Current adaptive watchdog grace period. */
+int32_t cmd_playout_grace_us(const cmd_playout_t *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CMD_PLAYOUT_H */
@@ -0,0 +1,145 @@
+/*=====================================================================
+ * cpu_profiler.c — Run‑time stats deltas → compact JSON report
+ *
+ * Payload (all shares in per‑mille of one core over the window):
+ *   {"t":<window ms>,"core":[<load0>,<load1>],
+ *    "tick":[<calls>,<avg us>,<max us>,<max late us>,<pwm errors>],
+ *    "tasks":[["<name>",<core|-1>,<share>],...]}
+ *====================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "motor_control.h"
+#include "mqtt_client_app.h"
+#include "mem_report.h"
+#include "cpu_profiler.h"
+
+static const char *TAG = "CPU_PROF";
+
+#if CONFIG_CPU_PROFILER
+
+#define PROF_MAX_TASKS      24
+#define PROF_STACK_BYTES    3072
+#define PROF_PAYLOAD_MAX    1024
+
+static TaskStatus_t g_snap[2][PROF_MAX_TASKS];   // previous / current
+static UBaseType_t  g_snap_count[2];
+static int          g_cur = 0;
+
+static char g_payload[PROF_PAYLOAD_MAX];
+
+static StackType_t  s_prof_stack[PROF_STACK_BYTES];
+static StaticTask_t s_prof_tcb;
+
+/* Run time of task @number in the previous snapshot (0 if new). */
+static configRUN_TIME_COUNTER_TYPE prev_runtime(UBaseType_t number)
+{
+    int prev = g_cur ^ 1;
+    for (UBaseType_t i = 0; i < g_snap_count[prev]; i++) {
+        if (g_snap[prev][i].xTaskNumber == number) {
+            return g_snap[prev][i].ulRunTimeCounter;
+        }
+    }
+    return 0;
+}
+
+static int build_report(uint32_t window_us, const motor_tick_stats_t *tick_delta)
+{
+    uint32_t idle_pm[2] = {1000, 1000};     // unknown → report 0 % load
+    int len = snprintf(g_payload, sizeof(g_payload), "{\"t\":%" PRIu32 ",",
+                       window_us / 1000);
+
+    len += snprintf(g_payload + len, sizeof(g_payload) - len, "\"tasks\":[");
+    if (len >= (int)sizeof(g_payload)) return -1;
+    for (UBaseType_t i = 0; i < g_snap_count[g_cur]; i++) {
+        const TaskStatus_t *t = &g_snap[g_cur][i];
+        uint32_t delta = t->ulRunTimeCounter - prev_runtime(t->xTaskNumber);
+        uint32_t pm = (uint32_t)((uint64_t)delta * 1000 / window_us);
+        BaseType_t core = xTaskGetCoreID(t->xHandle);
+        int core_out = (core == tskNO_AFFINITY) ? -1 : (int)core;
+
+        if (strncmp(t->pcTaskName, "IDLE", 4) == 0 && core_out >= 0 && core_out < 2) {
+            idle_pm[core_out] = pm;
+        }
+        len += snprintf(g_payload + len, sizeof(g_payload) - len,
+                        "%s[\"%s\",%d,%" PRIu32 "]", i ? "," : "",
+                        t->pcTaskName, core_out, pm);
+        if (len >= (int)sizeof(g_payload)) return -1;
+    }
+    len += snprintf(g_payload + len, sizeof(g_payload) - len, "],");
+    if (len >= (int)sizeof(g_payload)) return -1;   // size_t below must not wrap
+
+    uint32_t avg = tick_delta->ticks ? (uint32_t)(tick_delta->total_us / tick_delta->ticks) : 0;
+    len += snprintf(g_payload + len, sizeof(g_payload) - len,
+                    "\"core\":[%" PRIu32 ",%" PRIu32 "],"
+                    "\"tick\":[%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 "]}",
+                    idle_pm[0] > 1000 ? 0 : 1000 - idle_pm[0],
+                    idle_pm[1] > 1000 ? 0 : 1000 - idle_pm[1],
+                    tick_delta->ticks, avg, tick_delta->max_us,
+                    tick_delta->max_late_us, tick_delta->pwm_errors);
+    return len < (int)sizeof(g_payload) ? len : -1;
+}
+
+static void cpu_profiler_task(void *arg)
+{
+    motor_tick_stats_t prev_tick = {0};
+    configRUN_TIME_COUNTER_TYPE total_prev = 0;
+
+    g_snap_count[g_cur] = uxTaskGetSystemState(g_snap[g_cur], PROF_MAX_TASKS, &total_prev);
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_CPU_PROFILER_PERIOD_MS));
+
+        g_cur ^= 1;
+        configRUN_TIME_COUNTER_TYPE total_now = 0;
+        g_snap_count[g_cur] = uxTaskGetSystemState(g_snap[g_cur], PROF_MAX_TASKS, &total_now);
+        if (g_snap_count[g_cur] == 0) {
+            ESP_LOGW(TAG, "More than %d tasks, increase PROF_MAX_TASKS", PROF_MAX_TASKS);
+            continue;
+        }
+        uint32_t window_us = total_now - total_prev;
+        total_prev = total_now;
+        if (window_us == 0) continue;
+
+        motor_tick_stats_t tick, tick_delta;
+        motor_get_tick_stats(&tick);
+        tick_delta.ticks    = tick.ticks - prev_tick.ticks;
+        tick_delta.total_us = tick.total_us - prev_tick.total_us;
+        tick_delta.max_us   = tick.max_us;          // worst since boot
+        tick_delta.max_late_us = tick.max_late_us;
+        tick_delta.pwm_errors  = tick.pwm_errors - prev_tick.pwm_errors;
+        prev_tick = tick;
+
+        int len = build_report(window_us, &tick_delta);
+        if (len < 0) {
+            ESP_LOGW(TAG, "Report truncated");
+            continue;
+        }
+        ESP_LOGI(TAG, "%s", g_payload);
+        mqtt_app_publish(MQTT_DIAG_CPU_TOPIC, g_payload, len, 0);
+    }
+}
+
+void cpu_profiler_init(void)
+{
+    TaskHandle_t h = xTaskCreateStatic(cpu_profiler_task, "cpu_prof",
+                                       PROF_STACK_BYTES, NULL,
+                                       tskIDLE_PRIORITY + 1,
+                                       s_prof_stack, &s_prof_tcb);
+    mem_report_register_task(h, PROF_STACK_BYTES);
+}
+
+#else  /* !CONFIG_CPU_PROFILER */
+
+void cpu_profiler_init(void)
+{
+    ESP_LOGI(TAG, "CPU profiler disabled (CONFIG_CPU_PROFILER)");
+}
+
+#endif /* CONFIG_CPU_PROFILER */
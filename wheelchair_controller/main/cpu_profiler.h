@@ -0,0 +1,32 @@
+/*=====================================================================
+ * cpu_profiler.h — Periodic per‑task CPU usage report
+ *
+ * Samples FreeRTOS run‑time statistics every
+ * CONFIG_CPU_PROFILER_PERIOD_MS and reports, for that window:
+ *  • load per core (100 % − the core's IDLE task share)
+ *  • CPU share of every task and the core it is pinned to ('*' = any)
+ *  • calls, average and worst time and worst start delay of the
+ *    motor control tick
+ *
+ * The report is one compact JSON object, logged on serial (tag
+ * CPU_PROF) and published on MQTT_DIAG_CPU_TOPIC; render either with
+ * tools/cpu_report.py.
+ *====================================================================*/
+
+#ifndef CPU_PROFILER_H
+#define CPU_PROFILER_H
+
+#define MQTT_DIAG_CPU_TOPIC     "wheelchair/diag/cpu"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Start the profiler task (no‑op unless CONFIG_CPU_PROFILER is set). */
+void cpu_profiler_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CPU_PROFILER_H */
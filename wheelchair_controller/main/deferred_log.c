@@ -0,0 +1,185 @@
+/*=====================================================================
+ * deferred_log.c — Lock‑free ring + formatter task for DLOGx()
+ *
+ *  • Producers (any task) claim a slot with one CAS on the head index
+ *    and publish it through the slot's sequence number (bounded MPSC
+ *    queue, Vyukov style).  No locks, no allocation, no formatting.
+ *  • A single low‑priority task drains the ring every
+ *    DLOG_DRAIN_PERIOD_MS and hands the records to esp_log_write().
+ *====================================================================*/
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "deferred_log.h"
+#include "mem_report.h"
+
+static const char *TAG = "DLOG";
+
+_Static_assert((DLOG_RING_SIZE & (DLOG_RING_SIZE - 1)) == 0,
+               "DLOG_RING_SIZE must be a power of 2");
+
+#define DLOG_RING_MASK      (DLOG_RING_SIZE - 1)
+#define DLOG_LINE_MAX       128
+#define DLOG_STACK_BYTES    3072    // as before static allocation; trim from mem_report
+
+/*---------------------------------------------------------------------
+ * Ring storage
+ *-------------------------------------------------------------------*/
+typedef struct {
+    atomic_uint  seq;                   // publication sequence
+    uint32_t     timestamp_ms;
+    const char  *tag;
+    const char  *fmt;                   // acts as the format ID
+    uint8_t      level;
+    uint8_t      nargs;
+    int32_t      args[DLOG_MAX_ARGS];
+} dlog_record_t;
+
+/* All zero at boot and ready to use: a slot stores its sequence minus
+ * its index, so the initial "slot i is free for position i" needs no
+ * init code and records written before the task starts are kept. */
+static dlog_record_t g_ring[DLOG_RING_SIZE];
+static atomic_uint   g_head;            // next slot to claim (producers)
+static unsigned      g_tail;            // next slot to read  (formatter)
+static atomic_uint   g_dropped;
+
+static StackType_t  s_dlog_stack[DLOG_STACK_BYTES];
+static StaticTask_t s_dlog_tcb;
+
+static void deferred_log_task(void *arg);
+
+/*=====================================================================
+ * Public API implementation
+ *====================================================================*/
+
+/* Slot sequence numbers, stored relative to the slot index. Forced
+ * inline: deferred_log_write runs from IRAM (linker.lf). */
+FORCE_INLINE_ATTR unsigned slot_seq(unsigned pos, memory_order mo)
+{
+    unsigned idx = pos & DLOG_RING_MASK;
+    return atomic_load_explicit(&g_ring[idx].seq, mo) + idx;
+}
+
+FORCE_INLINE_ATTR void slot_set_seq(unsigned pos, unsigned seq, memory_order mo)
+{
+    unsigned idx = pos & DLOG_RING_MASK;
+    atomic_store_explicit(&g_ring[idx].seq, seq - idx, mo);
+}
+
+void deferred_log_init(void)
+{
+    TaskHandle_t h = xTaskCreateStatic(deferred_log_task, "dlog",
+                                       DLOG_STACK_BYTES, NULL,
+                                       tskIDLE_PRIORITY + 1,
+                                       s_dlog_stack, &s_dlog_tcb);
+    mem_report_register_task(h, DLOG_STACK_BYTES);
+}
+
+void deferred_log_write(esp_log_level_t level, const char *tag,
+                        const char *fmt, uint32_t nargs, const int32_t *args)
+{
+    unsigned pos = atomic_load_explicit(&g_head, memory_order_relaxed);
+    dlog_record_t *rec;
+    for (;;) {
+        rec = &g_ring[pos & DLOG_RING_MASK];
+        unsigned seq = slot_seq(pos, memory_order_acquire);
+        int diff = (int)(seq - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&g_head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&g_dropped, 1, memory_order_relaxed);
+            return;                     // ring full
+        } else {
+            pos = atomic_load_explicit(&g_head, memory_order_relaxed);
+        }
+    }
+
+    if (nargs > DLOG_MAX_ARGS) nargs = DLOG_MAX_ARGS;
+    rec->timestamp_ms = esp_log_timestamp();
+    rec->tag   = tag;
+    rec->fmt   = fmt;
+    rec->level = (uint8_t)level;
+    rec->nargs = (uint8_t)nargs;
+    for (uint32_t i = 0; i < nargs; i++) {
+        rec->args[i] = args[i];
+    }
+    slot_set_seq(pos, pos + 1, memory_order_release);
+}
+
+uint32_t deferred_log_dropped(void)
+{
+    return atomic_load_explicit(&g_dropped, memory_order_relaxed);
+}
+
+/*=====================================================================
+ * Formatter task
+ *====================================================================*/
+
+static char level_letter(esp_log_level_t level)
+{
+    switch (level) {
+    case ESP_LOG_ERROR:   return 'E';
+    case ESP_LOG_WARN:    return 'W';
+    case ESP_LOG_INFO:    return 'I';
+    case ESP_LOG_DEBUG:   return 'D';
+    default:              return 'V';
+    }
+}
+
+/* Pop and print one record; false when the ring is empty. */
+static bool drain_one(void)
+{
+    dlog_record_t *rec = &g_ring[g_tail & DLOG_RING_MASK];
+    unsigned seq = slot_seq(g_tail, memory_order_acquire);
+    if (seq != g_tail + 1) {
+        return false;
+    }
+
+    /* Unused slots are zero, so passing all of them is harmless. */
+    int32_t a[DLOG_MAX_ARGS] = {0};
+    for (unsigned i = 0; i < rec->nargs; i++) a[i] = rec->args[i];
+    _Static_assert(DLOG_MAX_ARGS == 4, "update the snprintf call below");
+
+    char line[DLOG_LINE_MAX];
+    snprintf(line, sizeof(line), rec->fmt, a[0], a[1], a[2], a[3]);
+
+    esp_log_level_t level = (esp_log_level_t)rec->level;
+    uint32_t ts  = rec->timestamp_ms;
+    const char *tag = rec->tag;
+
+    /* Release the slot before the (slow) UART write. */
+    slot_set_seq(g_tail, g_tail + DLOG_RING_SIZE, memory_order_release);
+    g_tail++;
+
+    esp_log_write(level, tag, "%c (%" PRIu32 ") %s: %s\n",
+                  level_letter(level), ts, tag, line);
+    return true;
+}
+
+static void deferred_log_task(void *arg)
+{
+    uint32_t reported_drops = 0;
+
+    while (1) {
+        while (drain_one()) {
+        }
+
+        uint32_t drops = deferred_log_dropped();
+        if (drops != reported_drops) {
+            ESP_LOGW(TAG, "%" PRIu32 " deferred log records dropped",
+                     drops - reported_drops);
+            reported_drops = drops;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(DLOG_DRAIN_PERIOD_MS));
+    }
+}
@@ -0,0 +1,75 @@
+/*=====================================================================
+ * deferred_log.h — Binary deferred logging for hot paths
+ *
+ * DLOGx() stores a pointer to the (flash‑resident) format string plus
+ * up to DLOG_MAX_ARGS integer arguments in a lock‑free ring.  A
+ * low‑priority task formats and prints the records later, so the
+ * caller pays for a few stores instead of printf + UART output.
+ *
+ * Only integer arguments are supported — pointers to transient data
+ * (e.g. "%.*s" on an MQTT topic) must keep using ESP_LOGx.
+ *====================================================================*/
+
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+#include <stdint.h>
+#include "esp_log.h"
+
+/*---------------------------------------------------------------------
+ * Configuration (may be overridden before include)
+ *-------------------------------------------------------------------*/
+#ifndef DLOG_RING_SIZE
+#define DLOG_RING_SIZE          64    /* records, must be a power of 2 */
+#endif
+#ifndef DLOG_MAX_ARGS
+#define DLOG_MAX_ARGS           4
+#endif
+#ifndef DLOG_DRAIN_PERIOD_MS
+#define DLOG_DRAIN_PERIOD_MS    50    /* formatter task wake‑up period */
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Start the formatter task. The ring works from boot: records written
+ *  before this are kept (up to DLOG_RING_SIZE, the rest dropped and
+ *  counted) and printed once the task runs. */
+void deferred_log_init(void);
+
+/**
+ * Queue one record. Never blocks; drops (and counts) the record when
+ * the ring is full. Use the DLOGx() macros instead of calling this.
+ */
+void deferred_log_write(esp_log_level_t level, const char *tag,
+                        const char *fmt, uint32_t nargs, const int32_t *args);
+
+/** Number of records dropped because the ring was full. */
+uint32_t deferred_log_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*---------------------------------------------------------------------
+ * Logging macros — same shape as ESP_LOGx, integer arguments only
+ *-------------------------------------------------------------------*/
+#define DLOG_LEVEL(level, tag, fmt, ...) do {                              \
+        if (LOG_LOCAL_LEVEL >= (level)) {                                  \
+            const int32_t _dlog_a[] = { 0, ##__VA_ARGS__ };                \
+            _Static_assert(sizeof(_dlog_a) / sizeof(_dlog_a[0]) - 1        \
+                           <= DLOG_MAX_ARGS, "too many DLOG arguments");   \
+            deferred_log_write((level), (tag), (fmt),                      \
+                               sizeof(_dlog_a) / sizeof(_dlog_a[0]) - 1,   \
+                               &_dlog_a[1]);                               \
+        }                                                                  \
+    } while (0)
+
+#define DLOGE(tag, fmt, ...) DLOG_LEVEL(ESP_LOG_ERROR,   tag, fmt, ##__VA_ARGS__)
+#define DLOGW(tag, fmt, ...) DLOG_LEVEL(ESP_LOG_WARN,    tag, fmt, ##__VA_ARGS__)
+#define DLOGI(tag, fmt, ...) DLOG_LEVEL(ESP_LOG_INFO,    tag, fmt, ##__VA_ARGS__)
+#define DLOGD(tag, fmt, ...) DLOG_LEVEL(ESP_LOG_DEBUG,   tag, fmt, ##__VA_ARGS__)
+#define DLOGV(tag, fmt, ...) DLOG_LEVEL(ESP_LOG_VERBOSE, tag, fmt, ##__VA_ARGS__)
+
+#endif /* DEFERRED_LOG_H */
@@ -69,6 +69,11 @@ void parse_env_file(void) {
         return;
     }
 
+    parse_env_stream(f);
+    fclose(f);
+}
+
+void parse_env_stream(FILE *f) {
     char line[MAX_KEY_LEN + MAX_VAL_LEN + 2];
     while (fgets(line, sizeof(line), f)) {
         char *key = strtok(line, "=");
@@ -93,8 +98,6 @@ void parse_env_file(void) {
             }
         }
     }
-
-    fclose(f);
 }
 
 const char *get_env_value(const char *key) {
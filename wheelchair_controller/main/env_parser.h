@@ -1,7 +1,10 @@
 #ifndef ENV_PARSER_H
 #define ENV_PARSER_H
 
+#include <stdio.h>
+
 void parse_env_file(void);
+void parse_env_stream(FILE *f); // KEY=value lines, appended to the table
 const char *get_env_value(const char *key);
 
 #endif // ENV_PARSER_H
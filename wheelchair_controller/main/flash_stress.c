@@ -0,0 +1,83 @@
+/*=====================================================================
+ * flash_stress.c — Back‑to‑back NVS commits + tick latency report
+ *====================================================================*/
+
+#include <inttypes.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "motor_control.h"
+#include "mem_report.h"
+#include "flash_stress.h"
+
+static const char *TAG = "FLASH_STRESS";
+
+#if CONFIG_FLASH_STRESS_TEST
+
+#define STRESS_STACK_BYTES      3072
+#define STRESS_BLOB_BYTES       512     // > one NVS page entry span
+#define STRESS_REPORT_MS        5000
+
+#if CONFIG_MOTOR_CONTROL_IN_IRAM
+#define STRESS_TICK_MODE        "IRAM/ISR"
+#else
+#define STRESS_TICK_MODE        "flash/task"
+#endif
+
+static StackType_t  s_stress_stack[STRESS_STACK_BYTES];
+static StaticTask_t s_stress_tcb;
+static uint8_t      s_blob[STRESS_BLOB_BYTES];
+
+static void flash_stress_task(void *arg)
+{
+    nvs_handle_t nvs;
+    if (nvs_open("stress", NVS_READWRITE, &nvs) != ESP_OK) {
+        ESP_LOGE(TAG, "nvs_open failed");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    uint32_t commits = 0, errors = 0;
+    int64_t next_report = esp_timer_get_time() + STRESS_REPORT_MS * 1000;
+
+    while (1) {
+        memset(s_blob, (int)(commits & 0xFF), sizeof(s_blob));
+        if (nvs_set_blob(nvs, "blob", s_blob, sizeof(s_blob)) != ESP_OK ||
+            nvs_commit(nvs) != ESP_OK) {
+            errors++;
+        }
+        commits++;
+
+        int64_t now = esp_timer_get_time();
+        if (now >= next_report) {
+            motor_tick_stats_t st;
+            motor_get_tick_stats(&st);
+            ESP_LOGI(TAG, "%" PRIu32 " commits (%" PRIu32 " failed); tick max exec %" PRIu32
+                     " us, max late %" PRIu32 " us, %" PRIu32 " PWM errors (%s)",
+                     commits, errors, st.max_us, st.max_late_us, st.pwm_errors,
+                     STRESS_TICK_MODE);
+            next_report = now + STRESS_REPORT_MS * 1000;
+        }
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_FLASH_STRESS_PERIOD_MS));
+    }
+}
+
+void flash_stress_init(void)
+{
+    ESP_LOGW(TAG, "NVS stress test running — wears flash, do not ship");
+    TaskHandle_t h = xTaskCreateStatic(flash_stress_task, "flash_stress",
+                                       STRESS_STACK_BYTES, NULL,
+                                       tskIDLE_PRIORITY + 2,
+                                       s_stress_stack, &s_stress_tcb);
+    mem_report_register_task(h, STRESS_STACK_BYTES);
+}
+
+#else  /* !CONFIG_FLASH_STRESS_TEST */
+
+void flash_stress_init(void) {}
+
+#endif /* CONFIG_FLASH_STRESS_TEST */
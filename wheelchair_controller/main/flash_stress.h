@@ -0,0 +1,25 @@
+/*=====================================================================
+ * flash_stress.h — NVS write hammer for control‑tick latency tests
+ *
+ * Test‑only.  Commits a blob to NVS back to back (each commit erases
+ * and writes flash with the cache disabled) and logs the motor tick's
+ * worst execution time and worst start delay every few seconds.
+ * Compare a build with CONFIG_MOTOR_CONTROL_IN_IRAM against one
+ * without it.
+ *====================================================================*/
+
+#ifndef FLASH_STRESS_H
+#define FLASH_STRESS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Start the stress task (no‑op unless CONFIG_FLASH_STRESS_TEST is set). */
+void flash_stress_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FLASH_STRESS_H */
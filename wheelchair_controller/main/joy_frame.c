@@ -0,0 +1,162 @@
+/*=====================================================================
+ * joy_frame.c — Wired joystick frame encoder and streaming parser
+ *====================================================================*/
+
+#include <string.h>
+#include "joy_frame.h"
+
+#define HDR_LEN     5       /* sync×2, len, seq, type */
+
+uint16_t joy_crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16_t)*data++ << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+size_t joy_frame_encode(uint8_t *buf, size_t size, uint8_t seq, uint8_t type,
+                        const uint8_t *payload, uint8_t len)
+{
+    size_t total = (size_t)JOY_OVERHEAD + len;
+    if (len > JOY_MAX_PAYLOAD || size < total) return 0;
+
+    buf[0] = JOY_SYNC0;
+    buf[1] = JOY_SYNC1;
+    buf[2] = len;
+    buf[3] = seq;
+    buf[4] = type;
+    if (len) memcpy(&buf[HDR_LEN], payload, len);
+    uint16_t crc = joy_crc16(&buf[2], 3u + len);
+    buf[HDR_LEN + len]     = (uint8_t)(crc & 0xFF);
+    buf[HDR_LEN + len + 1] = (uint8_t)(crc >> 8);
+    return total;
+}
+
+static int8_t clip100(int v)
+{
+    return (int8_t)(v > 100 ? 100 : (v < -100 ? -100 : v));
+}
+
+size_t joy_frame_encode_drive(uint8_t *buf, size_t size, uint8_t seq,
+                              int left, int right)
+{
+    const uint8_t payload[JOY_DRIVE_LEN] = {
+        (uint8_t)clip100(left), (uint8_t)clip100(right), 0,
+    };
+    return joy_frame_encode(buf, size, seq, JOY_TYPE_DRIVE, payload, JOY_DRIVE_LEN);
+}
+
+bool joy_frame_drive(const joy_frame_t *f, int *left, int *right)
+{
+    if (f->type != JOY_TYPE_DRIVE || f->len < JOY_DRIVE_LEN) return false;
+    *left  = clip100((int8_t)f->payload[0]);
+    *right = clip100((int8_t)f->payload[1]);
+    return true;
+}
+
+size_t joy_frame_encode_twist(uint8_t *buf, size_t size, uint8_t seq,
+                              int v, int w)
+{
+    const uint8_t payload[JOY_TWIST_LEN] = {
+        (uint8_t)clip100(v), (uint8_t)clip100(w), 0,
+    };
+    return joy_frame_encode(buf, size, seq, JOY_TYPE_TWIST, payload, JOY_TWIST_LEN);
+}
+
+bool joy_frame_twist(const joy_frame_t *f, int *v, int *w)
+{
+    if (f->type != JOY_TYPE_TWIST || f->len < JOY_TWIST_LEN) return false;
+    *v = clip100((int8_t)f->payload[0]);
+    *w = clip100((int8_t)f->payload[1]);
+    return true;
+}
+
+void joy_parser_init(joy_parser_t *p)
+{
+    memset(p, 0, sizeof(*p));
+}
+
+void joy_parser_reset(joy_parser_t *p)
+{
+    p->pos = 0;
+    p->need = 0;
+}
+
+/* Drop the first byte of the buffered candidate and rescan the rest
+ * for a sync pair, so a frame starting inside a bad one is not lost. */
+static void resync(joy_parser_t *p)
+{
+    uint8_t i = 1;
+    while (i < p->pos && !(p->buf[i] == JOY_SYNC0 &&
+                           (i + 1 == p->pos || p->buf[i + 1] == JOY_SYNC1))) {
+        i++;
+    }
+    p->resyncs += i;
+    memmove(p->buf, &p->buf[i], p->pos - i);
+    p->pos -= i;
+    p->need = 0;
+}
+
+static void deliver(joy_parser_t *p, joy_frame_cb_t cb, void *ctx)
+{
+    joy_frame_t f = {
+        .len  = p->buf[2],
+        .seq  = p->buf[3],
+        .type = p->buf[4],
+    };
+    memcpy(f.payload, &p->buf[HDR_LEN], f.len);
+
+    if (p->have_seq) {
+        uint8_t gap = (uint8_t)(f.seq - p->last_seq);
+        if (gap == 0) {
+            p->duplicates++;
+            return;
+        }
+        p->lost += gap - 1u;
+    }
+    p->have_seq = true;
+    p->last_seq = f.seq;
+    p->frames++;
+    if (cb) cb(&f, ctx);
+}
+
+void joy_parser_feed(joy_parser_t *p, const uint8_t *data, size_t len,
+                     joy_frame_cb_t cb, void *ctx)
+{
+    while (len--) {
+        p->buf[p->pos++] = *data++;
+
+        /* resync can leave a complete candidate buffered: re‑check */
+        while (p->pos) {
+            if (p->buf[0] != JOY_SYNC0 || (p->pos >= 2 && p->buf[1] != JOY_SYNC1)) {
+                resync(p);
+                continue;
+            }
+            if (p->pos < 3) break;
+            if (p->buf[2] > JOY_MAX_PAYLOAD) {
+                resync(p);
+                continue;
+            }
+            p->need = (uint8_t)(JOY_OVERHEAD + p->buf[2]);
+            if (p->pos < p->need) break;
+
+            uint16_t crc = joy_crc16(&p->buf[2], 3u + p->buf[2]);
+            uint16_t got = (uint16_t)(p->buf[p->need - 2] | (p->buf[p->need - 1] << 8));
+            if (crc != got) {
+                p->crc_errors++;
+                resync(p);
+                continue;
+            }
+            deliver(p, cb, ctx);
+            uint8_t rest = (uint8_t)(p->pos - p->need);
+            memmove(p->buf, &p->buf[p->need], rest);
+            p->pos = rest;
+            p->need = 0;
+        }
+    }
+}
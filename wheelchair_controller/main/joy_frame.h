@@ -0,0 +1,104 @@
+/*=====================================================================
+ * joy_frame.h — Binary frames of the wired joystick link
+ *
+ *   A5 5A | len | seq | type | payload[len] | crc16 (LE)
+ *
+ *  • crc16: CRC‑16/CCITT‑FALSE (poly 0x1021, init 0xFFFF) over
+ *    len, seq, type and the payload.
+ *  • seq increments per frame (mod 256); gaps count as lost frames,
+ *    a repeated seq is dropped as a duplicate.
+ *  • JOY_TYPE_DRIVE payload: int8 left, int8 right (−100 … +100),
+ *    uint8 flags (reserved, 0) — 10 bytes on the wire per command
+ *    against ~25 for the MQTT JSON payload alone.
+ *  • JOY_TYPE_TWIST payload: int8 v, int8 w (−100 … +100), uint8
+ *    flags (reserved, 0) — mixed on the controller (motor_control.h).
+ *  • The parser resynchronises on the sync bytes after noise, a bad
+ *    CRC or an oversize length, without losing a following frame.
+ *
+ * Pure C, no ESP‑IDF dependencies; shared with tools/wired_joy.
+ *====================================================================*/
+
+#ifndef JOY_FRAME_H
+#define JOY_FRAME_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define JOY_SYNC0               0xA5
+#define JOY_SYNC1               0x5A
+#define JOY_MAX_PAYLOAD         16
+#define JOY_OVERHEAD            7       /* sync×2, len, seq, type, crc×2 */
+#define JOY_FRAME_MAX           (JOY_OVERHEAD + JOY_MAX_PAYLOAD)
+
+#define JOY_TYPE_DRIVE          0x01
+#define JOY_DRIVE_LEN           3
+#define JOY_TYPE_TWIST          0x02
+#define JOY_TWIST_LEN           3
+
+typedef struct {
+    uint8_t seq;
+    uint8_t type;
+    uint8_t len;
+    uint8_t payload[JOY_MAX_PAYLOAD];
+} joy_frame_t;
+
+typedef void (*joy_frame_cb_t)(const joy_frame_t *f, void *ctx);
+
+typedef struct {
+    /* receive state */
+    uint8_t  buf[JOY_FRAME_MAX];
+    uint8_t  pos;
+    uint8_t  need;                      // total length once len is known
+    bool     have_seq;
+    uint8_t  last_seq;
+
+    /* counters */
+    uint32_t frames;
+    uint32_t crc_errors;
+    uint32_t resyncs;                   // bytes skipped hunting for sync
+    uint32_t lost;                      // seq gaps
+    uint32_t duplicates;
+} joy_parser_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint16_t joy_crc16(const uint8_t *data, size_t len);
+
+/**
+ * Encode a frame into @p buf.
+ * @return frame length, or 0 if @p len exceeds JOY_MAX_PAYLOAD or @p size
+ */
+size_t joy_frame_encode(uint8_t *buf, size_t size, uint8_t seq, uint8_t type,
+                        const uint8_t *payload, uint8_t len);
+
+/** Encode a JOY_TYPE_DRIVE frame (values clipped to ±100). */
+size_t joy_frame_encode_drive(uint8_t *buf, size_t size, uint8_t seq,
+                              int left, int right);
+
+/** Decode a JOY_TYPE_DRIVE payload. */
+bool joy_frame_drive(const joy_frame_t *f, int *left, int *right);
+
+/** Encode a JOY_TYPE_TWIST frame (values clipped to ±100). */
+size_t joy_frame_encode_twist(uint8_t *buf, size_t size, uint8_t seq,
+                              int v, int w);
+
+/** Decode a JOY_TYPE_TWIST payload. */
+bool joy_frame_twist(const joy_frame_t *f, int *v, int *w);
+
+void joy_parser_init(joy_parser_t *p);
+
+/** Drop a partial frame (e.g. after an RX overflow); counters are kept. */
+void joy_parser_reset(joy_parser_t *p);
+
+/** Feed received bytes; @p cb runs for every valid, non‑duplicate frame. */
+void joy_parser_feed(joy_parser_t *p, const uint8_t *data, size_t len,
+                     joy_frame_cb_t cb, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JOY_FRAME_H */
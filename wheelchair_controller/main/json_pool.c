@@ -0,0 +1,64 @@
+/*=====================================================================
+ * json_pool.c — Bump arena with automatic rewind for cJSON
+ *====================================================================*/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "cJSON.h"
+#include "json_pool.h"
+
+#define JSON_POOL_ALIGN     8
+
+static uint8_t  g_arena[JSON_POOL_ARENA_BYTES] __attribute__((aligned(JSON_POOL_ALIGN)));
+static size_t   g_offset = 0;           // next free byte in g_arena
+static uint32_t g_live   = 0;           // arena blocks not yet freed
+static json_pool_stats_t g_stats;
+
+static void *json_pool_malloc(size_t size)
+{
+    size_t need = (size + JSON_POOL_ALIGN - 1) & ~(size_t)(JSON_POOL_ALIGN - 1);
+    if (need <= sizeof(g_arena) - g_offset) {
+        void *p = &g_arena[g_offset];
+        g_offset += need;
+        g_live++;
+        g_stats.arena_allocs++;
+        if (g_offset > g_stats.high_water_bytes) {
+            g_stats.high_water_bytes = g_offset;
+        }
+        return p;
+    }
+
+    void *p = malloc(size);
+    if (p) g_stats.heap_allocs++;
+    return p;
+}
+
+static void json_pool_free(void *ptr)
+{
+    if (ptr == NULL) return;
+
+    uint8_t *p = ptr;
+    if (p >= g_arena && p < g_arena + sizeof(g_arena)) {
+        if (g_live > 0 && --g_live == 0) {
+            g_offset = 0;               // everything released — rewind
+        }
+        return;
+    }
+
+    g_stats.heap_frees++;
+    free(ptr);
+}
+
+void json_pool_init(void)
+{
+    cJSON_Hooks hooks = {
+        .malloc_fn = json_pool_malloc,
+        .free_fn   = json_pool_free,
+    };
+    cJSON_InitHooks(&hooks);
+}
+
+void json_pool_get_stats(json_pool_stats_t *out)
+{
+    if (out) *out = g_stats;
+}
@@ -0,0 +1,44 @@
+/*=====================================================================
+ * json_pool.h — Static arena behind cJSON's allocator hooks
+ *
+ * cJSON allocates a node per value and a buffer per string.  Routing
+ * those requests into a fixed arena keeps heap usage flat while the
+ * controller is parsing commands.  The arena rewinds automatically
+ * once every block handed out has been freed (i.e. after cJSON_Delete
+ * of the last live tree); requests that do not fit fall back to the
+ * heap and are counted.
+ *
+ * Not thread‑safe: all cJSON use must stay in one task (the MQTT task).
+ *====================================================================*/
+
+#ifndef JSON_POOL_H
+#define JSON_POOL_H
+
+#include <stdint.h>
+
+#ifndef JSON_POOL_ARENA_BYTES
+#define JSON_POOL_ARENA_BYTES   2048
+#endif
+
+typedef struct {
+    uint32_t arena_allocs;      // requests served from the arena
+    uint32_t heap_allocs;       // requests that fell back to malloc()
+    uint32_t heap_frees;
+    uint32_t high_water_bytes;  // peak arena usage since boot
+} json_pool_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Install the arena as cJSON's allocator. Call before any cJSON use. */
+void json_pool_init(void);
+
+/** Snapshot the allocation counters (since boot). */
+void json_pool_get_stats(json_pool_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSON_POOL_H */
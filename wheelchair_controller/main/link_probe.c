@@ -0,0 +1,315 @@
+/*=====================================================================
+ * link_probe.c — Probe task, echo handlers, quality evaluation
+ *====================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "link_probe.h"
+
+static const char *TAG = "LINK_PROBE";
+
+#if CONFIG_LINK_PROBE
+
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "cJSON.h"
+#include "motor_control.h"
+#include "mqtt_client_app.h"
+#include "mem_report.h"
+#include "link_stats.h"
+
+#define PROBE_STACK_BYTES   3072
+#define PROBE_PENDING       8           // outstanding probes tracked
+#define PROBE_REPORT_EVERY  10          // periods per metrics publish
+#define PROBE_MIN_SAMPLES   8           // before loss/p99 can degrade
+#define PROBE_IDLE_PERIODS  4           // no echo this long past the timeout: peer gone
+#define PROBE_PAYLOAD_MAX   320
+
+typedef struct {
+    uint32_t id;
+    uint32_t sent_ms;
+    bool     active;
+} pending_t;
+
+static portMUX_TYPE   s_lock = portMUX_INITIALIZER_UNLOCKED;
+static pending_t      s_pending[PROBE_PENDING];
+static link_stats_t   s_stats;
+static link_quality_t s_quality;
+static bool           s_have_echo = false;
+static uint32_t       s_last_echo_ms;
+static uint16_t       s_suspect;        // timed out, lost only if the peer answers again
+
+static link_probe_cb_t s_cbs[LINK_PROBE_MAX_CALLBACKS];
+static void           *s_cb_ctx[LINK_PROBE_MAX_CALLBACKS];
+static int             s_cb_count = 0;
+
+static char s_payload[PROBE_PAYLOAD_MAX];
+
+static StackType_t  s_probe_stack[PROBE_STACK_BYTES];
+static StaticTask_t s_probe_tcb;
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+/* -------- MQTT handlers (MQTT event task) -------------------------- */
+
+/* @return true if the payload's "src" is the chair; id/t filled if so */
+static bool parse_probe(const char *data, int len, uint32_t *id, uint32_t *t)
+{
+    cJSON *root = cJSON_ParseWithLength(data, len);
+    if (!root) return false;
+    const cJSON *src = cJSON_GetObjectItemCaseSensitive(root, "src");
+    const cJSON *jid = cJSON_GetObjectItemCaseSensitive(root, "id");
+    const cJSON *jt  = cJSON_GetObjectItemCaseSensitive(root, "t");
+    bool ours = cJSON_IsString(src) && strcmp(src->valuestring, "chair") == 0 &&
+                cJSON_IsNumber(jid) && cJSON_IsNumber(jt);
+    if (ours) {
+        *id = (uint32_t)jid->valuedouble;
+        *t  = (uint32_t)jt->valuedouble;
+    }
+    cJSON_Delete(root);
+    return ours;
+}
+
+static void on_probe(const char *topic, int topic_len,
+                     const char *data, int data_len, void *ctx)
+{
+    uint32_t id, t;
+    if (!parse_probe(data, data_len, &id, &t)) {
+        mqtt_app_publish(LINK_ECHO_TOPIC, data, data_len, 0);   // web → echo back
+    }
+}
+
+static void on_echo(const char *topic, int topic_len,
+                    const char *data, int data_len, void *ctx)
+{
+    uint32_t id, t;
+    if (!parse_probe(data, data_len, &id, &t)) return;          // the web's own
+
+    uint32_t rtt = now_ms() - t;
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < PROBE_PENDING; i++) {
+        if (s_pending[i].active && s_pending[i].id == id) {
+            s_pending[i].active = false;
+            for (; s_suspect; s_suspect--) link_stats_add_loss(&s_stats);
+            link_stats_add_rtt(&s_stats, rtt);
+            s_have_echo = true;
+            s_last_echo_ms = now_ms();
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+/* -------- Probe task ----------------------------------------------- */
+
+static void expire_pending(uint32_t now)
+{
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < PROBE_PENDING; i++) {
+        if (s_pending[i].active &&
+            now - s_pending[i].sent_ms >= CONFIG_LINK_PROBE_TIMEOUT_MS) {
+            s_pending[i].active = false;
+            s_suspect++;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static void send_probe(uint32_t id, uint32_t now)
+{
+    int len = snprintf(s_payload, sizeof(s_payload),
+                       "{\"src\":\"chair\",\"id\":%" PRIu32 ",\"t\":%" PRIu32 "}", id, now);
+    if (mqtt_app_publish(LINK_PROBE_TOPIC, s_payload, len, 0) < 0) return;  // offline
+
+    portENTER_CRITICAL(&s_lock);
+    pending_t *slot = &s_pending[id % PROBE_PENDING];
+    if (slot->active) s_suspect++;                       // overwritten unanswered
+    *slot = (pending_t){ .id = id, .sent_ms = now, .active = true };
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static link_state_t next_state(link_state_t cur, const link_window_t *w, bool have_echo)
+{
+    const uint32_t p99_thr  = CONFIG_LINK_DEGRADED_P99_MS;
+    const uint32_t loss_thr = CONFIG_LINK_DEGRADED_LOSS_PM;
+
+    if (!have_echo) return LINK_UNKNOWN;
+    if (w->samples < PROBE_MIN_SAMPLES) return cur == LINK_UNKNOWN ? LINK_GOOD : cur;
+
+    bool bad  = w->p99_ms > p99_thr || w->loss_pm > loss_thr;
+    bool good = w->p99_ms <= p99_thr * 4 / 5 && w->loss_pm <= loss_thr / 2;
+    if (cur == LINK_DEGRADED) return good ? LINK_GOOD : LINK_DEGRADED;
+    return bad ? LINK_DEGRADED : LINK_GOOD;
+}
+
+static void evaluate(uint32_t now)
+{
+    const uint32_t idle_ms = CONFIG_LINK_PROBE_TIMEOUT_MS +
+                             PROBE_IDLE_PERIODS * CONFIG_LINK_PROBE_PERIOD_MS;
+    link_window_t w;
+    bool have_echo, went_idle = false;
+
+    /* Nobody echoing (web page closed) is not a lossy link: back to
+     * UNKNOWN, and the next peer starts with an empty window */
+    portENTER_CRITICAL(&s_lock);
+    if (s_have_echo && now - s_last_echo_ms >= idle_ms) {
+        s_have_echo = false;
+        s_suspect = 0;
+        link_stats_clear_window(&s_stats);
+        went_idle = true;
+    }
+    link_stats_window(&s_stats, &w);
+    have_echo = s_have_echo;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (went_idle) {
+        ESP_LOGI(TAG, "No echoes for %" PRIu32 " ms, link quality unknown", idle_ms);
+    }
+
+    wifi_ap_record_t ap;
+    int8_t rssi = (esp_wifi_sta_get_ap_info(&ap) == ESP_OK) ? ap.rssi : 0;
+
+    link_quality_t q = {
+        .state   = next_state(s_quality.state, &w, have_echo),
+        .p50_ms  = w.p50_ms,
+        .p90_ms  = w.p90_ms,
+        .p99_ms  = w.p99_ms,
+        .max_ms  = w.max_ms,
+        .loss_pm = w.loss_pm,
+        .samples = w.samples,
+        .rssi    = rssi,
+    };
+    if (q.state != s_quality.state && q.state != LINK_UNKNOWN) {
+        ESP_LOGW(TAG, "Link %s: p99 %u ms, loss %u.%u %%, RSSI %d dBm",
+                 q.state == LINK_DEGRADED ? "DEGRADED" : "good",
+                 q.p99_ms, q.loss_pm / 10, q.loss_pm % 10, q.rssi);
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_quality = q;
+    portEXIT_CRITICAL(&s_lock);
+
+    for (int i = 0; i < s_cb_count; i++) s_cbs[i](&q, s_cb_ctx[i]);
+}
+
+static const char *state_name(link_state_t s)
+{
+    return s == LINK_GOOD ? "good" : s == LINK_DEGRADED ? "degraded" : "unknown";
+}
+
+static void publish_metrics(void)
+{
+    link_quality_t q;
+    uint32_t hist[LINK_STATS_BUCKETS], answered, lost;
+
+    portENTER_CRITICAL(&s_lock);
+    q = s_quality;
+    memcpy(hist, s_stats.hist, sizeof(hist));
+    answered = s_stats.answered;
+    lost = s_stats.lost;
+    portEXIT_CRITICAL(&s_lock);
+
+    int len = snprintf(s_payload, sizeof(s_payload),
+                       "{\"state\":\"%s\",\"rtt\":[%u,%u,%u,%u],\"loss\":%u,\"n\":%u,"
+                       "\"rssi\":%d,\"answered\":%" PRIu32 ",\"lost\":%" PRIu32 ",\"hist\":[",
+                       state_name(q.state), q.p50_ms, q.p90_ms, q.p99_ms, q.max_ms,
+                       q.loss_pm, q.samples, q.rssi, answered, lost);
+    for (int b = 0; b < LINK_STATS_BUCKETS && len < (int)sizeof(s_payload); b++) {
+        len += snprintf(s_payload + len, sizeof(s_payload) - len, "%s%" PRIu32,
+                        b ? "," : "", hist[b]);
+    }
+    if (len < (int)sizeof(s_payload)) {
+        len += snprintf(s_payload + len, sizeof(s_payload) - len, "]}");
+    }
+    if (len >= (int)sizeof(s_payload)) {
+        ESP_LOGW(TAG, "Metrics truncated");
+        return;
+    }
+    mqtt_app_publish(LINK_METRICS_TOPIC, s_payload, len, 0);
+}
+
+static void link_probe_task(void *arg)
+{
+    uint32_t id = 0;
+    TickType_t wake = xTaskGetTickCount();
+
+    while (1) {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(CONFIG_LINK_PROBE_PERIOD_MS));
+
+        uint32_t now = now_ms();
+        expire_pending(now);
+        send_probe(id++, now);
+        evaluate(now);
+        if (id % PROBE_REPORT_EVERY == 0) publish_metrics();
+    }
+}
+
+/* -------- Built‑in consumer: speed limit on a degraded link -------- */
+
+static void speed_cap_cb(const link_quality_t *q, void *ctx)
+{
+    motor_set_speed_limit(q->state == LINK_DEGRADED ? CONFIG_LINK_SPEED_CAP_PERCENT : 100);
+}
+
+/* -------- Public API ----------------------------------------------- */
+
+void link_probe_init(void)
+{
+    link_stats_reset(&s_stats);
+    mqtt_app_register_topic(LINK_PROBE_TOPIC, 0, on_probe, NULL);
+    mqtt_app_register_topic(LINK_ECHO_TOPIC, 0, on_echo, NULL);
+    if (CONFIG_LINK_SPEED_CAP_PERCENT < 100) {
+        link_probe_register(speed_cap_cb, NULL);
+    }
+
+    TaskHandle_t h = xTaskCreateStatic(link_probe_task, "link_probe",
+                                       PROBE_STACK_BYTES, NULL,
+                                       tskIDLE_PRIORITY + 2,
+                                       s_probe_stack, &s_probe_tcb);
+    mem_report_register_task(h, PROBE_STACK_BYTES);
+}
+
+esp_err_t link_probe_register(link_probe_cb_t cb, void *ctx)
+{
+    if (!cb) return ESP_ERR_INVALID_ARG;
+    if (s_cb_count >= LINK_PROBE_MAX_CALLBACKS) return ESP_ERR_NO_MEM;
+    s_cb_ctx[s_cb_count] = ctx;
+    s_cbs[s_cb_count] = cb;
+    s_cb_count++;
+    return ESP_OK;
+}
+
+void link_probe_get(link_quality_t *out)
+{
+    if (!out) return;
+    portENTER_CRITICAL(&s_lock);
+    *out = s_quality;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+#else  /* !CONFIG_LINK_PROBE */
+
+void link_probe_init(void)
+{
+    ESP_LOGI(TAG, "Link probe disabled (CONFIG_LINK_PROBE)");
+}
+
+esp_err_t link_probe_register(link_probe_cb_t cb, void *ctx)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void link_probe_get(link_quality_t *out)
+{
+    if (out) *out = (link_quality_t){0};
+}
+
+#endif /* CONFIG_LINK_PROBE */
@@ -0,0 +1,77 @@
+/*=====================================================================
+ * link_probe.h — Control‑link quality: probes, echoes, RTT / loss
+ *
+ *  • Every CONFIG_LINK_PROBE_PERIOD_MS the chair publishes
+ *      {"src":"chair","id":<n>,"t":<ms>}   on LINK_PROBE_TOPIC
+ *    and the web client publishes the same with "src":"web". Each side
+ *    echoes the other's probes verbatim on LINK_ECHO_TOPIC, so RTT is
+ *    always measured against the prober's own clock.
+ *  • An echo that does not arrive within CONFIG_LINK_PROBE_TIMEOUT_MS
+ *    counts as lost once a later echo shows the peer is still there.
+ *    link_stats keeps the window quantiles and the histogram since boot.
+ *  • State: UNKNOWN until the first echo, and again (window cleared)
+ *    when none arrives for 4 periods past the timeout; DEGRADED when
+ *    the window p99 exceeds CONFIG_LINK_DEGRADED_P99_MS or loss exceeds
+ *    CONFIG_LINK_DEGRADED_LOSS_PM; GOOD again below 80 % / 50 % of
+ *    those thresholds.
+ *  • Registered callbacks get the quality (with Wi‑Fi RSSI) once per
+ *    period, from the probe task.  Built in: the drive speed limit
+ *    drops to CONFIG_LINK_SPEED_CAP_PERCENT while DEGRADED (applied
+ *    only while a network source drives, see motor_set_speed_limit).
+ *  • Metrics are published on LINK_METRICS_TOPIC every 10 periods:
+ *      {"state":"good","rtt":[p50,p90,p99,max],"loss":<‰>,"n":<window>,
+ *       "rssi":<dBm>,"answered":n,"lost":n,"hist":[<per bucket>]}
+ *    with bucket edges 10,20,50,75,100,150,200,300,500,1000,2000 ms.
+ *====================================================================*/
+
+#ifndef LINK_PROBE_H
+#define LINK_PROBE_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#define LINK_PROBE_TOPIC        "wheelchair/diag/probe"
+#define LINK_ECHO_TOPIC         "wheelchair/diag/echo"
+#define LINK_METRICS_TOPIC      "wheelchair/diag/link"
+
+#ifndef LINK_PROBE_MAX_CALLBACKS
+#define LINK_PROBE_MAX_CALLBACKS 4
+#endif
+
+typedef enum {
+    LINK_UNKNOWN = 0,
+    LINK_GOOD,
+    LINK_DEGRADED,
+} link_state_t;
+
+typedef struct {
+    link_state_t state;
+    uint16_t p50_ms;
+    uint16_t p90_ms;
+    uint16_t p99_ms;
+    uint16_t max_ms;
+    uint16_t loss_pm;           /* per mille over the window */
+    uint8_t  samples;           /* probes in the window */
+    int8_t   rssi;              /* dBm, 0 = not associated */
+} link_quality_t;
+
+typedef void (*link_probe_cb_t)(const link_quality_t *q, void *ctx);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Register the topics and start the probe task (needs CONFIG_LINK_PROBE). */
+void link_probe_init(void);
+
+/** Call @p cb once per probe period; ESP_ERR_NO_MEM when full. */
+esp_err_t link_probe_register(link_probe_cb_t cb, void *ctx);
+
+/** Latest link quality. */
+void link_probe_get(link_quality_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINK_PROBE_H */
@@ -0,0 +1,72 @@
+/*=====================================================================
+ * link_stats.c — Probe window quantiles and RTT histogram
+ *====================================================================*/
+
+#include <string.h>
+#include "link_stats.h"
+
+const uint16_t link_stats_edges_ms[LINK_STATS_BUCKETS - 1] = {
+    10, 20, 50, 75, 100, 150, 200, 300, 500, 1000, 2000,
+};
+
+void link_stats_reset(link_stats_t *s)
+{
+    memset(s, 0, sizeof(*s));
+}
+
+static void push(link_stats_t *s, uint16_t v)
+{
+    s->window[s->head] = v;
+    s->head = (uint8_t)((s->head + 1) % LINK_STATS_WINDOW);
+    if (s->fill < LINK_STATS_WINDOW) s->fill++;
+}
+
+void link_stats_add_rtt(link_stats_t *s, uint32_t rtt_ms)
+{
+    uint16_t v = rtt_ms >= LINK_STATS_LOST ? LINK_STATS_LOST - 1 : (uint16_t)rtt_ms;
+    int b = 0;
+    while (b < LINK_STATS_BUCKETS - 1 && v > link_stats_edges_ms[b]) b++;
+    s->hist[b]++;
+    s->answered++;
+    push(s, v);
+}
+
+void link_stats_add_loss(link_stats_t *s)
+{
+    s->lost++;
+    push(s, LINK_STATS_LOST);
+}
+
+void link_stats_clear_window(link_stats_t *s)
+{
+    s->head = 0;
+    s->fill = 0;
+}
+
+void link_stats_window(const link_stats_t *s, link_window_t *out)
+{
+    uint16_t rtt[LINK_STATS_WINDOW];
+    int n = 0;
+
+    memset(out, 0, sizeof(*out));
+    out->samples = s->fill;
+    for (int i = 0; i < s->fill; i++) {
+        if (s->window[i] != LINK_STATS_LOST) rtt[n++] = s->window[i];
+    }
+    if (s->fill) out->loss_pm = (uint16_t)((s->fill - n) * 1000 / s->fill);
+    if (n == 0) return;
+
+    for (int i = 1; i < n; i++) {               // ≤ 64 entries: insertion sort
+        uint16_t v = rtt[i];
+        int j = i - 1;
+        while (j >= 0 && rtt[j] > v) {
+            rtt[j + 1] = rtt[j];
+            j--;
+        }
+        rtt[j + 1] = v;
+    }
+    out->p50_ms = rtt[(n * 50 + 99) / 100 - 1];
+    out->p90_ms = rtt[(n * 90 + 99) / 100 - 1];
+    out->p99_ms = rtt[(n * 99 + 99) / 100 - 1];
+    out->max_ms = rtt[n - 1];
+}
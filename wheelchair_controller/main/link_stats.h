@@ -0,0 +1,63 @@
+/*=====================================================================
+ * link_stats.h — RTT / loss statistics of the control link
+ *
+ *  • Sliding window of the last LINK_STATS_WINDOW probes (RTT or lost)
+ *    for live quantiles and loss rate.
+ *  • Cumulative RTT histogram since reset, fixed bucket edges
+ *    (link_stats_edges_ms), plus sent / lost totals.
+ *
+ * Pure C, no ESP‑IDF dependencies.  Not thread‑safe.
+ *====================================================================*/
+
+#ifndef LINK_STATS_H
+#define LINK_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef LINK_STATS_WINDOW
+#define LINK_STATS_WINDOW       64
+#endif
+#define LINK_STATS_BUCKETS      12      /* last bucket: above the last edge */
+#define LINK_STATS_LOST         0xFFFF  /* window entry of a lost probe */
+
+/* Upper bucket edges (ms); LINK_STATS_BUCKETS − 1 entries. */
+extern const uint16_t link_stats_edges_ms[LINK_STATS_BUCKETS - 1];
+
+typedef struct {
+    uint16_t window[LINK_STATS_WINDOW]; // RTT ms or LINK_STATS_LOST
+    uint8_t  head;
+    uint8_t  fill;
+    uint32_t hist[LINK_STATS_BUCKETS];
+    uint32_t answered;
+    uint32_t lost;
+} link_stats_t;
+
+typedef struct {
+    uint16_t p50_ms;
+    uint16_t p90_ms;
+    uint16_t p99_ms;
+    uint16_t max_ms;
+    uint16_t loss_pm;                   // per mille of the window
+    uint8_t  samples;                   // probes in the window
+} link_window_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void link_stats_reset(link_stats_t *s);
+void link_stats_add_rtt(link_stats_t *s, uint32_t rtt_ms);
+void link_stats_add_loss(link_stats_t *s);
+
+/** Empty the window (a new peer session); the totals are kept. */
+void link_stats_clear_window(link_stats_t *s);
+
+/** Quantiles (nearest rank over answered probes) and loss of the window. */
+void link_stats_window(const link_stats_t *s, link_window_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LINK_STATS_H */
@@ -10,6 +10,17 @@
 #include "wifi_manager.h"
 #include "motor_control.h"
 #include "env_parser.h"
+#include "deferred_log.h"
+#include "json_pool.h"
+#include "mem_report.h"
+#include "cpu_profiler.h"
+#include "flash_stress.h"
+#include "bench.h"
+#include "ota_update.h"
+#include "power_sense.h"
+#include "link_probe.h"
+#include "wired_joystick.h"
+#include "motor_cal.h"
 // web_server.h is implicitly included by wifi_manager.h which needs start/stop
 
 // --- Application Configuration ---
@@ -18,6 +29,14 @@ static const char *TAG = "MAIN_APP";
 // --- Main Application ---
 void app_main(void)
 {
+    // Start the deferred logger first so every module can use DLOGx()
+    deferred_log_init();
+
+    // Route cJSON into its static arena and start the memory report
+    json_pool_init();
+    mem_report_init();
+    mem_report_register_task(xTaskGetCurrentTaskHandle(), CONFIG_ESP_MAIN_TASK_STACK_SIZE);
+
     // Initialize NVS (needed for WiFi)
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -33,11 +52,24 @@ void app_main(void)
     const char *wifi_ssid = get_env_value("WIFI_SSID");
     const char *wifi_pass = get_env_value("WIFI_PASS");
 
-    ESP_LOGI(TAG, "Initializing WiFi...");
-    wifi_init_sta(wifi_ssid, wifi_pass); // Pass credentials
+    // OTA task + rollback guard; must be armed before MQTT can connect
+    ota_update_init();
 
     ESP_LOGI(TAG, "Initializing Motor Control...");
     motor_control_init(); // Initialize motors
+    motor_cal_init();     // Per-motor deadband/curve/gain from NVS
+    power_sense_init();   // Current/voltage sensing, overcurrent cutback
+    link_probe_init();    // RTT/loss probes, speed cap on a degraded link
+    wired_joystick_init(); // UART joystick as the local command source
+    bench_init();         // Diagnostic builds only: hot-path benchmark
+
+    // Networking last: MQTT handlers share the json_pool arena with the
+    // benchmark, and every topic above is subscribed on the first connect
+    ESP_LOGI(TAG, "Initializing WiFi...");
+    wifi_init_sta(wifi_ssid, wifi_pass); // Pass credentials
+
+    cpu_profiler_init(); // Per-task CPU usage on serial + MQTT
+    flash_stress_init(); // Test builds only: NVS hammer + tick latency
 
     ESP_LOGI(TAG, "Initialization complete. Waiting for WiFi connection and MQTT commands...");
 
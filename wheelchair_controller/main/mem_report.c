@@ -0,0 +1,113 @@
+/*=====================================================================
+ * mem_report.c — Heap / stack / allocation statistics task
+ *====================================================================*/
+
+#include <inttypes.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "json_pool.h"
+#include "mem_report.h"
+
+static const char *TAG = "MEM_REPORT";
+
+/* ESP_LOGI formatting dominates; this task reports its own headroom. */
+#define MEM_REPORT_STACK_BYTES  2560
+
+typedef struct {
+    TaskHandle_t handle;
+    uint32_t     stack_bytes;
+} tracked_task_t;
+
+static tracked_task_t g_tasks[MEM_REPORT_MAX_TASKS];
+static int g_task_count = 0;
+static portMUX_TYPE g_tasks_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static StackType_t  s_report_stack[MEM_REPORT_STACK_BYTES];
+static StaticTask_t s_report_tcb;
+
+/* Heap calls since boot, from every task and ISR (atomic increments) */
+static uint32_t s_allocs, s_frees, s_failed;
+
+#if CONFIG_MEM_REPORT_ALLOC_COUNTS
+/* CONFIG_HEAP_USE_HOOKS: called by heap_caps on every (re)alloc / free */
+void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+    __atomic_fetch_add(&s_allocs, 1, __ATOMIC_RELAXED);
+}
+
+void IRAM_ATTR esp_heap_trace_free_hook(void *ptr)
+{
+    __atomic_fetch_add(&s_frees, 1, __ATOMIC_RELAXED);
+}
+#endif
+
+static void alloc_failed_cb(size_t size, uint32_t caps, const char *function_name)
+{
+    __atomic_fetch_add(&s_failed, 1, __ATOMIC_RELAXED);
+}
+
+static void mem_report_task(void *arg);
+
+void mem_report_init(void)
+{
+    heap_caps_register_failed_alloc_callback(alloc_failed_cb);
+    TaskHandle_t h = xTaskCreateStatic(mem_report_task, "mem_report",
+                                       MEM_REPORT_STACK_BYTES, NULL,
+                                       tskIDLE_PRIORITY + 1,
+                                       s_report_stack, &s_report_tcb);
+    mem_report_register_task(h, MEM_REPORT_STACK_BYTES);
+}
+
+void mem_report_register_task(TaskHandle_t task, uint32_t stack_bytes)
+{
+    if (task == NULL) return;
+
+    portENTER_CRITICAL(&g_tasks_lock);
+    if (g_task_count < MEM_REPORT_MAX_TASKS) {
+        g_tasks[g_task_count].handle      = task;
+        g_tasks[g_task_count].stack_bytes = stack_bytes;
+        g_task_count++;
+    }
+    portEXIT_CRITICAL(&g_tasks_lock);
+}
+
+static void mem_report_task(void *arg)
+{
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(MEM_REPORT_PERIOD_MS));
+
+        multi_heap_info_t heap;
+        heap_caps_get_info(&heap, MALLOC_CAP_8BIT);
+        ESP_LOGI(TAG, "heap: free=%u min=%u largest=%u live_blocks=%u",
+                 (unsigned)heap.total_free_bytes,
+                 (unsigned)heap.minimum_free_bytes,
+                 (unsigned)heap.largest_free_block,
+                 (unsigned)heap.allocated_blocks);
+#if CONFIG_MEM_REPORT_ALLOC_COUNTS
+        ESP_LOGI(TAG, "heap since boot: allocs=%" PRIu32 " frees=%" PRIu32 " failed=%" PRIu32,
+                 s_allocs, s_frees, s_failed);
+#else
+        ESP_LOGI(TAG, "heap since boot: failed=%" PRIu32, s_failed);
+#endif
+
+        json_pool_stats_t js;
+        json_pool_get_stats(&js);
+        ESP_LOGI(TAG, "cjson: arena=%" PRIu32 " heap=%" PRIu32 "/%" PRIu32
+                 " (alloc/free) arena_hw=%" PRIu32 "/%d",
+                 js.arena_allocs, js.heap_allocs, js.heap_frees,
+                 js.high_water_bytes, JSON_POOL_ARENA_BYTES);
+
+        /* Tasks are only ever appended, so a stale count is harmless. */
+        int n = g_task_count;
+        for (int i = 0; i < n; i++) {
+            ESP_LOGI(TAG, "stack %-12s %5u / %5" PRIu32 " bytes free",
+                     pcTaskGetName(g_tasks[i].handle),
+                     (unsigned)uxTaskGetStackHighWaterMark(g_tasks[i].handle),
+                     g_tasks[i].stack_bytes);
+        }
+    }
+}
@@ -0,0 +1,45 @@
+/*=====================================================================
+ * mem_report.h — Periodic memory footprint report
+ *
+ * Logs heap usage (free, minimum ever free, largest free block, live
+ * block count), heap allocations / frees / failures since boot (with
+ * CONFIG_MEM_REPORT_ALLOC_COUNTS), the cJSON arena counters and the
+ * stack headroom of every registered task.  Use it to size the static
+ * task stacks (measured minimum headroom plus a margin) and to confirm
+ * the heap stays flat in steady state: the allocation count should
+ * stop growing once the chair is up.
+ *====================================================================*/
+
+#ifndef MEM_REPORT_H
+#define MEM_REPORT_H
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifndef MEM_REPORT_PERIOD_MS
+#define MEM_REPORT_PERIOD_MS    10000
+#endif
+#ifndef MEM_REPORT_MAX_TASKS
+#define MEM_REPORT_MAX_TASKS    8
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Start the reporting task. */
+void mem_report_init(void);
+
+/**
+ * Track a task's stack high‑water mark.
+ * @param task         task handle
+ * @param stack_bytes  stack size the task was created with
+ */
+void mem_report_register_task(TaskHandle_t task, uint32_t stack_bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEM_REPORT_H */
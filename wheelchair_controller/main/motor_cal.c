@@ -0,0 +1,196 @@
+/*=====================================================================
+ * motor_cal.c — NVS storage and MQTT updates of motor calibrations
+ *====================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "nvs.h"
+#include "cJSON.h"
+#include "motor_control.h"
+#include "mqtt_client_app.h"
+#include "motor_cal.h"
+
+static const char *TAG = "MOTOR_CAL";
+
+#define CAL_NVS_NAMESPACE   "motor_cal"
+#define CAL_NVS_VERSION     1
+#define CAL_PAYLOAD_MAX     256
+
+typedef struct {
+    uint8_t     version;
+    motor_cal_t cal;
+} cal_blob_t;
+
+static char s_payload[CAL_PAYLOAD_MAX];     // MQTT event task only
+
+static void nvs_key(int ch, char *key, size_t size)
+{
+    snprintf(key, size, "ch%d", ch);
+}
+
+static esp_err_t cal_load(int ch, motor_cal_t *cal)
+{
+    nvs_handle_t nvs;
+    cal_blob_t blob;
+    size_t len = sizeof(blob);
+    char key[8];
+
+    esp_err_t err = nvs_open(CAL_NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (err != ESP_OK) return err;
+    nvs_key(ch, key, sizeof(key));
+    err = nvs_get_blob(nvs, key, &blob, &len);
+    nvs_close(nvs);
+    if (err != ESP_OK) return err;
+
+    if (len != sizeof(blob) || blob.version != CAL_NVS_VERSION || !motor_cal_valid(&blob.cal)) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    *cal = blob.cal;
+    return ESP_OK;
+}
+
+/* cal == NULL erases the channel's entry */
+static esp_err_t cal_store(int ch, const motor_cal_t *cal)
+{
+    nvs_handle_t nvs;
+    char key[8];
+
+    esp_err_t err = nvs_open(CAL_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) return err;
+    nvs_key(ch, key, sizeof(key));
+    if (cal) {
+        const cal_blob_t blob = { .version = CAL_NVS_VERSION, .cal = *cal };
+        err = nvs_set_blob(nvs, key, &blob, sizeof(blob));
+    } else {
+        err = nvs_erase_key(nvs, key);
+        if (err == ESP_ERR_NVS_NOT_FOUND) err = ESP_OK;
+    }
+    if (err == ESP_OK) err = nvs_commit(nvs);
+    nvs_close(nvs);
+    return err;
+}
+
+static void publish_status(int ch, bool stored, const char *error)
+{
+    motor_cal_t cal;
+    int len;
+
+    if (error) {
+        len = snprintf(s_payload, sizeof(s_payload), "{\"ch\":%d,\"error\":\"%s\"}", ch, error);
+    } else {
+        motor_get_calibration(ch, &cal);
+        len = snprintf(s_payload, sizeof(s_payload), "{\"ch\":%d,\"deadband\":%u,\"gain\":%u,\"curve\":[",
+                       ch, cal.deadband_pm, cal.gain_pm);
+        for (int k = 0; k < MOTOR_CAL_POINTS && len < (int)sizeof(s_payload); k++) {
+            len += snprintf(s_payload + len, sizeof(s_payload) - len, k ? ",%u" : "%u",
+                            cal.curve_pm[k]);
+        }
+        if (len < (int)sizeof(s_payload)) {
+            len += snprintf(s_payload + len, sizeof(s_payload) - len, "],\"stored\":%s}",
+                            stored ? "true" : "false");
+        }
+    }
+    if (len <= 0 || len >= (int)sizeof(s_payload)) return;
+    mqtt_app_publish(MOTOR_CAL_STATUS_TOPIC, s_payload, len, 1);
+}
+
+/* Merge the JSON fields into cal; @return error text or NULL */
+static const char *cal_merge(const cJSON *root, motor_cal_t *cal)
+{
+    const cJSON *db    = cJSON_GetObjectItemCaseSensitive(root, "deadband");
+    const cJSON *gain  = cJSON_GetObjectItemCaseSensitive(root, "gain");
+    const cJSON *curve = cJSON_GetObjectItemCaseSensitive(root, "curve");
+
+    if (db) {
+        if (!cJSON_IsNumber(db) || db->valueint < 0 ||
+            db->valueint > MOTOR_CAL_DEADBAND_MAX) return "bad deadband";
+        cal->deadband_pm = (uint16_t)db->valueint;
+    }
+    if (gain) {
+        if (!cJSON_IsNumber(gain) || gain->valueint < MOTOR_CAL_GAIN_MIN ||
+            gain->valueint > MOTOR_CAL_GAIN_MAX) return "bad gain";
+        cal->gain_pm = (uint16_t)gain->valueint;
+    }
+    if (curve) {
+        if (!cJSON_IsArray(curve) || cJSON_GetArraySize(curve) != MOTOR_CAL_POINTS) {
+            return "curve needs 11 points";
+        }
+        int k = 0;
+        const cJSON *p;
+        cJSON_ArrayForEach(p, curve) {
+            if (!cJSON_IsNumber(p) || p->valueint < 0 || p->valueint > 1000) return "bad curve point";
+            cal->curve_pm[k++] = (uint16_t)p->valueint;
+        }
+    }
+    return motor_cal_valid(cal) ? NULL : "out of range or curve decreasing";
+}
+
+static void on_cal_command(const char *topic, int topic_len,
+                           const char *data, int data_len, void *ctx)
+{
+    cJSON *root = cJSON_ParseWithLength(data, data_len);
+    if (root == NULL) {
+        ESP_LOGE(TAG, "Failed to parse calibration JSON");
+        return;
+    }
+
+    const cJSON *ch_item = cJSON_GetObjectItemCaseSensitive(root, "ch");
+    const cJSON *reset   = cJSON_GetObjectItemCaseSensitive(root, "reset");
+    int ch = cJSON_IsNumber(ch_item) ? ch_item->valueint : -1;
+    motor_cal_t cal;
+    const char *error = NULL;
+    bool stored = false;
+
+    if (ch < 0 || ch >= MOTOR_DRIVE_CHANNELS) {
+        ESP_LOGE(TAG, "Calibration for unknown channel %d", ch);
+        cJSON_Delete(root);
+        return;
+    }
+
+    bool do_reset = cJSON_IsTrue(reset);
+    bool update = do_reset ||
+                  cJSON_GetObjectItemCaseSensitive(root, "deadband") ||
+                  cJSON_GetObjectItemCaseSensitive(root, "gain") ||
+                  cJSON_GetObjectItemCaseSensitive(root, "curve");
+    if (do_reset) {
+        motor_cal_default(&cal);
+    } else {
+        motor_get_calibration(ch, &cal);
+        error = cal_merge(root, &cal);
+    }
+    cJSON_Delete(root);
+
+    if (update && !error) {
+        esp_err_t err = motor_set_calibration(ch, &cal);
+        if (err == ESP_ERR_INVALID_STATE) {
+            error = "busy, retry";
+        } else if (err != ESP_OK) {
+            error = "rejected";
+        } else {
+            err = cal_store(ch, do_reset ? NULL : &cal);
+            stored = err == ESP_OK;
+            if (!stored) ESP_LOGE(TAG, "Storing channel %d failed: %s", ch, esp_err_to_name(err));
+        }
+    }
+    if (error) ESP_LOGW(TAG, "Channel %d calibration rejected: %s", ch, error);
+    publish_status(ch, stored, error);
+}
+
+void motor_cal_init(void)
+{
+    for (int ch = 0; ch < MOTOR_DRIVE_CHANNELS; ch++) {
+        motor_cal_t cal;
+        esp_err_t err = cal_load(ch, &cal);
+        if (err == ESP_OK) {
+            motor_set_calibration(ch, &cal);
+        } else if (err == ESP_ERR_NVS_NOT_FOUND) {
+            ESP_LOGI(TAG, "Channel %d: no calibration stored, linear output", ch);
+        } else {
+            ESP_LOGW(TAG, "Channel %d: stored calibration unusable (%s), linear output",
+                     ch, esp_err_to_name(err));
+        }
+    }
+    mqtt_app_register_topic(MOTOR_CAL_TOPIC, 1, on_cal_command, NULL);
+    mqtt_app_set_topic_limit(MOTOR_CAL_TOPIC, CAL_PAYLOAD_MAX);
+}
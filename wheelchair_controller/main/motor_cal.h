@@ -0,0 +1,40 @@
+/*=====================================================================
+ * motor_cal.h — Persistent per‑motor output calibration
+ *
+ *  • Calibrations (motor_lut.h) live in NVS, namespace "motor_cal",
+ *    one blob per drive channel; motor_cal_init() loads them into the
+ *    duty tables at boot.  Channels without one stay linear.
+ *  • MOTOR_CAL_TOPIC updates a channel at run time:
+ *      {"ch":0,"deadband":120,"gain":965,"curve":[0,95,…,1000]}
+ *    Omitted fields keep their current value; {"ch":0,"reset":true}
+ *    restores the linear map; {"ch":0} only reports.  Valid updates
+ *    are applied and stored, and the channel's calibration is
+ *    published on MOTOR_CAL_STATUS_TOPIC:
+ *      {"ch":0,"deadband":120,"gain":965,"curve":[…],"stored":true}
+ *    or with "error":"…" if rejected.
+ *  • tools/motor_cal_fit.py fits the values from a duty sweep and can
+ *    publish them.
+ *  • Open loop only: with CONFIG_MOTOR_ENCODERS the speed loop writes
+ *    linear duty and CONFIG_MOTOR_SPEED_KS_PERCENT sets the starting
+ *    duty instead of the deadband.
+ *====================================================================*/
+
+#ifndef MOTOR_CAL_H
+#define MOTOR_CAL_H
+
+#define MOTOR_CAL_TOPIC         "wheelchair/config/motor_cal"
+#define MOTOR_CAL_STATUS_TOPIC  "wheelchair/diag/motor_cal"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Load stored calibrations and subscribe to updates.
+ *  Call after nvs_flash_init() and motor_control_init(). */
+void motor_cal_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MOTOR_CAL_H */
@@ -0,0 +1,39 @@
+/*=====================================================================
+ * motor_cmd.c — Motor command parsing / state encoding
+ *====================================================================*/
+
+#include <stdio.h>
+#include "cJSON.h"
+#include "motor_cmd.h"
+
+motor_cmd_status_t motor_cmd_parse(const char *data, int data_len, motor_cmd_t *cmd)
+{
+    cJSON *root = cJSON_ParseWithLength(data, data_len);
+    if (root == NULL) {
+        return MOTOR_CMD_BAD_JSON;
+    }
+
+    const cJSON *left_json  = cJSON_GetObjectItemCaseSensitive(root, "left");
+    const cJSON *right_json = cJSON_GetObjectItemCaseSensitive(root, "right");
+    const cJSON *v_json     = cJSON_GetObjectItemCaseSensitive(root, "v");
+    const cJSON *w_json     = cJSON_GetObjectItemCaseSensitive(root, "w");
+    motor_cmd_status_t st = MOTOR_CMD_BAD_FIELDS;
+
+    if (cJSON_IsNumber(left_json) && cJSON_IsNumber(right_json)) {
+        *cmd = (motor_cmd_t){ .left = left_json->valueint, .right = right_json->valueint };
+        st = MOTOR_CMD_OK;
+    } else if (cJSON_IsNumber(v_json) && cJSON_IsNumber(w_json)) {
+        *cmd = (motor_cmd_t){ .twist = true, .v = v_json->valueint, .w = w_json->valueint };
+        st = MOTOR_CMD_OK;
+    }
+
+    cJSON_Delete(root);
+    return st;
+}
+
+int motor_state_encode(char *buf, size_t size, int left, int right)
+{
+    int len = snprintf(buf, size, "{\"left_speed\":%d,\"right_speed\":%d}",
+                       left, right);
+    return (len >= 0 && (size_t)len < size) ? len : -1;
+}
@@ -0,0 +1,51 @@
+/*=====================================================================
+ * motor_cmd.h — Wire format of motor commands and motor state
+ *
+ *  command (wheelchair/command/motor):  {"left":<int>,"right":<int>}
+ *                                   or  {"v":<int>,"w":<int>}
+ *    left/right: wheel speeds in percent.  v/w (twist): linear and
+ *    angular speed in percent, mixed on the chair (twist_mix.h).
+ *  state   (wheelchair/state):          {"left_speed":<int>,"right_speed":<int>}
+ *
+ * Pure C on top of cJSON so the same code runs in the host benchmark
+ * (tools/bench).
+ *====================================================================*/
+
+#ifndef MOTOR_CMD_H
+#define MOTOR_CMD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define MOTOR_STATE_PAYLOAD_MAX 48      /* {"left_speed":-100,"right_speed":-100} */
+
+typedef enum {
+    MOTOR_CMD_OK = 0,
+    MOTOR_CMD_BAD_JSON,                 /* not parseable */
+    MOTOR_CMD_BAD_FIELDS,               /* neither left/right nor v/w as numbers */
+} motor_cmd_status_t;
+
+typedef struct {
+    bool twist;                         /* v/w given, else left/right */
+    int  left, right;
+    int  v, w;
+} motor_cmd_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Parse a motor command payload (not NUL‑terminated). */
+motor_cmd_status_t motor_cmd_parse(const char *data, int data_len, motor_cmd_t *cmd);
+
+/**
+ * Encode the motor state into @p buf.
+ * @return payload length, or −1 if it did not fit
+ */
+int motor_state_encode(char *buf, size_t size, int left, int right);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MOTOR_CMD_H */
@@ -3,42 +3,188 @@
  *
  * Soft‑stop watchdog version — May 5 2025
  *  • Each incoming command (MQTT, UART, etc.) sets a TARGET speed.
- *  • If no command is received for MOTOR_DECAY_MS, TARGET is forced to 0.
+ *  • Every drive command source has its own lock‑free slot
+ *    (cmd_arbiter.c); the tick picks one owner by priority and
+ *    ownership, so only the owner's commands reach the drive.
+ *  • Drive commands pass through an adaptive playout stage
+ *    (cmd_playout.c) that rides out network jitter; if no command is
+ *    received within its grace period (≥ MOTOR_DECAY_MS), TARGET is
+ *    forced to 0.
  *  • A 10 ms control task slews the ACTUAL output toward TARGET by a
  *    fixed percent per tick, producing a linear 300 ms decay to zero.
+ *    The slew runs in Q8 fixed point (no FPU use in the tick).
+ *  • With CONFIG_MOTOR_ENCODERS the slewed value is a wheel SPEED
+ *    reference: a per‑side PI + feedforward loop (speed_ctrl.c) on the
+ *    PCNT encoder counts sets the drive duty each tick.  Without
+ *    encoders the slewed value is the duty itself (open loop).
+ *  • CONFIG_MOTOR_CONTROL_IN_IRAM moves the tick, its helpers and the
+ *    channel table to IRAM/DRAM and dispatches it from the esp_timer
+ *    ISR, so flash writes (NVS, SPIFFS, OTA) cannot stall it.
+ *  • Twist commands (v, ω) are mixed into left/right in Q8 as they are
+ *    submitted (twist_mix.c); the speed limit in the tick scales both
+ *    sides together, so neither changes the commanded turn radius.
+ *  • Drive channels map the output to PWM duty through a per‑motor
+ *    calibration table (motor_lut.c: deadband, curve, gain) built off
+ *    the tick, so the tick does one indexed load per channel.
  *  • Uses the same PWM + DIR interface as before (MDD20A or similar).
+ *  • Channels (2–4 drive + aux) come from a const table built from
+ *    Kconfig, so init/apply are fixed‑count loops over constants.
  *====================================================================*/
 
+#include <inttypes.h>
 #include <math.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdlib.h>
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "freertos/FreeRTOS.h"
 #include "driver/gpio.h"
 #include "driver/ledc.h"
 #include "esp_timer.h"
+#include "esp_cpu.h"
+#include "cmd_playout.h"
+#include "cmd_arbiter.h"
+#include "speed_ctrl.h"
+#include "motor_lut.h"
+#include "twist_mix.h"
+#include "wheel_encoder.h"
 #include "motor_control.h"     // public API / pin definitions
+#include "deferred_log.h"
 
 static const char *TAG = "MOTOR_CTRL";
 
 /*---------------------------------------------------------------------
- * Timing and slew‑rate configuration
+ * Slew‑rate configuration (timing comes from motor_control.h / Kconfig)
+ * Outputs are tracked in Q8 percent: 100 % = 100 << 8.
  *-------------------------------------------------------------------*/
-#define MOTOR_DECAY_MS          300                 // stop after this time
-#define MOTOR_TASK_PERIOD_MS    10                  // control loop period
-#define MOTOR_SLEW_DELTA        (100.0f * (float)MOTOR_TASK_PERIOD_MS / \
-                                 (float)MOTOR_DECAY_MS)   // ≈ 3.33 % per tick
+#define MOTOR_Q_SHIFT           8
+#define MOTOR_Q_FULL            (100 << MOTOR_Q_SHIFT)
+#define MOTOR_SLEW_DELTA_Q      (MOTOR_Q_FULL * MOTOR_TASK_PERIOD_MS / \
+                                 MOTOR_DECAY_MS)          // ≈ 3.33 % per tick
+
+_Static_assert(MOTOR_SLEW_DELTA_Q > 0, "MOTOR_DECAY_MS too long for the tick period");
+
+/*---------------------------------------------------------------------
+ * Placement of the control path (see CONFIG_MOTOR_CONTROL_IN_IRAM).
+ * cmd_playout.c and deferred_log_write() are moved by linker.lf.
+ *-------------------------------------------------------------------*/
+#if CONFIG_MOTOR_CONTROL_IN_IRAM
+#define MOTOR_IRAM_ATTR         IRAM_ATTR
+#define MOTOR_DRAM_ATTR         DRAM_ATTR
+#define MOTOR_TIMER_DISPATCH    ESP_TIMER_ISR
+#else
+#define MOTOR_IRAM_ATTR
+#define MOTOR_DRAM_ATTR
+#define MOTOR_TIMER_DISPATCH    ESP_TIMER_TASK
+#endif
+
+/*---------------------------------------------------------------------
+ * Channel table — generated from Kconfig at compile time
+ *-------------------------------------------------------------------*/
+typedef enum {
+    MOTOR_SIDE_LEFT,
+    MOTOR_SIDE_RIGHT,
+    MOTOR_SIDE_AUX,
+} motor_side_t;
+
+typedef struct {
+    gpio_num_t     pwm_pin;
+    gpio_num_t     dir_pin;
+    ledc_channel_t ledc_channel;
+    motor_side_t   side;
+    bool           invert;
+    int16_t        max_percent;
+} motor_channel_cfg_t;
+
+/* 1 if a bool Kconfig symbol is set, 0 otherwise (usable in initialisers) */
+#define MOTOR_KCONFIG_PLACEHOLDER_1             0,
+#define MOTOR_KCONFIG_SECOND(ignored, val, ...) val
+#define MOTOR_KCONFIG_BOOL(sym)                 MOTOR_KCONFIG_BOOL_(sym)
+#define MOTOR_KCONFIG_BOOL_(val)                MOTOR_KCONFIG_BOOL__(MOTOR_KCONFIG_PLACEHOLDER_##val)
+#define MOTOR_KCONFIG_BOOL__(arg)               MOTOR_KCONFIG_SECOND(arg 1, 0, 0)
+
+#define MOTOR_CHANNEL(idx, prefix, sd) {                                \
+        .pwm_pin      = (gpio_num_t)CONFIG_##prefix##_PWM_GPIO,         \
+        .dir_pin      = (gpio_num_t)CONFIG_##prefix##_DIR_GPIO,         \
+        .ledc_channel = (ledc_channel_t)(LEDC_CHANNEL_0 + (idx)),       \
+        .side         = (sd),                                           \
+        .invert       = MOTOR_KCONFIG_BOOL(CONFIG_##prefix##_INVERT),   \
+        .max_percent  = CONFIG_##prefix##_MAX_PERCENT,                  \
+    }
+
+static const motor_channel_cfg_t MOTOR_DRAM_ATTR k_channels[MOTOR_CHANNEL_COUNT] = {
+    MOTOR_CHANNEL(0, MOTOR1, MOTOR_SIDE_LEFT),
+    MOTOR_CHANNEL(1, MOTOR2, MOTOR_SIDE_RIGHT),
+#if MOTOR_DRIVE_CHANNELS >= 3
+    MOTOR_CHANNEL(2, MOTOR3, MOTOR_SIDE_LEFT),
+#endif
+#if MOTOR_DRIVE_CHANNELS >= 4
+    MOTOR_CHANNEL(3, MOTOR4, MOTOR_SIDE_RIGHT),
+#endif
+#if MOTOR_AUX_CHANNELS >= 1
+    MOTOR_CHANNEL(MOTOR_DRIVE_CHANNELS + 0, MOTOR_AUX1, MOTOR_SIDE_AUX),
+#endif
+#if MOTOR_AUX_CHANNELS >= 2
+    MOTOR_CHANNEL(MOTOR_DRIVE_CHANNELS + 1, MOTOR_AUX2, MOTOR_SIDE_AUX),
+#endif
+};
+
+_Static_assert(MOTOR_CHANNEL_COUNT <= LEDC_CHANNEL_MAX,
+               "not enough LEDC channels for the configured motors");
+
+/* Left/right drive channels are 0 and 1 — used for the speed read‑back */
+#define MOTOR_CH_LEFT   0
+#define MOTOR_CH_RIGHT  1
+
+#if CONFIG_MOTOR_ENCODERS
+/* Encoder counts in one nominal tick → Q8 percent of full speed, Q16 */
+#define MOTOR_ENC_Q_PER_COUNT_Q16                                       \
+    (((int64_t)MOTOR_Q_FULL * 1000 << 16) /                             \
+     ((int64_t)CONFIG_MOTOR_ENCODER_FULL_SPEED_CPS * MOTOR_TASK_PERIOD_MS))
+#endif
 
 /*---------------------------------------------------------------------
  * Internal state
  *-------------------------------------------------------------------*/
-static volatile int16_t g_target_left  = 0;          // last commanded value
-static volatile int16_t g_target_right = 0;
-static int16_t g_actual_left  = 0;                  // what we output now
-static int16_t g_actual_right = 0;
-static int64_t g_last_cmd_us  = 0;                  // for watchdog
+static int16_t g_target[MOTOR_CHANNEL_COUNT];          // current target
+static int16_t g_actual[MOTOR_CHANNEL_COUNT];          // what we output now (%)
+static int32_t g_actual_q[MOTOR_CHANNEL_COUNT];        // same, Q8 — slew state
+static int64_t g_aux_last_cmd_us = 0;                  // aux watchdog
+static cmd_arbiter_t g_arbiter;                        // drive command sources
+static cmd_playout_t g_playout;                        // owner's commands
+static twist_mix_cfg_t g_twist;                        // (v, ω) → left/right
+static portMUX_TYPE g_cmd_lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint32_t g_lockout = 0;               // motor_lock_t, commands ignored
+static volatile int16_t g_drive_cap[2] = {100, 100};   // overcurrent cutback (%)
+static volatile int16_t g_speed_limit = 100;           // degraded link, network sources (%)
+
+/* Duty tables: two per drive channel, the tick reads g_lut[]; an update
+ * builds the idle one and swaps the pointer. */
+static uint16_t g_lut_buf[MOTOR_DRIVE_CHANNELS][2][MOTOR_LUT_SIZE];
+static const uint16_t *volatile MOTOR_DRAM_ATTR g_lut[MOTOR_DRIVE_CHANNELS];
+static motor_cal_t g_cal[MOTOR_DRIVE_CHANNELS];
+static uint32_t g_lut_swap_tick[MOTOR_DRIVE_CHANNELS];  // g_tick_count at the last swap
+static bool g_lut_swapped[MOTOR_DRIVE_CHANNELS];
+
+#if CONFIG_MOTOR_ENCODERS
+static bool g_closed_loop = false;                     // encoders came up
+static speed_ctrl_t g_speed[2];                        // left, right
+static int32_t g_enc_prev[2];                          // counts at last tick
+static int32_t g_duty_q[MOTOR_CHANNEL_COUNT];          // closed‑loop output, Q8
+#endif
+
+/* Tick timing (written only by motor_timer_cb) */
+static uint32_t g_tick_count = 0;
+static uint64_t g_tick_cycles = 0;
+static uint32_t g_tick_max_cycles = 0;
+static int64_t  g_tick_prev_us = 0;
+static uint32_t g_tick_max_late_us = 0;
+static atomic_uint g_pwm_errors;                       // failed LEDC writes, any caller
 
 /* Forward declarations */
-static void motor_apply_speeds(int left, int right);
-static int16_t slew(int16_t cur, int16_t tgt, float delta);
+static void motor_apply_speeds(const int32_t *speeds_q, bool calibrated);
+static inline int16_t q_to_percent(int32_t q);
 static void motor_timer_cb(void *arg);
 
 /*=====================================================================
@@ -51,12 +197,11 @@ void motor_control_init(void)
     gpio_config_t io_conf = {0};
     io_conf.intr_type = GPIO_INTR_DISABLE;
     io_conf.mode      = GPIO_MODE_OUTPUT;
-    io_conf.pin_bit_mask = (1ULL << MOTOR1_DIR_PIN) | (1ULL << MOTOR2_DIR_PIN);
+    for (int i = 0; i < MOTOR_CHANNEL_COUNT; i++) {
+        io_conf.pin_bit_mask |= 1ULL << k_channels[i].dir_pin;
+    }
     gpio_config(&io_conf);
 
-    ESP_LOGI(TAG, "Motor DIR pins configured (M1 DIR=%d, M2 DIR=%d)",
-             MOTOR1_DIR_PIN, MOTOR2_DIR_PIN);
-
     /* -------- LEDC timer (shared) --------------------------------- */
     ledc_timer_config_t ledc_timer = {
         .speed_mode      = MOTOR_LEDC_SPEED_MODE,
@@ -66,50 +211,113 @@ void motor_control_init(void)
         .clk_cfg         = LEDC_AUTO_CLK
     };
     ESP_ERROR_CHECK(ledc_timer_config(&ledc_timer));
-    ESP_LOGI(TAG, "LEDC timer %d set to %d Hz, %d‑bit",
+    ESP_LOGI(TAG, "LEDC timer %d set to %d Hz, %d‑bit",
              MOTOR_PWM_TIMER, MOTOR_PWM_FREQ_HZ,
              (int)log2f((float)(1 << MOTOR_PWM_RESOLUTION)));
 
-    /* -------- LEDC channel — Motor 1 ------------------------------ */
-    ledc_channel_config_t ch1 = {
-        .speed_mode = MOTOR_LEDC_SPEED_MODE,
-        .channel    = MOTOR_PWM_CHANNEL_M1,
-        .timer_sel  = MOTOR_PWM_TIMER,
-        .intr_type  = LEDC_INTR_DISABLE,
-        .gpio_num   = MOTOR1_PWM_PIN,
-        .duty       = 0,
-        .hpoint     = 0
+    /* -------- LEDC channel per motor ------------------------------ */
+    for (int i = 0; i < MOTOR_CHANNEL_COUNT; i++) {
+        const motor_channel_cfg_t *cfg = &k_channels[i];
+        ledc_channel_config_t ch = {
+            .speed_mode = MOTOR_LEDC_SPEED_MODE,
+            .channel    = cfg->ledc_channel,
+            .timer_sel  = MOTOR_PWM_TIMER,
+            .intr_type  = LEDC_INTR_DISABLE,
+            .gpio_num   = cfg->pwm_pin,
+            .duty       = 0,
+            .hpoint     = 0
+        };
+        ESP_ERROR_CHECK(ledc_channel_config(&ch));
+        ESP_LOGI(TAG, "Channel %d: PWM=%d DIR=%d LEDC=%d side=%d%s limit=%d%%",
+                 i, cfg->pwm_pin, cfg->dir_pin, cfg->ledc_channel, cfg->side,
+                 cfg->invert ? " (inverted)" : "", cfg->max_percent);
+    }
+
+    /* -------- Duty tables (identity until motor_cal loads one) ----- */
+    for (int i = 0; i < MOTOR_DRIVE_CHANNELS; i++) {
+        motor_cal_default(&g_cal[i]);
+        motor_lut_build(&g_cal[i], (1 << MOTOR_PWM_RESOLUTION) - 1, g_lut_buf[i][0]);
+        g_lut[i] = g_lut_buf[i][0];
+    }
+
+    /* -------- Command sources, slot order = priority -------------- */
+    cmd_source_cfg_t sources[CMD_SRC_COUNT] = {
+        [CMD_SRC_ATTENDANT] = { .timeout_us = CONFIG_MOTOR_SRC_ATTENDANT_TIMEOUT_MS * 1000,
+                                .claim_neutral = true },
+        [CMD_SRC_LOCAL]     = { .timeout_us = CONFIG_MOTOR_SRC_LOCAL_TIMEOUT_MS * 1000,
+                                .release_us = CONFIG_MOTOR_SRC_LOCAL_RELEASE_MS * 1000 },
+        [CMD_SRC_MQTT]      = { .timeout_us = CONFIG_MOTOR_SRC_MQTT_TIMEOUT_MS * 1000,
+                                .claim_neutral = true },
+        [CMD_SRC_HTTP]      = { .timeout_us = CONFIG_MOTOR_SRC_HTTP_TIMEOUT_MS * 1000,
+                                .claim_neutral = true },
     };
-    ESP_ERROR_CHECK(ledc_channel_config(&ch1));
-
-    /* -------- LEDC channel — Motor 2 ------------------------------ */
-    ledc_channel_config_t ch2 = {
-        .speed_mode = MOTOR_LEDC_SPEED_MODE,
-        .channel    = MOTOR_PWM_CHANNEL_M2,
-        .timer_sel  = MOTOR_PWM_TIMER,
-        .intr_type  = LEDC_INTR_DISABLE,
-        .gpio_num   = MOTOR2_PWM_PIN,
-        .duty       = 0,
-        .hpoint     = 0
+    /* The playout watchdog zeroes a silent owner's output after at most
+     * the grace cap; ownership must not outlive it. */
+    for (int i = 0; i < CMD_SRC_COUNT; i++) {
+        if (sources[i].timeout_us > CONFIG_MOTOR_PLAYOUT_MAX_GRACE_MS * 1000) {
+            ESP_LOGW(TAG, "Source %d timeout %d ms clamped to the %d ms watchdog cap",
+                     i, (int)(sources[i].timeout_us / 1000), CONFIG_MOTOR_PLAYOUT_MAX_GRACE_MS);
+            sources[i].timeout_us = CONFIG_MOTOR_PLAYOUT_MAX_GRACE_MS * 1000;
+        }
+    }
+    cmd_arbiter_init(&g_arbiter, sources, CONFIG_MOTOR_SRC_DEADBAND_PERCENT);
+    twist_mix_init(&g_twist, CONFIG_MOTOR_TWIST_TURN_PERCENT,
+                   CONFIG_MOTOR_TWIST_MIN_PERCENT, CONFIG_MOTOR_TWIST_MAX_PERCENT);
+
+    /* -------- Playout stage for drive commands -------------------- */
+    cmd_playout_init(&g_playout,
+                     MOTOR_DECAY_MS * 1000,
+                     CONFIG_MOTOR_PLAYOUT_MAX_GRACE_MS * 1000,
+                     CONFIG_MOTOR_PLAYOUT_MAX_EXTRAP_MS * 1000);
+
+#if CONFIG_MOTOR_ENCODERS
+    /* -------- Encoders + speed loop (open loop if they fail) ------ */
+    const speed_ctrl_cfg_t scfg = {
+        .kp_q12        = SPEED_CTRL_GAIN_X100(CONFIG_MOTOR_SPEED_KP_X100),
+        .ki_q12        = SPEED_CTRL_GAIN_X100(CONFIG_MOTOR_SPEED_KI_X100) *
+                         MOTOR_TASK_PERIOD_MS / 1000,
+        .kd_q12        = SPEED_CTRL_GAIN_X100(CONFIG_MOTOR_SPEED_KD_MS * 100) /
+                         MOTOR_TASK_PERIOD_MS,
+        .kff_q12       = SPEED_CTRL_GAIN_X100(CONFIG_MOTOR_SPEED_KFF_X100),
+        .ks_q8         = CONFIG_MOTOR_SPEED_KS_PERCENT << MOTOR_Q_SHIFT,
+        .trim_q8       = CONFIG_MOTOR_SPEED_TRIM_PERCENT << MOTOR_Q_SHIFT,
+        .meas_shift    = 1,
+        .fault_duty_q8 = CONFIG_MOTOR_SPEED_TRIM_PERCENT << MOTOR_Q_SHIFT,
+        .fault_ticks   = CONFIG_MOTOR_ENCODER_FAULT_MS / MOTOR_TASK_PERIOD_MS,
     };
-    ESP_ERROR_CHECK(ledc_channel_config(&ch2));
+    speed_ctrl_init(&g_speed[0], &scfg);
+    speed_ctrl_init(&g_speed[1], &scfg);
+    if (wheel_encoder_init() == ESP_OK) {
+        wheel_encoder_get_counts(g_enc_prev);
+        g_closed_loop = true;
+        ESP_LOGI(TAG, "Closed-loop speed control: Kp %d.%02d Ki %d.%02d/s Kff %d.%02d",
+                 CONFIG_MOTOR_SPEED_KP_X100 / 100, CONFIG_MOTOR_SPEED_KP_X100 % 100,
+                 CONFIG_MOTOR_SPEED_KI_X100 / 100, CONFIG_MOTOR_SPEED_KI_X100 % 100,
+                 CONFIG_MOTOR_SPEED_KFF_X100 / 100, CONFIG_MOTOR_SPEED_KFF_X100 % 100);
+    } else {
+        ESP_LOGE(TAG, "Encoders unavailable, drive stays open loop");
+    }
+#endif
 
     /* -------- Make sure we start stopped -------------------------- */
     motor_emergency_stop();
 
-    /* -------- Start the 10 ms control timer ----------------------- */
+    /* -------- Start the periodic control timer -------------------- */
     esp_timer_handle_t h;
     const esp_timer_create_args_t targs = {
-        .callback = motor_timer_cb,
-        .name     = "motor_ctrl"
+        .callback        = motor_timer_cb,
+        .dispatch_method = MOTOR_TIMER_DISPATCH,
+        .name            = "motor_ctrl"
     };
     ESP_ERROR_CHECK(esp_timer_create(&targs, &h));
     ESP_ERROR_CHECK(esp_timer_start_periodic(h, MOTOR_TASK_PERIOD_MS * 1000));
 
-    ESP_LOGI(TAG, "Motor control initialised; watchdog active");
+    ESP_LOGI(TAG, "Motor control initialised (%d drive + %d aux, %s dispatch); watchdog active",
+             MOTOR_DRIVE_CHANNELS, MOTOR_AUX_CHANNELS,
+             MOTOR_TIMER_DISPATCH == ESP_TIMER_ISR ? "ISR/IRAM" : "task");
 }
 
-void motor_set_speeds(int left_speed, int right_speed)
+void motor_submit_speeds(cmd_source_t src, int left_speed, int right_speed)
 {
     /* clip */
     if (left_speed  > 100) left_speed  = 100;
@@ -117,74 +325,367 @@ void motor_set_speeds(int left_speed, int right_speed)
     if (right_speed > 100) right_speed = 100;
     if (right_speed < -100) right_speed = -100;
 
-    g_target_left  = left_speed;
-    g_target_right = right_speed;
-    g_last_cmd_us  = esp_timer_get_time();
+    if (g_lockout) return;
+    cmd_arbiter_submit(&g_arbiter, src, esp_timer_get_time(), left_speed, right_speed);
 
-    ESP_LOGD(TAG, "Cmd rx: L=%d R=%d (%%)", left_speed, right_speed);
+    DLOGD(TAG, "Cmd rx from %d: L=%d R=%d (%%)", src, left_speed, right_speed);
+}
+
+void motor_submit_twist(cmd_source_t src, int v, int w)
+{
+    int32_t wheels_q[2];
+
+    if (v > 100) v = 100;
+    if (v < -100) v = -100;
+    if (w > 100) w = 100;
+    if (w < -100) w = -100;
+
+    twist_mix(&g_twist, (int32_t)v << MOTOR_Q_SHIFT, (int32_t)w << MOTOR_Q_SHIFT, wheels_q);
+    if (g_lockout) return;
+    cmd_arbiter_submit(&g_arbiter, src, esp_timer_get_time(),
+                       q_to_percent(wheels_q[0]), q_to_percent(wheels_q[1]));
+
+    DLOGD(TAG, "Twist rx from %d: v=%d w=%d (%%)", src, v, w);
+}
+
+esp_err_t motor_set_calibration(int channel, const motor_cal_t *cal)
+{
+    if (channel < 0 || channel >= MOTOR_DRIVE_CHANNELS || !cal || !motor_cal_valid(cal)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    /* the tick that may still read the idle table ends with g_tick_count++ */
+    if (g_lut_swapped[channel] && g_tick_count == g_lut_swap_tick[channel]) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint16_t *idle = g_lut[channel] == g_lut_buf[channel][0] ? g_lut_buf[channel][1]
+                                                             : g_lut_buf[channel][0];
+    motor_lut_build(cal, (1 << MOTOR_PWM_RESOLUTION) - 1, idle);
+
+    portENTER_CRITICAL(&g_cmd_lock);
+    g_lut[channel] = idle;
+    g_cal[channel] = *cal;
+    g_lut_swap_tick[channel] = g_tick_count;
+    g_lut_swapped[channel] = true;
+    portEXIT_CRITICAL(&g_cmd_lock);
+
+    ESP_LOGI(TAG, "Channel %d calibration: deadband %d.%d %%, gain %d ‰, duty at 50 %% = %d",
+             channel, cal->deadband_pm / 10, cal->deadband_pm % 10, cal->gain_pm,
+             idle[MOTOR_LUT_SIZE / 2]);
+    return ESP_OK;
+}
+
+void motor_get_calibration(int channel, motor_cal_t *out)
+{
+    if (channel < 0 || channel >= MOTOR_DRIVE_CHANNELS || !out) return;
+    portENTER_CRITICAL(&g_cmd_lock);
+    *out = g_cal[channel];
+    portEXIT_CRITICAL(&g_cmd_lock);
+}
+
+void motor_set_aux(int index, int percent)
+{
+    if (index < 0 || index >= MOTOR_AUX_CHANNELS) return;
+
+    if (percent > 100) percent = 100;
+    if (percent < -100) percent = -100;
+
+    portENTER_CRITICAL(&g_cmd_lock);
+    if (!g_lockout) {
+        g_target[MOTOR_DRIVE_CHANNELS + index] = percent;
+        g_aux_last_cmd_us = esp_timer_get_time();
+    }
+    portEXIT_CRITICAL(&g_cmd_lock);
 }
 
 void motor_get_speeds(int *left_speed, int *right_speed)
 {
-    if (left_speed)  *left_speed  = g_actual_left;
-    if (right_speed) *right_speed = g_actual_right;
+    if (left_speed)  *left_speed  = g_actual[MOTOR_CH_LEFT];
+    if (right_speed) *right_speed = g_actual[MOTOR_CH_RIGHT];
+}
+
+void motor_get_source_stats(cmd_arbiter_stats_t *stats)
+{
+    if (!stats) return;
+    portENTER_CRITICAL(&g_cmd_lock);
+    *stats = g_arbiter.stats;
+    portEXIT_CRITICAL(&g_cmd_lock);
+}
+
+void motor_get_tick_stats(motor_tick_stats_t *stats)
+{
+    if (!stats) return;
+    const uint32_t cycles_per_us = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    portENTER_CRITICAL(&g_cmd_lock);
+    stats->ticks    = g_tick_count;
+    stats->total_us = g_tick_cycles / cycles_per_us;
+    stats->max_us   = g_tick_max_cycles / cycles_per_us;
+    stats->max_late_us = g_tick_max_late_us;
+    stats->pwm_errors  = atomic_load_explicit(&g_pwm_errors, memory_order_relaxed);
+    portEXIT_CRITICAL(&g_cmd_lock);
 }
 
 void motor_emergency_stop(void)
 {
     ESP_LOGW(TAG, "EMERGENCY STOP");
-    g_target_left   = 0;
-    g_target_right  = 0;
-    g_actual_left   = 0;
-    g_actual_right  = 0;
-    g_last_cmd_us   = esp_timer_get_time();
-    motor_apply_speeds(0, 0);
+    portENTER_CRITICAL(&g_cmd_lock);
+    cmd_playout_reset(&g_playout);
+    for (int i = 0; i < MOTOR_CHANNEL_COUNT; i++) {
+        g_target[i]   = 0;
+        g_actual[i]   = 0;
+        g_actual_q[i] = 0;
+    }
+#if CONFIG_MOTOR_ENCODERS
+    speed_ctrl_reset(&g_speed[0]);
+    speed_ctrl_reset(&g_speed[1]);
+    for (int i = 0; i < MOTOR_CHANNEL_COUNT; i++) g_duty_q[i] = 0;
+#endif
+    portEXIT_CRITICAL(&g_cmd_lock);
+    motor_apply_speeds(g_actual_q, true);
+}
+
+void motor_set_lockout(motor_lock_t reason, bool on)
+{
+    portENTER_CRITICAL(&g_cmd_lock);
+    uint32_t was = g_lockout;
+    g_lockout = on ? was | reason : was & ~(uint32_t)reason;
+    portEXIT_CRITICAL(&g_cmd_lock);
+    if (on) {
+        motor_emergency_stop();
+    }
+    ESP_LOGW(TAG, "Command lockout 0x%" PRIx32 " %s (now 0x%" PRIx32 ")",
+             (uint32_t)reason, on ? "engaged" : "released", g_lockout);
+}
+
+uint32_t motor_get_lockout(void)
+{
+    return g_lockout;
+}
+
+void motor_expire_source(cmd_source_t src)
+{
+    cmd_arbiter_expire(&g_arbiter, src, esp_timer_get_time());
+    ESP_LOGI(TAG, "Drive source %s expired", cmd_source_name(src));
+}
+
+void motor_set_drive_cap(int left_percent, int right_percent)
+{
+    const int caps[2] = {left_percent, right_percent};
+
+    portENTER_CRITICAL(&g_cmd_lock);
+    for (int s = 0; s < 2; s++) {
+        int cap = caps[s] < 0 ? 0 : (caps[s] > 100 ? 100 : caps[s]);
+        g_drive_cap[s] = (int16_t)cap;
+
+        /* Drop the slew state to the cap now: the next tick applies the
+         * reduced duty directly instead of ramping down to it. */
+        int32_t cap_q = (int32_t)cap << MOTOR_Q_SHIFT;
+        for (int i = 0; i < MOTOR_DRIVE_CHANNELS; i++) {
+            if ((int)k_channels[i].side != s) continue;
+            if (g_actual_q[i] >  cap_q) g_actual_q[i] =  cap_q;
+            if (g_actual_q[i] < -cap_q) g_actual_q[i] = -cap_q;
+        }
+    }
+    portEXIT_CRITICAL(&g_cmd_lock);
+}
+
+void motor_set_speed_limit(int percent)
+{
+    if (percent < 0)   percent = 0;
+    if (percent > 100) percent = 100;
+    if (g_speed_limit == percent) return;
+    g_speed_limit = (int16_t)percent;
+    ESP_LOGW(TAG, "Drive speed limit %d %%", percent);
 }
 
 /*=====================================================================
  * Internal helpers
  *====================================================================*/
 
-/* convert ±100 % → PWM + DIR */
-static void motor_apply_speeds(int left, int right)
+/* convert ±100 % (Q8) → PWM + DIR for every channel; drive channels go
+ * through their duty tables when @calibrated, else duty ∝ command */
+static void MOTOR_IRAM_ATTR motor_apply_speeds(const int32_t *speeds_q, bool calibrated)
 {
     const uint32_t max_duty = (1 << MOTOR_PWM_RESOLUTION) - 1;
 
-    /* ---------------- Motor 1 ---------------- */
-    uint32_t duty1 = (uint32_t)(fabsf((float)left) * max_duty / 100.0f);
-    int dir1 = (left < 0) ? 1 : 0;   // 0 = forward, 1 = reverse
-    gpio_set_level(MOTOR1_DIR_PIN, dir1);
-    ESP_ERROR_CHECK(ledc_set_duty(MOTOR_LEDC_SPEED_MODE, MOTOR_PWM_CHANNEL_M1, duty1));
-    ESP_ERROR_CHECK(ledc_update_duty(MOTOR_LEDC_SPEED_MODE, MOTOR_PWM_CHANNEL_M1));
+    for (int i = 0; i < MOTOR_CHANNEL_COUNT; i++) {
+        const motor_channel_cfg_t *cfg = &k_channels[i];
+        int32_t limit = cfg->max_percent;
+        if (cfg->side != MOTOR_SIDE_AUX && g_drive_cap[cfg->side] < limit) {
+            limit = g_drive_cap[cfg->side];
+        }
+        limit <<= MOTOR_Q_SHIFT;
+        int32_t speed = speeds_q[i];
+        if (speed >  limit) speed =  limit;
+        if (speed < -limit) speed = -limit;
 
-    /* ---------------- Motor 2 ---------------- */
-    uint32_t duty2 = (uint32_t)(fabsf((float)right) * max_duty / 100.0f);
-    int dir2 = (right < 0) ? 1 : 0;
-    gpio_set_level(MOTOR2_DIR_PIN, dir2);
-    ESP_ERROR_CHECK(ledc_set_duty(MOTOR_LEDC_SPEED_MODE, MOTOR_PWM_CHANNEL_M2, duty2));
-    ESP_ERROR_CHECK(ledc_update_duty(MOTOR_LEDC_SPEED_MODE, MOTOR_PWM_CHANNEL_M2));
+        uint32_t mag  = (uint32_t)(speed < 0 ? -speed : speed);
+        uint32_t duty = calibrated && i < MOTOR_DRIVE_CHANNELS ? g_lut[i][motor_lut_index(mag)]
+                                                               : mag * max_duty / MOTOR_Q_FULL;
+        int dir = ((speed < 0) != cfg->invert) ? 1 : 0;  // 0 = forward, 1 = reverse
+        gpio_set_level(cfg->dir_pin, dir);
+        /* Runs from the tick (ISR with CONFIG_MOTOR_CONTROL_IN_IRAM):
+         * count a failure and keep going, never abort mid-drive. */
+        esp_err_t err = ledc_set_duty(MOTOR_LEDC_SPEED_MODE, cfg->ledc_channel, duty);
+        if (err == ESP_OK) err = ledc_update_duty(MOTOR_LEDC_SPEED_MODE, cfg->ledc_channel);
+        if (err != ESP_OK) atomic_fetch_add_explicit(&g_pwm_errors, 1, memory_order_relaxed);
+    }
 }
 
 /* first‑order slew filter — limit to ±delta per tick */
-static int16_t slew(int16_t cur, int16_t tgt, float delta)
+static inline int32_t MOTOR_IRAM_ATTR slew(int32_t cur_q, int32_t tgt_q, int32_t delta_q)
+{
+    int32_t diff = tgt_q - cur_q;
+    if (diff > delta_q)  return cur_q + delta_q;
+    if (diff < -delta_q) return cur_q - delta_q;
+    return tgt_q;
+}
+
+/* Q8 → whole percent, rounded half away from zero */
+static inline int16_t MOTOR_IRAM_ATTR q_to_percent(int32_t q)
 {
-    float diff = (float)tgt - (float)cur;
-    if (fabsf(diff) <= delta) return tgt;
-    if (diff > 0) return (int16_t)roundf((float)cur + delta);
-    return (int16_t)roundf((float)cur - delta);
+    const int32_t half = 1 << (MOTOR_Q_SHIFT - 1);
+    return (int16_t)(q >= 0 ? (q + half) >> MOTOR_Q_SHIFT
+                            : -((-q + half) >> MOTOR_Q_SHIFT));
 }
 
-/* 10 ms periodic callback */
-static void motor_timer_cb(void *arg)
+#if CONFIG_MOTOR_ENCODERS
+/* Speed loop: slewed outputs are per‑side speed references; fills
+ * g_duty_q for every channel (aux channels stay open loop). */
+static void MOTOR_IRAM_ATTR motor_speed_loop(void)
 {
-    int64_t age_us = esp_timer_get_time() - g_last_cmd_us;
-    if (age_us >= MOTOR_DECAY_MS * 1000) {
-        g_target_left  = 0;
-        g_target_right = 0;
+    static uint32_t reported_faults[2];
+    int32_t counts[2], out_q[2];
+    wheel_encoder_get_counts(counts);
+
+    for (int s = 0; s < 2; s++) {
+        const int ch = s == 0 ? MOTOR_CH_LEFT : MOTOR_CH_RIGHT;
+        /* nominal tick length; the filter absorbs dispatch jitter */
+        int32_t delta = (int32_t)((uint32_t)counts[s] - (uint32_t)g_enc_prev[s]);
+        g_enc_prev[s] = counts[s];
+        int32_t meas_q = (int32_t)((delta * MOTOR_ENC_Q_PER_COUNT_Q16) >> 16);
+
+        int32_t limit = k_channels[ch].max_percent;
+        if (g_drive_cap[s] < limit) limit = g_drive_cap[s];
+        out_q[s] = speed_ctrl_update(&g_speed[s], g_actual_q[ch], meas_q,
+                                     limit << MOTOR_Q_SHIFT);
+
+        if (g_speed[s].faults != reported_faults[s]) {
+            reported_faults[s] = g_speed[s].faults;
+            DLOGE(TAG, "Encoder %d (0=left): no motion at %d %% output, open loop until it moves",
+                  s, (int)(out_q[s] >> MOTOR_Q_SHIFT));
+        }
     }
 
-    g_actual_left  = slew(g_actual_left,  g_target_left,  MOTOR_SLEW_DELTA);
-    g_actual_right = slew(g_actual_right, g_target_right, MOTOR_SLEW_DELTA);
+    for (int i = 0; i < MOTOR_CHANNEL_COUNT; i++) {
+        g_duty_q[i] = k_channels[i].side == MOTOR_SIDE_AUX ? g_actual_q[i]
+                                                           : out_q[k_channels[i].side];
+    }
+}
+#endif
 
-    motor_apply_speeds(g_actual_left, g_actual_right);
+/* periodic control callback (ISR context with CONFIG_MOTOR_CONTROL_IN_IRAM) */
+static void MOTOR_IRAM_ATTR motor_timer_cb(void *arg)
+{
+    static uint32_t reported_expiries = 0;
+    static uint32_t reported_pwm_errors = 0;
+    uint32_t start_cycles = esp_cpu_get_cycle_count();
+    int64_t now = esp_timer_get_time();
+    int16_t drive[CMD_PLAYOUT_CHANNELS];
+    cmd_pick_t pick;
+
+    portENTER_CRITICAL_SAFE(&g_cmd_lock);
+    cmd_arbiter_select(&g_arbiter, now, &pick);
+    if (pick.switched) {
+        cmd_playout_reset(&g_playout);          // new stream, no trend to extend
+    }
+    if (pick.fresh && !g_lockout) {
+        cmd_playout_push(&g_playout, pick.stamp_us, pick.value[0], pick.value[1]);
+    }
+    cmd_playout_sample(&g_playout, now, drive);
+    if (g_lockout) {
+        drive[0] = drive[1] = 0;                // whichever source owns the slot
+    }
+    if (pick.source == CMD_SRC_MQTT || pick.source == CMD_SRC_HTTP) {
+        twist_limit(drive, g_speed_limit);      // keeps the left/right ratio
+    }
+    for (int i = 0; i < MOTOR_DRIVE_CHANNELS; i++) {
+        g_target[i] = (k_channels[i].side == MOTOR_SIDE_LEFT) ? drive[0] : drive[1];
+    }
+    if (now - g_aux_last_cmd_us >= MOTOR_DECAY_MS * 1000) {
+        for (int i = MOTOR_DRIVE_CHANNELS; i < MOTOR_CHANNEL_COUNT; i++) {
+            g_target[i] = 0;
+        }
+    }
+    portEXIT_CRITICAL_SAFE(&g_cmd_lock);
+
+    if (pick.switched) {
+        DLOGI(TAG, "Drive source %d -> %d (switch %d us, handover %d us)",
+              g_arbiter.stats.prev_owner, pick.source,
+              g_arbiter.stats.last_switch_us, g_arbiter.stats.last_handover_us);
+    }
+    if (g_playout.expiries != reported_expiries) {
+        reported_expiries = g_playout.expiries;
+        DLOGW(TAG, "Command watchdog expired (grace %d ms, jitter %d ms)",
+              cmd_playout_grace_us(&g_playout) / 1000,
+              g_playout.jitter_us / 1000);
+    }
+
+    for (int i = 0; i < MOTOR_CHANNEL_COUNT; i++) {
+        g_actual_q[i] = slew(g_actual_q[i], (int32_t)g_target[i] << MOTOR_Q_SHIFT,
+                             MOTOR_SLEW_DELTA_Q);
+        g_actual[i]   = q_to_percent(g_actual_q[i]);
+    }
+
+#if CONFIG_MOTOR_ENCODERS
+    if (g_closed_loop) {
+        /* The loop's Ks already lifts the output out of the deadband and
+         * its feedback does the curve/gain's job: the duty tables would
+         * stack a second deadband on Ks and change the loop gain. */
+        motor_speed_loop();
+        motor_apply_speeds(g_duty_q, false);
+    } else
+#endif
+    motor_apply_speeds(g_actual_q, true);
+
+    uint32_t pwm_errors = atomic_load_explicit(&g_pwm_errors, memory_order_relaxed);
+    if (pwm_errors != reported_pwm_errors) {
+        DLOGE(TAG, "%d PWM duty writes failed (%d since boot)",
+              (int32_t)(pwm_errors - reported_pwm_errors), (int32_t)pwm_errors);
+        reported_pwm_errors = pwm_errors;
+    }
+
+    /* lateness = how far past its period this tick started */
+    uint32_t cycles = esp_cpu_get_cycle_count() - start_cycles;
+    int64_t  late   = g_tick_prev_us ? now - g_tick_prev_us - MOTOR_TASK_PERIOD_MS * 1000 : 0;
+    g_tick_prev_us  = now;
+    portENTER_CRITICAL_SAFE(&g_cmd_lock);
+    g_tick_count++;
+    g_tick_cycles += cycles;
+    if (cycles > g_tick_max_cycles) g_tick_max_cycles = cycles;
+    if (late > (int64_t)g_tick_max_late_us) g_tick_max_late_us = (uint32_t)late;
+    portEXIT_CRITICAL_SAFE(&g_cmd_lock);
+}
+
+#if CONFIG_BENCH_SUITE
+/*=====================================================================
+ * Benchmark hooks
+ *====================================================================*/
+
+void motor_bench_slew(void)
+{
+    static int32_t q[MOTOR_CHANNEL_COUNT];
+    static int32_t tgt_q = MOTOR_Q_FULL;         // ramps full scale back and forth
+
+    for (int i = 0; i < MOTOR_CHANNEL_COUNT; i++) {
+        q[i] = slew(q[i], tgt_q, MOTOR_SLEW_DELTA_Q);
+    }
+    if (q[0] == tgt_q) tgt_q = -tgt_q;
+}
+
+void motor_bench_apply(void)
+{
+    static const int32_t zero[MOTOR_CHANNEL_COUNT];
+    motor_apply_speeds(zero, true);
 }
+#endif /* CONFIG_BENCH_SUITE */
@@ -7,65 +7,70 @@
 #ifndef MOTOR_CONTROL_H
 #define MOTOR_CONTROL_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include "sdkconfig.h"
 #include "driver/gpio.h"
 #include "driver/ledc.h"
+#include "esp_err.h"
+#include "cmd_arbiter.h"
+#include "motor_lut.h"
 
 /*---------------------------------------------------------------------
- * Hardware pin mapping — adjust to your wiring
+ * Channel layout — see "Wheelchair motor configuration" in menuconfig
+ * (pins, inversion and per‑channel limits live in the channel table
+ * in motor_control.c)
  *-------------------------------------------------------------------*/
-
-/* Motor 1 */
-#ifndef MOTOR1_PWM_PIN
-#define MOTOR1_PWM_PIN      GPIO_NUM_23   /* PWM input */
-#endif
-#ifndef MOTOR1_DIR_PIN
-#define MOTOR1_DIR_PIN      GPIO_NUM_22   /* DIR input */
-#endif
-
-/* Motor 2 */
-#ifndef MOTOR2_PWM_PIN
-#define MOTOR2_PWM_PIN      GPIO_NUM_18   /* PWM input */
-#endif
-#ifndef MOTOR2_DIR_PIN
-#define MOTOR2_DIR_PIN      GPIO_NUM_19   /* DIR input */
-#endif
+#define MOTOR_DRIVE_CHANNELS    CONFIG_MOTOR_DRIVE_CHANNELS
+#define MOTOR_AUX_CHANNELS      CONFIG_MOTOR_AUX_CHANNELS
+#define MOTOR_CHANNEL_COUNT     (MOTOR_DRIVE_CHANNELS + MOTOR_AUX_CHANNELS)
 
 /*---------------------------------------------------------------------
- * PWM/LEDC configuration (shared timer)
+ * PWM/LEDC configuration (shared timer, channel N uses LEDC_CHANNEL_N)
  *-------------------------------------------------------------------*/
 #ifndef MOTOR_LEDC_SPEED_MODE
-#define MOTOR_LEDC_SPEED_MODE   LEDC_LOW_SPEED_MODE  /* < 80 MHz/2^res */
+#define MOTOR_LEDC_SPEED_MODE   LEDC_LOW_SPEED_MODE  /* < 80 MHz/2^res */
 #endif
 #ifndef MOTOR_PWM_TIMER
 #define MOTOR_PWM_TIMER         LEDC_TIMER_0
 #endif
-#ifndef MOTOR_PWM_CHANNEL_M1
-#define MOTOR_PWM_CHANNEL_M1    LEDC_CHANNEL_0
-#endif
-#ifndef MOTOR_PWM_CHANNEL_M2
-#define MOTOR_PWM_CHANNEL_M2    LEDC_CHANNEL_1
-#endif
 #ifndef MOTOR_PWM_RESOLUTION
 #define MOTOR_PWM_RESOLUTION    LEDC_TIMER_10_BIT     /* 0‑1023 */
 #endif
 #ifndef MOTOR_PWM_FREQ_HZ
-#define MOTOR_PWM_FREQ_HZ       5000                  /* 5 kHz */
+#define MOTOR_PWM_FREQ_HZ       CONFIG_MOTOR_PWM_FREQ_HZ
 #endif
 
 /*---------------------------------------------------------------------
  * Control‑loop timing (may be overridden before include)
  *-------------------------------------------------------------------*/
 #ifndef MOTOR_DECAY_MS
-#define MOTOR_DECAY_MS          300   /* watchdog timeout → target 0 */
+#define MOTOR_DECAY_MS          CONFIG_MOTOR_DECAY_MS        /* watchdog timeout → target 0 */
 #endif
 #ifndef MOTOR_TASK_PERIOD_MS
-#define MOTOR_TASK_PERIOD_MS    10    /* control loop period */
+#define MOTOR_TASK_PERIOD_MS    CONFIG_MOTOR_TASK_PERIOD_MS  /* control loop period */
 #endif
 
 /*=====================================================================
  * Public API
  *====================================================================*/
 
+/** Control‑tick timing, cumulative since boot. */
+typedef struct {
+    uint32_t ticks;         /* motor_timer_cb invocations */
+    uint64_t total_us;      /* time spent inside motor_timer_cb */
+    uint32_t max_us;        /* longest single invocation */
+    uint32_t max_late_us;   /* worst start delay past the tick period */
+    uint32_t pwm_errors;    /* LEDC duty writes that failed (counted, never abort) */
+} motor_tick_stats_t;
+
+/** Why the drive is locked out; each reason is engaged and released on
+ *  its own, commands stay ignored while any is set. */
+typedef enum {
+    MOTOR_LOCK_UPDATE = 1 << 0,     // firmware update in progress
+    MOTOR_LOCK_ESTOP  = 1 << 1,     // emergency stop latched (STOP)
+} motor_lock_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -74,18 +79,102 @@ extern "C" {
 void motor_control_init(void);
 
 /**
- * Set desired wheel speeds.
+ * Submit desired wheel speeds from one command source. Lock‑free; each
+ * source must be submitted from a single task. Only the source that
+ * currently owns the drive (cmd_arbiter.h) moves the chair.
+ * @param src          command source
  * @param left_speed   −100 … +100 (percent) — positive = forward
  * @param right_speed  −100 … +100 (percent) — positive = forward
  */
-void motor_set_speeds(int left_speed, int right_speed);
+void motor_submit_speeds(cmd_source_t src, int left_speed, int right_speed);
 
-/** Get the *actual* output speeds currently driven (‑100 … +100). */
+/**
+ * Submit a twist (forward speed, turn rate) from one command source;
+ * mixed to wheel speeds here with the turn radius kept under
+ * saturation (twist_mix.h, CONFIG_MOTOR_TWIST_*). Same ownership and
+ * threading rules as motor_submit_speeds().
+ * @param src  command source
+ * @param v    −100 … +100 (percent) — positive = forward
+ * @param w    −100 … +100 (percent) — positive = turn left (right
+ *             wheel faster)
+ */
+void motor_submit_twist(cmd_source_t src, int v, int w);
+
+/**
+ * Replace a drive channel's output calibration (deadband, curve, gain)
+ * and rebuild its duty table; takes effect on the next tick. Call from
+ * one task. Not persistent — motor_cal.c stores calibrations in NVS.
+ * Open loop only: with the encoder speed loop running the duty is
+ * linear and the loop's own Ks/feedback take the calibration's place.
+ * @param channel  drive channel, 0 … MOTOR_DRIVE_CHANNELS‑1
+ * @return ESP_OK, ESP_ERR_INVALID_ARG (channel or calibration out of
+ *         range) or ESP_ERR_INVALID_STATE (previous update on this
+ *         channel less than a tick ago — retry)
+ */
+esp_err_t motor_set_calibration(int channel, const motor_cal_t *cal);
+
+/** The calibration in use on a drive channel. */
+void motor_get_calibration(int channel, motor_cal_t *out);
+
+/** Active drive source, switch count and latencies. */
+void motor_get_source_stats(cmd_arbiter_stats_t *stats);
+
+/** Get the *actual* (slewed) output speeds, −100 … +100: the duty open
+ *  loop, the wheel speed reference with CONFIG_MOTOR_ENCODERS. */
 void motor_get_speeds(int *left_speed, int *right_speed);
 
+/**
+ * Set the target of an auxiliary actuator channel.
+ * @param index    0 … MOTOR_AUX_CHANNELS‑1
+ * @param percent  −100 … +100
+ */
+void motor_set_aux(int index, int percent);
+
+/** Snapshot the control‑tick timing statistics. */
+void motor_get_tick_stats(motor_tick_stats_t *stats);
+
 /** Immediate brake (sets target & actual to zero). */
 void motor_emergency_stop(void);
 
+/**
+ * Hold all outputs at zero and ignore every command source while
+ * @p reason is set. Engaging it brakes immediately.
+ */
+void motor_set_lockout(motor_lock_t reason, bool on);
+
+/** Lockout reasons currently set (motor_lock_t bits, 0 = none). */
+uint32_t motor_get_lockout(void);
+
+/**
+ * Stop driving from @p src until it sends again (its link is gone);
+ * other sources are unaffected. Call from the source's own task, or
+ * once that task can no longer submit.
+ */
+void motor_expire_source(cmd_source_t src);
+
+/**
+ * Cap the drive output per side below the channels' own limits
+ * (overcurrent cutback from power_sense). 100 removes the cap; a lower
+ * cap takes effect on the next tick without slewing down.
+ */
+void motor_set_drive_cap(int left_percent, int right_percent);
+
+/**
+ * Limit the drive targets to ±@p percent while a network source (MQTT,
+ * HTTP) owns the drive, i.e. the degraded control link is the one in
+ * use; the wired joystick and the attendant are not limited. Unlike
+ * the drive cap this is reached through the normal slew.
+ * 100 removes the limit.
+ */
+void motor_set_speed_limit(int percent);
+
+#if CONFIG_BENCH_SUITE
+/* Benchmark hooks (bench.c): one slew pass over private state, and one
+ * apply pass writing zero duty to every channel. */
+void motor_bench_slew(void);
+void motor_bench_apply(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,48 @@
+/*=====================================================================
+ * motor_lut.c — Calibration checks and LUT construction (boot / update)
+ *====================================================================*/
+
+#include "motor_lut.h"
+
+#define KNOT_STEPS  ((MOTOR_LUT_SIZE - 1) / (MOTOR_CAL_POINTS - 1))    /* 40 */
+
+_Static_assert((MOTOR_LUT_SIZE - 1) % (MOTOR_CAL_POINTS - 1) == 0,
+               "LUT steps must fall evenly between curve knots");
+
+void motor_cal_default(motor_cal_t *cal)
+{
+    cal->deadband_pm = 0;
+    cal->gain_pm = 1000;
+    for (int k = 0; k < MOTOR_CAL_POINTS; k++) {
+        cal->curve_pm[k] = (uint16_t)(k * 1000 / (MOTOR_CAL_POINTS - 1));
+    }
+}
+
+bool motor_cal_valid(const motor_cal_t *cal)
+{
+    if (cal->deadband_pm > MOTOR_CAL_DEADBAND_MAX) return false;
+    if (cal->gain_pm < MOTOR_CAL_GAIN_MIN || cal->gain_pm > MOTOR_CAL_GAIN_MAX) return false;
+    for (int k = 0; k < MOTOR_CAL_POINTS; k++) {
+        if (cal->curve_pm[k] > 1000) return false;
+        if (k && cal->curve_pm[k] < cal->curve_pm[k - 1]) return false;
+    }
+    return true;
+}
+
+void motor_lut_build(const motor_cal_t *cal, uint32_t max_duty, uint16_t *lut)
+{
+    const int64_t span = 1000 - cal->deadband_pm;
+
+    lut[0] = 0;
+    for (int i = 1; i < MOTOR_LUT_SIZE; i++) {
+        int k = i / KNOT_STEPS, f = i % KNOT_STEPS;
+        int64_t y = (int64_t)cal->curve_pm[k] * (KNOT_STEPS - f);          // ‰ × KNOT_STEPS
+        if (f) y += (int64_t)cal->curve_pm[k + 1] * f;
+
+        /* duty in ppm: deadband + span · y · gain (scaled back from ‰³) */
+        int64_t ppm = (int64_t)cal->deadband_pm * 1000 +
+                      span * y * cal->gain_pm / (KNOT_STEPS * 1000);
+        if (ppm > 1000000) ppm = 1000000;
+        lut[i] = (uint16_t)((ppm * max_duty + 500000) / 1000000);
+    }
+}
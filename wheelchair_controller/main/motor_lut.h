@@ -0,0 +1,74 @@
+/*=====================================================================
+ * motor_lut.h — Per‑motor output calibration compiled into a duty LUT
+ *
+ * Command magnitude (0 … 100 %) → PWM duty counts:
+ *
+ *   duty‰ = deadband + (1000 − deadband) · curve(cmd) · gain / 10⁶
+ *
+ *  • deadband_pm: duty at which the wheel starts to turn; any non‑zero
+ *    command starts there instead of creeping through dead duty.
+ *  • curve_pm: share of the span above the deadband (0 … 1000) at
+ *    0, 10, … 100 % command, linearly interpolated — straightens the
+ *    motor's torque/speed curve.  Non‑decreasing.
+ *  • gain_pm: scales the span (1000 = unity) so the faster side can be
+ *    trimmed to the slower one.  Results above full duty are clipped.
+ *
+ * The table has an entry per MOTOR_LUT_STEP_Q of a Q8 command (¼ %),
+ * so the control tick maps a command with one indexed load.  Entry 0 is
+ * always 0 (stopped).  Direction is handled outside, and both
+ * directions share a calibration.
+ *
+ * Used open loop only; the closed speed loop (CONFIG_MOTOR_ENCODERS)
+ * writes linear duty.  tools/motor_cal_fit.py fits these parameters
+ * from a logged duty sweep.  Pure C, no ESP‑IDF dependencies.
+ *====================================================================*/
+
+#ifndef MOTOR_LUT_H
+#define MOTOR_LUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MOTOR_CAL_POINTS        11      /* curve knots every 10 % */
+#define MOTOR_LUT_SHIFT         6       /* Q8 percent >> 6 = ¼ % steps */
+#define MOTOR_LUT_STEP_Q        (1 << MOTOR_LUT_SHIFT)
+#define MOTOR_LUT_SIZE          ((100 << 8 >> MOTOR_LUT_SHIFT) + 1)     /* 401 */
+
+#define MOTOR_CAL_DEADBAND_MAX  500     /* ‰ */
+#define MOTOR_CAL_GAIN_MIN      100
+#define MOTOR_CAL_GAIN_MAX      2000
+
+typedef struct {
+    uint16_t deadband_pm;
+    uint16_t gain_pm;
+    uint16_t curve_pm[MOTOR_CAL_POINTS];
+} motor_cal_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** The identity calibration: duty proportional to the command. */
+void motor_cal_default(motor_cal_t *cal);
+
+/** @return true if every field is in range and the curve non‑decreasing */
+bool motor_cal_valid(const motor_cal_t *cal);
+
+/**
+ * Build the table for @p cal.
+ * @param max_duty  duty count at 100 % (2^resolution − 1)
+ * @param lut       MOTOR_LUT_SIZE entries
+ */
+void motor_lut_build(const motor_cal_t *cal, uint32_t max_duty, uint16_t *lut);
+
+/** Table index for a Q8 command magnitude (0 … 100 << 8), rounded. */
+static inline uint32_t motor_lut_index(uint32_t mag_q8)
+{
+    return (mag_q8 + (MOTOR_LUT_STEP_Q >> 1)) >> MOTOR_LUT_SHIFT;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MOTOR_LUT_H */
@@ -1,35 +1,115 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>               // For strtol
+#include <inttypes.h>             // PRIu32 in the topic stats
 #include "freertos/FreeRTOS.h"    // For task management
-#include "freertos/task.h"        // For vTaskDelay, xTaskCreate
+#include "freertos/task.h"        // For vTaskDelay, xTaskCreateStatic
+#include "freertos/semphr.h"      // Client handle mutex
+#include "freertos/queue.h"       // Publishes handed off by the event task
+#include "freertos/event_groups.h"// Connection state for broker failover
 #include "esp_log.h"
 #include "mqtt_client.h"
 #include "mqtt_client_app.h"
 #include "motor_control.h"
 #include "esp_crt_bundle.h"       // esp_crt_bundle_attach()
-#include "cJSON.h"                // For JSON parsing/creation
+#include "motor_cmd.h"            // Command / state wire format
 #include "env_parser.h"
+#include "deferred_log.h"
+#include "json_pool.h"
+#include "mem_report.h"
+#include "broker_select.h"
+#include "ota_update.h"
+#include "topic_router.h"
+#include "mqtt_wire.h"              // MQTT 5 properties, wire byte counters
+#include "mqtt_reasm.h"             // Fragmented payloads → pooled buffers
 
 static const char *TAG = "MQTT_APP";
 
 /* -------- Configuration (move to Kconfig later) -------------------------- */
+// Cloud broker; override with MQTT_BROKER_URI in .env. A LAN broker (higher
+// priority) comes from MQTT_LAN_URI in .env or CONFIG_MQTT_LAN_BROKER_URI.
 #define MQTT_BROKER_URI         "mqtts://ceff3b2fc9074ac487a7ba2d62c24ef5.s1.eu.hivemq.cloud:8883"
 // New Topics
 #define MQTT_STATE_TOPIC        "wheelchair/state"         // Topic for publishing state
 #define MQTT_MOTOR_CMD_TOPIC    "wheelchair/command/motor" // Topic for receiving motor commands (JSON)
 #define MQTT_EMERGENCY_CMD_TOPIC "wheelchair/command/emergency" // Topic for emergency STOP/START
+#define MQTT_ATTENDANT_CMD_TOPIC "wheelchair/command/attendant" // Motor command JSON, overrides all sources
+#define MQTT_SOURCE_TOPIC       "wheelchair/diag/source"   // Drive source switches
+#define MOTOR_CMD_MAX_LEN       128  // payload limits; larger messages are dropped
+#define EMERGENCY_CMD_MAX_LEN   16
 #define STATE_PUBLISH_INTERVAL_MS 200 // Publish state every 200ms
+#if CONFIG_MQTT_APP_V5_TIMING
+#define STATE_PUBLISH_FLAGS (MQTT_WIRE_ALIAS_STATE | MQTT_WIRE_TIMED)
+#else
+#define STATE_PUBLISH_FLAGS MQTT_WIRE_ALIAS_STATE
+#endif
+#define STATE_PUBLISH_STACK_BYTES 4096 // logging, snprintf, MQTT 5 properties; trim from mem_report
+#define FAILOVER_STACK_BYTES      3072 // getaddrinfo + select + logging
+#define DEFER_QUEUE_LEN           4    // publishes from handlers waiting for the publisher task
+#define DEFER_PAYLOAD_MAX         256
+
+// Connection state bits shared with the failover task
+#define MQTT_EVT_START            BIT0 // mqtt_app_start(): pick a broker
+#define MQTT_EVT_CONNECTED        BIT1 // session up
+#define MQTT_EVT_LOST             BIT2 // session dropped / connect failed
 /* ------------------------------------------------------------------------ */
 
 static esp_mqtt_client_handle_t client = NULL;
-static bool g_emergency_stopped = false; // Global flag for emergency stop state
+static volatile bool g_mqtt_connected = false; // Gates the state publisher
 static TaskHandle_t g_publish_task_handle = NULL; // Handle for the state publishing task
 
+// Statically allocated publisher task and client lock (created once, never freed)
+static StackType_t  s_publish_stack[STATE_PUBLISH_STACK_BYTES];
+static StaticTask_t s_publish_tcb;
+static StaticSemaphore_t s_client_lock_buf;
+static SemaphoreHandle_t s_client_lock = NULL;    // publishers vs. client destroy
+static StaticSemaphore_t s_conn_lock_buf;
+static SemaphoreHandle_t s_conn_lock = NULL;      // broker switch vs. mqtt_app_stop
+
+/* The event task runs handlers with esp-mqtt's API lock held, while other
+ * tasks wait for that lock inside a publish with s_client_lock held: the
+ * event task must never block on s_client_lock. It publishes directly if
+ * the lock is free, otherwise the publisher task sends the copy queued here. */
+typedef struct {
+    const char *topic;                          // string literal
+    int16_t     len;
+    uint8_t     qos;
+    char        data[DEFER_PAYLOAD_MAX];
+} deferred_pub_t;
+
+static StaticQueue_t s_defer_q_buf;
+static uint8_t s_defer_q_storage[DEFER_QUEUE_LEN * sizeof(deferred_pub_t)];
+static QueueHandle_t s_defer_q = NULL;
+static deferred_pub_t s_defer_tx;               // event task only
+static deferred_pub_t s_defer_rx;               // publisher task only
+static TaskHandle_t s_event_task = NULL;        // runs mqtt_event_handler
+static uint32_t s_defer_dropped = 0;
+
+// Broker failover task and its state
+static StackType_t  s_failover_stack[FAILOVER_STACK_BYTES];
+static StaticTask_t s_failover_tcb;
+static TaskHandle_t s_failover_task = NULL;
+static StaticEventGroup_t s_mqtt_events_buf;
+static EventGroupHandle_t s_mqtt_events = NULL;
+static volatile bool s_running = false;      // between app_start and app_stop
+static bool s_client_started = false;        // esp_mqtt_client_start() called
+static int s_broker_idx = -1;                // broker currently in use
+
+// Incoming topic → handler table; lookups and registration under s_route_lock
+static topic_router_t s_router;
+static portMUX_TYPE s_route_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool s_router_ready = false;
+static const esp_mqtt_event_t *s_rx_event = NULL; // message being dispatched (event task)
+static const mqtt_reasm_msg_t *s_rx_msg = NULL;
+static mqtt_reasm_t s_reasm;                        // event task only (but mqtt_app_rx_return)
+
 // --- Forward Declarations ---
 static void publish_motor_state_task(void *pvParameters);
-static void handle_motor_command(const char *data, int data_len);
-static void handle_emergency_command(const char *data, int data_len);
+static void broker_failover_task(void *pvParameters);
+static void handle_motor_command(const char *topic, int topic_len,
+                                 const char *data, int data_len, void *ctx);
+static void handle_emergency_command(const char *topic, int topic_len,
+                                     const char *data, int data_len, void *ctx);
 
 static void log_error_if_nonzero(const char *msg, int err)
 {
@@ -38,47 +118,216 @@ static void log_error_if_nonzero(const char *msg, int err)
     }
 }
 
+/* Topic routing ----------------------------------------------------------- */
+
+// Built-in command topics; registered once, survives app stop/start
+static void router_init_once(void)
+{
+    bool init = false;
+    portENTER_CRITICAL(&s_route_lock);
+    if (!s_router_ready) {
+        topic_router_init(&s_router);
+        topic_router_add(&s_router, MQTT_MOTOR_CMD_TOPIC, 1, handle_motor_command,
+                         (void *)(intptr_t)CMD_SRC_MQTT);
+        topic_router_add(&s_router, MQTT_ATTENDANT_CMD_TOPIC, 1, handle_motor_command,
+                         (void *)(intptr_t)CMD_SRC_ATTENDANT);
+        topic_router_add(&s_router, MQTT_EMERGENCY_CMD_TOPIC, 1, handle_emergency_command, NULL);
+        topic_router_set_limit(&s_router, MQTT_MOTOR_CMD_TOPIC, MOTOR_CMD_MAX_LEN);
+        topic_router_set_limit(&s_router, MQTT_ATTENDANT_CMD_TOPIC, MOTOR_CMD_MAX_LEN);
+        topic_router_set_limit(&s_router, MQTT_EMERGENCY_CMD_TOPIC, EMERGENCY_CMD_MAX_LEN);
+        mqtt_reasm_init(&s_reasm);
+        s_router_ready = true;
+        init = true;
+    }
+    portEXIT_CRITICAL(&s_route_lock);
+    if (init) ESP_LOGD(TAG, "Topic router ready");
+}
+
+static void subscribe_all(esp_mqtt_client_handle_t c)
+{
+    for (int i = 0; ; i++) {
+        portENTER_CRITICAL(&s_route_lock);
+        bool more = i < s_router.count;
+        const char *filter = more ? s_router.routes[i].filter : NULL;
+        int qos = more ? s_router.routes[i].qos : 0;
+        portEXIT_CRITICAL(&s_route_lock);
+        if (!more) break;
+
+        int msg_id = esp_mqtt_client_subscribe(c, filter, qos);
+        ESP_LOGI(TAG, "Subscribed (msg_id=%d) to %s", msg_id, filter);
+    }
+}
+
+// Fragments of a large message arrive as consecutive events; the topic
+// is matched on the first one and the handler runs once it is whole.
+static void route_message(esp_mqtt_event_handle_t event)
+{
+    topic_handler_t fn = NULL;
+    void *ctx = NULL;
+    int route = -1;
+    uint16_t max_len = 0;
+
+    if (event->current_data_offset == 0) {
+        portENTER_CRITICAL(&s_route_lock);
+        topic_route_t *rt = topic_router_match(&s_router, event->topic, event->topic_len,
+                                               event->total_data_len);
+        if (rt) {
+            route   = rt - s_router.routes;
+            max_len = rt->max_len;
+        }
+        portEXIT_CRITICAL(&s_route_lock);
+
+        if (!rt) {
+            ESP_LOGW(TAG, "Received data on unexpected topic: %.*s", event->topic_len, event->topic);
+        }
+    }
+
+    mqtt_reasm_msg_t msg;
+    mqtt_reasm_status_t st = mqtt_reasm_feed(&s_reasm, route, max_len,
+                                             event->topic, event->topic_len,
+                                             event->data, event->data_len,
+                                             event->current_data_offset,
+                                             event->total_data_len, &msg);
+    if (st != MQTT_REASM_DONE) {
+        if (st == MQTT_REASM_DROP && route >= 0) {
+            DLOGW(TAG, "Dropped %d-byte message on route %d (limit/pool)",
+                  event->total_data_len, route);
+        }
+        return;
+    }
+
+    portENTER_CRITICAL(&s_route_lock);
+    fn  = s_router.routes[msg.route].fn;
+    ctx = s_router.routes[msg.route].ctx;
+    portEXIT_CRITICAL(&s_route_lock);
+
+    s_rx_event = event;
+    s_rx_msg = &msg;
+    fn(msg.topic, msg.topic_len, msg.data, msg.len, ctx);
+    s_rx_msg = NULL;
+    mqtt_reasm_done(&s_reasm, &msg);
+}
+
+mqtt_reasm_buf_t *mqtt_app_rx_hold(void)
+{
+    return s_rx_msg ? mqtt_reasm_hold(&s_reasm, s_rx_msg) : NULL;
+}
+
+void mqtt_app_rx_return(mqtt_reasm_buf_t *buf)
+{
+    mqtt_reasm_return(buf);
+}
+
+void mqtt_app_get_rx_stats(mqtt_reasm_stats_t *out)
+{
+    if (out) *out = s_reasm.stats;      // 32-bit fields, event task writes
+}
+
+esp_err_t mqtt_app_set_topic_limit(const char *filter, uint16_t max_len)
+{
+    router_init_once();
+
+    portENTER_CRITICAL(&s_route_lock);
+    bool ok = topic_router_set_limit(&s_router, filter, max_len);
+    portEXIT_CRITICAL(&s_route_lock);
+    return ok ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t mqtt_app_register_topic(const char *filter, int qos,
+                                  topic_handler_t handler, void *ctx)
+{
+    router_init_once();
+
+    portENTER_CRITICAL(&s_route_lock);
+    topic_router_status_t st = topic_router_add(&s_router, filter, (uint8_t)qos, handler, ctx);
+    portEXIT_CRITICAL(&s_route_lock);
+
+    switch (st) {
+    case TOPIC_ROUTER_OK:        break;
+    case TOPIC_ROUTER_FULL:      ESP_LOGE(TAG, "Topic table full, %s not routed", filter);
+                                 return ESP_ERR_NO_MEM;
+    case TOPIC_ROUTER_DUPLICATE: ESP_LOGE(TAG, "Topic %s already registered", filter);
+                                 return ESP_ERR_INVALID_STATE;
+    default:                     ESP_LOGE(TAG, "Invalid topic filter '%s'", filter ? filter : "");
+                                 return ESP_ERR_INVALID_ARG;
+    }
+
+    // Already connected: subscribe now, otherwise on the next CONNECTED
+    // (from a handler, only if the client lock is free; see deferred_pub_t)
+    if (g_mqtt_connected && s_client_lock != NULL) {
+        TickType_t wait = xTaskGetCurrentTaskHandle() == s_event_task ? 0 : portMAX_DELAY;
+        if (xSemaphoreTake(s_client_lock, wait) == pdTRUE) {
+            if (client) esp_mqtt_client_subscribe(client, filter, qos);
+            xSemaphoreGive(s_client_lock);
+        }
+    }
+    return ESP_OK;
+}
+
+void mqtt_app_log_topic_stats(void)
+{
+    topic_route_t routes[TOPIC_ROUTER_MAX_ROUTES];
+    int count;
+    uint32_t unmatched;
+
+    portENTER_CRITICAL(&s_route_lock);
+    count = s_router.count;
+    memcpy(routes, s_router.routes, count * sizeof(routes[0]));
+    unmatched = s_router.unmatched;
+    portEXIT_CRITICAL(&s_route_lock);
+
+    for (int i = 0; i < count; i++) {
+        ESP_LOGI(TAG, "topic %-32s %6" PRIu32 " msgs %8" PRIu32 " bytes",
+                 routes[i].filter, routes[i].messages, routes[i].bytes);
+    }
+    ESP_LOGI(TAG, "unmatched topics: %" PRIu32, unmatched);
+
+    mqtt_reasm_stats_t rx;
+    mqtt_app_get_rx_stats(&rx);
+    ESP_LOGI(TAG, "rx %" PRIu32 " msgs (%" PRIu32 " in place, %" PRIu32 " fragments, %"
+             PRIu32 " held), dropped: %" PRIu32 " oversize, %" PRIu32 " pool empty, %"
+             PRIu32 " topic busy, %" PRIu32 " aborted; pool %u/%d in use, peak %u",
+             rx.messages, rx.direct, rx.fragments, rx.held, rx.oversize, rx.pool_empty,
+             rx.route_busy, rx.aborted, rx.in_use, MQTT_REASM_BUFS, rx.high_water);
+    ESP_LOGI(TAG, "handler publishes dropped (queue full / too long): %" PRIu32, s_defer_dropped);
+}
+
 /* MQTT event handler ------------------------------------------------------ */
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
                                int32_t event_id, void *event_data)
 {
     esp_mqtt_event_handle_t event = event_data;
     esp_mqtt_client_handle_t c = event->client;
-    int msg_id;
+
+    s_event_task = xTaskGetCurrentTaskHandle();
 
     switch ((esp_mqtt_event_id_t)event_id) {
     case MQTT_EVENT_CONNECTED:
         ESP_LOGI(TAG, "MQTT_EVENT_CONNECTED");
-        g_emergency_stopped = false; // Reset emergency stop on reconnect
-
-        // Subscribe to command topics
-        msg_id = esp_mqtt_client_subscribe(c, MQTT_MOTOR_CMD_TOPIC, 1);
-        ESP_LOGI(TAG, "Subscribed (msg_id=%d) to %s", msg_id, MQTT_MOTOR_CMD_TOPIC);
-        msg_id = esp_mqtt_client_subscribe(c, MQTT_EMERGENCY_CMD_TOPIC, 1);
-        ESP_LOGI(TAG, "Subscribed (msg_id=%d) to %s", msg_id, MQTT_EMERGENCY_CMD_TOPIC);
-
-        // Start the state publishing task if it's not already running
-        if (g_publish_task_handle == NULL) {
-             xTaskCreate(publish_motor_state_task, "mqtt_pub_task", 4096, c, 5, &g_publish_task_handle);
-             if(g_publish_task_handle == NULL) {
-                 ESP_LOGE(TAG, "Failed to create state publishing task!");
-             } else {
-                 ESP_LOGI(TAG, "State publishing task started.");
-             }
-        }
+
+        // Subscribe to every registered topic
+        mqtt_wire_session_start();
+        subscribe_all(c);
+
+        // Resume state publishing
+        g_mqtt_connected = true;
+        xEventGroupClearBits(s_mqtt_events, MQTT_EVT_LOST);
+        xEventGroupSetBits(s_mqtt_events, MQTT_EVT_CONNECTED);
+        ota_update_mark_healthy(); // Confirms a freshly updated image
         break;
 
     case MQTT_EVENT_DISCONNECTED:
         ESP_LOGI(TAG, "MQTT_EVENT_DISCONNECTED");
-        // Stop the state publishing task
-        if (g_publish_task_handle != NULL) {
-            ESP_LOGI(TAG, "Stopping state publishing task...");
-            vTaskDelete(g_publish_task_handle);
-            g_publish_task_handle = NULL;
-            ESP_LOGI(TAG, "State publishing task stopped.");
-        }
-        g_emergency_stopped = true; // Enter safe state on disconnect
-        motor_emergency_stop(); // Ensure motors are stopped
+        // Pause state publishing until we reconnect
+        g_mqtt_connected = false;
+        // Let the failover task pick the next broker
+        xEventGroupClearBits(s_mqtt_events, MQTT_EVT_CONNECTED);
+        xEventGroupSetBits(s_mqtt_events, MQTT_EVT_LOST);
+        // Only the sources behind this link stop; the wired joystick keeps driving
+        motor_expire_source(CMD_SRC_MQTT);
+        motor_expire_source(CMD_SRC_ATTENDANT);
+        mqtt_reasm_abort(&s_reasm); // The rest of a fragmented message is not coming
+        mqtt_app_log_topic_stats(); // Per-topic counters for the session
         break;
 
     case MQTT_EVENT_SUBSCRIBED:
@@ -95,18 +344,12 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
         break;
 
     case MQTT_EVENT_DATA:
-        ESP_LOGI(TAG, "MQTT_EVENT_DATA");
+        DLOGI(TAG, "MQTT_EVENT_DATA, msg_id=%d", event->msg_id);
         ESP_LOGD(TAG, "TOPIC=%.*s", event->topic_len, event->topic);
         ESP_LOGD(TAG, "DATA=%.*s", event->data_len, event->data);
 
-        // Route data based on topic
-        if (event->topic && strncmp(event->topic, MQTT_MOTOR_CMD_TOPIC, event->topic_len) == 0) {
-            handle_motor_command(event->data, event->data_len);
-        } else if (event->topic && strncmp(event->topic, MQTT_EMERGENCY_CMD_TOPIC, event->topic_len) == 0) {
-            handle_emergency_command(event->data, event->data_len);
-        } else {
-            ESP_LOGW(TAG, "Received data on unexpected topic: %.*s", event->topic_len, event->topic);
-        }
+        // Route data based on topic (exact hash lookup, then wildcards)
+        route_message(event);
         break;
 
     case MQTT_EVENT_ERROR:
@@ -138,126 +381,270 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
 
 // --- Command Handlers ---
 
-static void handle_motor_command(const char *data, int data_len) {
-    if (g_emergency_stopped) {
-        ESP_LOGW(TAG, "Motor command ignored - EMERGENCY STOP active.");
-        return;
+static void handle_motor_command(const char *topic, int topic_len,
+                                 const char *data, int data_len, void *ctx) {
+    if (!mqtt_wire_command_fresh(s_rx_event, ctx)) {
+        return; // duplicate / late (MQTT 5 seq/ts properties)
     }
 
-    cJSON *root = cJSON_ParseWithLength(data, data_len);
-    if (root == NULL) {
+    motor_cmd_t cmd;
+    motor_cmd_status_t st = motor_cmd_parse(data, data_len, &cmd);
+    if (st == MOTOR_CMD_BAD_JSON) {
         ESP_LOGE(TAG, "Failed to parse motor command JSON");
         return;
     }
-
-    const cJSON *left_json = cJSON_GetObjectItemCaseSensitive(root, "left");
-    const cJSON *right_json = cJSON_GetObjectItemCaseSensitive(root, "right");
-
-    if (!cJSON_IsNumber(left_json) || !cJSON_IsNumber(right_json)) {
-        ESP_LOGE(TAG, "Invalid motor command JSON format: 'left' and 'right' must be numbers.");
-        cJSON_Delete(root);
+    if (st != MOTOR_CMD_OK) {
+        ESP_LOGE(TAG, "Invalid motor command JSON format: 'left'/'right' or 'v'/'w' must be numbers.");
         return;
     }
 
-    int left_speed = left_json->valueint;
-    int right_speed = right_json->valueint;
+    const cmd_source_t src = (cmd_source_t)(intptr_t)ctx;
+    if (cmd.twist) {
+        DLOGI(TAG, "Received twist command: v=%d, w=%d", cmd.v, cmd.w);
+        motor_submit_twist(src, cmd.v, cmd.w);
+        return;
+    }
 
-    ESP_LOGI(TAG, "Received motor command: Left=%d, Right=%d", left_speed, right_speed);
+    DLOGI(TAG, "Received motor command: Left=%d, Right=%d", cmd.left, cmd.right);
 
     // Validate speed range (optional, motor_control might clamp anyway)
-    if (left_speed < -100 || left_speed > 100 || right_speed < -100 || right_speed > 100) {
-         ESP_LOGW(TAG, "Motor command speed out of range (-100 to 100). Clamping may occur.");
+    if (cmd.left < -100 || cmd.left > 100 || cmd.right < -100 || cmd.right > 100) {
+         DLOGW(TAG, "Motor command speed out of range (-100 to 100). Clamping may occur.");
     }
 
-    motor_set_speeds(left_speed, right_speed);
-
-    cJSON_Delete(root); // Free JSON object
+    motor_submit_speeds(src, cmd.left, cmd.right);
 }
 
-static void handle_emergency_command(const char *data, int data_len) {
-    char command[data_len + 1];
-    memcpy(command, data, data_len);
-    command[data_len] = '\0';
-
-    if (strcmp(command, "STOP") == 0) {
-        if (!g_emergency_stopped) {
+static void handle_emergency_command(const char *topic, int topic_len,
+                                     const char *data, int data_len, void *ctx) {
+    // Payload is not NUL-terminated and at most EMERGENCY_CMD_MAX_LEN
+    // Latched in motor_control: holds every source (wired, HTTP, attendant) until START
+    const bool stopped = motor_get_lockout() & MOTOR_LOCK_ESTOP;
+    if (data_len == 4 && memcmp(data, "STOP", 4) == 0) {
+        if (!stopped) {
             ESP_LOGW(TAG, "EMERGENCY STOP command received.");
-            g_emergency_stopped = true;
-            motor_emergency_stop();
+            motor_set_lockout(MOTOR_LOCK_ESTOP, true);
         } else {
             ESP_LOGW(TAG, "Emergency stop already active.");
         }
-    } else if (strcmp(command, "START") == 0) {
-        if (g_emergency_stopped) {
+    } else if (data_len == 5 && memcmp(data, "START", 5) == 0) {
+        if (stopped) {
             ESP_LOGW(TAG, "MOTOR START command received.");
-            g_emergency_stopped = false;
-            // Optionally set speed to 0 as a safe default, or let next motor command decide
-            // motor_set_speeds(0, 0);
+            motor_set_lockout(MOTOR_LOCK_ESTOP, false);
             ESP_LOGI(TAG, "Motors enabled. Awaiting motor commands.");
         } else {
             ESP_LOGW(TAG, "Motors already enabled.");
         }
     } else {
-        ESP_LOGW(TAG, "Invalid emergency command: %s. Use 'STOP' or 'START'.", command);
+        ESP_LOGW(TAG, "Invalid emergency command: %.*s. Use 'STOP' or 'START'.", data_len, data);
     }
 }
 
 
+// Report a change of drive source (owner) since the last call
+static void publish_source_change(void)
+{
+    static uint32_t reported_switches = 0;
+    static char payload[160];                   // off the publisher stack
+    cmd_arbiter_stats_t st;
+
+    motor_get_source_stats(&st);
+    if (st.switches == reported_switches) return;
+    reported_switches = st.switches;
+
+    int len = snprintf(payload, sizeof(payload),
+                       "{\"source\":\"%s\",\"prev\":\"%s\",\"switch_us\":%" PRId32
+                       ",\"handover_us\":%" PRId32 ",\"max_switch_us\":%" PRId32
+                       ",\"switches\":%" PRIu32 "}",
+                       cmd_source_name(st.owner), cmd_source_name(st.prev_owner),
+                       st.last_switch_us, st.last_handover_us, st.max_switch_us, st.switches);
+    ESP_LOGI(TAG, "Drive source %s -> %s", cmd_source_name(st.prev_owner), cmd_source_name(st.owner));
+    mqtt_app_publish(MQTT_SOURCE_TOPIC, payload, len, 0);
+}
+
 // --- State Publishing Task ---
 static void publish_motor_state_task(void *pvParameters) {
-    esp_mqtt_client_handle_t mqtt_client = (esp_mqtt_client_handle_t)pvParameters;
-    cJSON *root = NULL;
-    char *json_string = NULL;
+    // Encoded in place every period; nothing is allocated here
+    static char payload[MOTOR_STATE_PAYLOAD_MAX];
 
     ESP_LOGI(TAG, "State publisher task started.");
 
+    TickType_t next = xTaskGetTickCount() + pdMS_TO_TICKS(STATE_PUBLISH_INTERVAL_MS);
     while (1) {
-        vTaskDelay(pdMS_TO_TICKS(STATE_PUBLISH_INTERVAL_MS));
+        // Sleep until the next state period, sending handed-off publishes meanwhile
+        TickType_t now = xTaskGetTickCount();
+        TickType_t wait = (int32_t)(next - now) > 0 ? next - now : 0;
+        if (xQueueReceive(s_defer_q, &s_defer_rx, wait) == pdTRUE) {
+            xSemaphoreTake(s_client_lock, portMAX_DELAY);
+            if (client && g_mqtt_connected) {
+                mqtt_wire_publish(client, s_defer_rx.topic, s_defer_rx.data,
+                                  s_defer_rx.len, s_defer_rx.qos, 0);
+            }
+            xSemaphoreGive(s_client_lock);
+            continue;
+        }
+        next = xTaskGetTickCount() + pdMS_TO_TICKS(STATE_PUBLISH_INTERVAL_MS);
 
-        if (!mqtt_client || g_emergency_stopped) { // Don't publish if client is gone or emergency stopped
-             if (g_emergency_stopped) ESP_LOGD(TAG, "State publish skipped (Emergency Stop)");
+        if (g_mqtt_connected) publish_source_change();
+
+        const bool stopped = motor_get_lockout() & MOTOR_LOCK_ESTOP;
+        if (!g_mqtt_connected || stopped) { // Don't publish while offline or emergency stopped
+             if (stopped) ESP_LOGD(TAG, "State publish skipped (Emergency Stop)");
              continue;
         }
 
-
         int left_speed, right_speed;
         motor_get_speeds(&left_speed, &right_speed);
 
-        // Create JSON payload
-        root = cJSON_CreateObject();
-        if (root == NULL) {
-            ESP_LOGE(TAG, "Failed to create JSON object for state");
-            continue; // Skip this iteration
-        }
-        cJSON_AddNumberToObject(root, "left_speed", left_speed);
-        cJSON_AddNumberToObject(root, "right_speed", right_speed);
+        int len = motor_state_encode(payload, sizeof(payload), left_speed, right_speed);
+        if (len < 0) continue;
 
-        json_string = cJSON_PrintUnformatted(root); // Use Unformatted for smaller size
-        if (json_string == NULL) {
-            ESP_LOGE(TAG, "Failed to print JSON state to string");
-            cJSON_Delete(root);
-            continue;
-        }
+        // Publish the state (client may be torn down concurrently by mqtt_app_stop)
+        xSemaphoreTake(s_client_lock, portMAX_DELAY);
+        int msg_id = client ? mqtt_wire_publish(client, MQTT_STATE_TOPIC, payload, len, 0, // QoS 0
+                                                STATE_PUBLISH_FLAGS) : -1;
+        xSemaphoreGive(s_client_lock);
 
-        // Publish the state
-        int msg_id = esp_mqtt_client_publish(mqtt_client, MQTT_STATE_TOPIC, json_string, 0, 0, 0); // QoS 0
         if (msg_id != -1) {
              ESP_LOGD(TAG, "Sent publish successful, topic=%s, msg_id=%d", MQTT_STATE_TOPIC, msg_id);
-             ESP_LOGV(TAG, "Published state: %s", json_string); // Verbose log
+             ESP_LOGV(TAG, "Published state: %s", payload); // Verbose log
         } else {
              ESP_LOGE(TAG, "Error sending publish, topic=%s", MQTT_STATE_TOPIC);
         }
+    }
+}
+
+
+/* Publishing for other modules --------------------------------------------- */
+int mqtt_app_publish(const char *topic, const char *data, int len, int qos)
+{
+    if (!g_mqtt_connected || s_client_lock == NULL) {
+        return -1;
+    }
+    if (xTaskGetCurrentTaskHandle() == s_event_task) {
+        // From a handler: never wait for the lock (see deferred_pub_t)
+        if (xSemaphoreTake(s_client_lock, 0) == pdTRUE) {
+            int msg_id = client ? mqtt_wire_publish(client, topic, data, len, qos, 0) : -1;
+            xSemaphoreGive(s_client_lock);
+            return msg_id;
+        }
+        if (len < 0 || len > DEFER_PAYLOAD_MAX) {
+            s_defer_dropped++;
+            return -1;
+        }
+        s_defer_tx.topic = topic;
+        s_defer_tx.len   = (int16_t)len;
+        s_defer_tx.qos   = (uint8_t)qos;
+        memcpy(s_defer_tx.data, data, len);
+        if (xQueueSend(s_defer_q, &s_defer_tx, 0) != pdTRUE) {
+            s_defer_dropped++;
+            return -1;
+        }
+        return 0;
+    }
+    xSemaphoreTake(s_client_lock, portMAX_DELAY);
+    int msg_id = client ? mqtt_wire_publish(client, topic, data, len, qos, 0) : -1;
+    xSemaphoreGive(s_client_lock);
+    return msg_id;
+}
+
+/* Broker failover --------------------------------------------------------- */
+
+/* Point the client at broker @idx and wait for the session (bounded). */
+static bool broker_connect(int idx)
+{
+    const broker_t *b = broker_get(idx);
+
+    // s_client_lock is not held here: a publisher may be inside
+    // esp_mqtt_client_publish, which stop/start wait for
+    xSemaphoreTake(s_conn_lock, portMAX_DELAY);
+    if (!client || !s_running) {
+        xSemaphoreGive(s_conn_lock);
+        return false;
+    }
+    if (s_client_started) {
+        esp_mqtt_client_stop(client);
+        s_client_started = false;
+    }
+    g_mqtt_connected = false;
+    xEventGroupClearBits(s_mqtt_events, MQTT_EVT_CONNECTED | MQTT_EVT_LOST);
+    esp_mqtt_client_set_uri(client, b->uri);
+    esp_err_t err = esp_mqtt_client_start(client);
+    s_client_started = (err == ESP_OK);
+    s_broker_idx = idx;
+    xSemaphoreGive(s_conn_lock);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "esp_mqtt_client_start() failed: %s", esp_err_to_name(err));
+        broker_mark_failed(idx);
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Connecting to broker %d (%s)...", idx, b->uri);
+    EventBits_t bits = xEventGroupWaitBits(s_mqtt_events,
+                                           MQTT_EVT_CONNECTED | MQTT_EVT_LOST,
+                                           pdFALSE, pdFALSE,
+                                           pdMS_TO_TICKS(CONFIG_MQTT_CONNECT_TIMEOUT_MS));
+    if (bits & MQTT_EVT_CONNECTED) {
+        broker_mark_ok(idx);
+        return true;
+    }
+
+    ESP_LOGW(TAG, "Broker %d did not connect within %d ms", idx, CONFIG_MQTT_CONNECT_TIMEOUT_MS);
+    broker_mark_failed(idx);
+    xEventGroupClearBits(s_mqtt_events, MQTT_EVT_LOST);
+    return false;
+}
 
-        // Clean up
-        cJSON_Delete(root);
-        free(json_string);
-        root = NULL;
-        json_string = NULL;
+/* Probe all brokers and connect to the best one, retrying until connected or stopped. */
+static void broker_connect_best(void)
+{
+    while (s_running) {
+        int idx = broker_probe_select();
+        if (idx >= 0 && broker_connect(idx)) {
+            ESP_LOGI(TAG, "Using broker %d (RTT %d ms)", idx, (int)broker_get(idx)->rtt_ms);
+            return;
+        }
+        if (idx < 0) {
+            ESP_LOGW(TAG, "No broker reachable, retrying");
+            vTaskDelay(pdMS_TO_TICKS(CONFIG_MQTT_BROKER_PROBE_TIMEOUT_MS));
+        }
     }
+}
+
+static void broker_failover_task(void *pvParameters)
+{
+    while (1) {
+        EventBits_t bits = xEventGroupWaitBits(s_mqtt_events,
+                                               MQTT_EVT_START | MQTT_EVT_LOST,
+                                               pdTRUE, pdFALSE,
+                                               pdMS_TO_TICKS(CONFIG_MQTT_BROKER_RECHECK_S * 1000));
+        if (!s_running) continue;
+
+        if (bits & MQTT_EVT_LOST) {
+            ESP_LOGW(TAG, "Lost broker %d, failing over", s_broker_idx);
+            broker_mark_failed(s_broker_idx);
+        }
+        if (bits & (MQTT_EVT_START | MQTT_EVT_LOST)) {
+            broker_connect_best();
+            continue;
+        }
 
-     // Should not reach here if vTaskDelete is used externally
-     ESP_LOGW(TAG, "State publisher task exiting loop.");
-     vTaskDelete(NULL);
+        // Periodic check: is a higher-priority broker reachable (and fast) again?
+        // Not while someone drives over the network: a switch drops the session.
+        cmd_arbiter_stats_t src;
+        motor_get_source_stats(&src);
+        bool remote_drive = src.owner != CMD_SRC_NONE && src.owner != CMD_SRC_LOCAL;
+        if (g_mqtt_connected && s_broker_idx > 0 && !remote_drive) {
+            int better = broker_probe_better(s_broker_idx);
+            if (better != s_broker_idx) {
+                ESP_LOGI(TAG, "Broker %d preferred again, switching", better);
+                if (!broker_connect(better)) {
+                    broker_connect_best();
+                }
+            }
+        }
+    }
 }
 
 
@@ -265,19 +652,38 @@ static void publish_motor_state_task(void *pvParameters) {
 esp_err_t mqtt_app_start(void)
 {
     ESP_LOGI(TAG, "Starting MQTT client...");
+    router_init_once();
 
     const char *mqtt_user = get_env_value("MQTT_USERNAME");
     const char *mqtt_pass = get_env_value("MQTT_PASSWORD");
 
+    // Prioritised broker list: LAN first, then the cloud
+    const char *lan_uri   = get_env_value("MQTT_LAN_URI");
+    const char *cloud_uri = get_env_value("MQTT_BROKER_URI");
+    broker_list_reset();
+    broker_add(lan_uri ? lan_uri : CONFIG_MQTT_LAN_BROKER_URI);
+    broker_add(cloud_uri ? cloud_uri : MQTT_BROKER_URI);
+    if (broker_count() == 0) {
+        ESP_LOGE(TAG, "No valid MQTT broker configured");
+        return ESP_ERR_INVALID_ARG;
+    }
+
     esp_mqtt_client_config_t cfg = {
         .broker = {
-            .address.uri = MQTT_BROKER_URI,
+            .address.uri = broker_get(0)->uri, // replaced by the failover task
             .verification.crt_bundle_attach = esp_crt_bundle_attach, /* key line */
         },
         .credentials = {
             .username = mqtt_user,
             .authentication.password = mqtt_pass,
         },
+        .session = {
+            .keepalive = CONFIG_MQTT_KEEPALIVE_S, // bounds dead-broker detection
+        },
+        .network = {
+            .timeout_ms = CONFIG_MQTT_CONNECT_TIMEOUT_MS,
+            .disable_auto_reconnect = true, // the failover task reconnects
+        },
         // Optional: Set last will and testament (LWT) to indicate unexpected disconnect
         // .session.last_will = {
         //     .topic = "wheelchair/status",
@@ -286,20 +692,39 @@ esp_err_t mqtt_app_start(void)
         //     .retain = 1
         // }
     };
+    mqtt_wire_configure(&cfg); // MQTT 5 when CONFIG_MQTT_APP_V5
 
     if (client) {
         ESP_LOGW(TAG, "Client already exists. Restarting it.");
         // Ensure clean stop before re-init
-        mqtt_app_stop(); // mqtt_app_stop will also delete the task if running
+        mqtt_app_stop();
         vTaskDelay(pdMS_TO_TICKS(200)); // Allow time for cleanup
     }
 
+    // One-time creation of the statically allocated publisher/failover tasks
+    if (g_publish_task_handle == NULL) {
+        s_client_lock = xSemaphoreCreateMutexStatic(&s_client_lock_buf);
+        s_conn_lock = xSemaphoreCreateMutexStatic(&s_conn_lock_buf);
+        s_defer_q = xQueueCreateStatic(DEFER_QUEUE_LEN, sizeof(deferred_pub_t),
+                                       s_defer_q_storage, &s_defer_q_buf);
+        s_mqtt_events = xEventGroupCreateStatic(&s_mqtt_events_buf);
+        g_publish_task_handle = xTaskCreateStatic(publish_motor_state_task, "mqtt_pub_task",
+                                                  STATE_PUBLISH_STACK_BYTES, NULL, 5,
+                                                  s_publish_stack, &s_publish_tcb);
+        mem_report_register_task(g_publish_task_handle, STATE_PUBLISH_STACK_BYTES);
+        s_failover_task = xTaskCreateStatic(broker_failover_task, "mqtt_failover",
+                                            FAILOVER_STACK_BYTES, NULL, 4,
+                                            s_failover_stack, &s_failover_tcb);
+        mem_report_register_task(s_failover_task, FAILOVER_STACK_BYTES);
+    }
+
 
     client = esp_mqtt_client_init(&cfg);
     if (!client) {
         ESP_LOGE(TAG, "esp_mqtt_client_init() failed");
         return ESP_FAIL;
     }
+    mqtt_wire_client_created(client);
 
     esp_err_t ret = esp_mqtt_client_register_event(client, ESP_EVENT_ANY_ID,
                                                    mqtt_event_handler, NULL);
@@ -310,54 +735,54 @@ esp_err_t mqtt_app_start(void)
         return ret;
     }
 
-    ret = esp_mqtt_client_start(client);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "esp_mqtt_client_start() failed: %s", esp_err_to_name(ret));
-        esp_mqtt_client_destroy(client); // Cleanup client if start fails
-        client = NULL;
-    } else {
-        ESP_LOGI(TAG, "MQTT client started successfully.");
-    }
-    return ret;
+    // The failover task probes the brokers and starts the client
+    s_client_started = false;
+    s_running = true;
+    xEventGroupSetBits(s_mqtt_events, MQTT_EVT_START);
+    ESP_LOGI(TAG, "MQTT client created; selecting broker.");
+    return ESP_OK;
 }
 
 esp_err_t mqtt_app_stop(void)
 {
     esp_err_t err = ESP_OK;
 
-    // Stop and delete the publishing task first
-    if (g_publish_task_handle != NULL) {
-        ESP_LOGI(TAG, "Stopping state publishing task before stopping client...");
-        vTaskDelete(g_publish_task_handle);
-        g_publish_task_handle = NULL;
-        ESP_LOGI(TAG, "State publishing task stopped.");
-         // Add a small delay to allow the task deletion to complete
-        vTaskDelay(pdMS_TO_TICKS(50));
-    }
+    // Pause the publisher and the failover task first; both stay alive for the next start
+    g_mqtt_connected = false;
+    s_running = false;
 
     if (client) {
         ESP_LOGI(TAG, "Stopping MQTT client...");
+        // Wait out any broker switch; publishers keep running until the handle goes
+        xSemaphoreTake(s_conn_lock, portMAX_DELAY);
         // Unregister event handler *before* stopping/destroying
         esp_mqtt_client_unregister_event(client, ESP_EVENT_ANY_ID,
                                          mqtt_event_handler);
-        err = esp_mqtt_client_stop(client);
-        if (err != ESP_OK)
-            ESP_LOGE(TAG, "esp_mqtt_client_stop failed: %s", esp_err_to_name(err));
-        else
-             ESP_LOGI(TAG, "MQTT client stopped.");
+        if (s_client_started) {
+            err = esp_mqtt_client_stop(client);
+            if (err != ESP_OK)
+                ESP_LOGE(TAG, "esp_mqtt_client_stop failed: %s", esp_err_to_name(err));
+            else
+                 ESP_LOGI(TAG, "MQTT client stopped.");
+            s_client_started = false;
+        }
 
+        // Take the handle from the publishers (stopped: none is waiting on esp-mqtt)
+        xSemaphoreTake(s_client_lock, portMAX_DELAY);
+        esp_mqtt_client_handle_t old = client;
+        client = NULL;
+        xSemaphoreGive(s_client_lock);
 
         // Destroy should be called after stop
-        err = esp_mqtt_client_destroy(client);
+        err = esp_mqtt_client_destroy(old);
         if (err != ESP_OK)
             ESP_LOGE(TAG, "esp_mqtt_client_destroy failed: %s", esp_err_to_name(err));
         else
             ESP_LOGI(TAG, "MQTT client destroyed.");
-
-
-        client = NULL;
-        g_emergency_stopped = true; // Ensure safe state after stop
-        motor_emergency_stop(); // Ensure motors are stopped
+        xSemaphoreGive(s_conn_lock);
+        // No more MQTT commands; the event task that wrote these slots is gone
+        motor_expire_source(CMD_SRC_MQTT);
+        motor_expire_source(CMD_SRC_ATTENDANT);
     } else {
         ESP_LOGI(TAG, "MQTT client already stopped/null.");
     }
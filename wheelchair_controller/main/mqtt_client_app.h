@@ -2,6 +2,8 @@
 #define MQTT_CLIENT_APP_H
 
 #include "esp_err.h"
+#include "topic_router.h"
+#include "mqtt_reasm.h"
 
 /**
  * @brief Starts the MQTT client and connects to the broker.
@@ -17,4 +19,72 @@ esp_err_t mqtt_app_start(void);
  */
 esp_err_t mqtt_app_stop(void);
 
+/**
+ * @brief Publishes on the current broker if a session is up.
+ *
+ * Safe to call from any task; drops the message while disconnected.
+ * From a topic handler it never blocks: if another task is publishing,
+ * a copy (at most 256 bytes) is sent shortly after by the publisher
+ * task, so @p topic must then stay valid (string literal).
+ *
+ * @return int message id (0 if handed off), or -1 if not connected /
+ *         on error.
+ */
+int mqtt_app_publish(const char *topic, const char *data, int len, int qos);
+
+/**
+ * @brief Routes incoming messages on @p filter to @p handler.
+ *
+ * The filter may use MQTT wildcards ('+', '#') and must stay valid for
+ * the lifetime of the program (string literal). It is subscribed on
+ * every (re)connect, and immediately if a session is already up. The
+ * handler runs in the MQTT event task with a payload that is not
+ * NUL-terminated. Exact topics take precedence over wildcard filters.
+ * Fragmented messages are reassembled first (mqtt_reasm.h), so the
+ * handler always sees the whole payload; messages over the topic's
+ * limit (mqtt_app_set_topic_limit, default: a pool buffer when
+ * fragmented) never reach it.
+ *
+ * @return ESP_OK, ESP_ERR_NO_MEM (table full), ESP_ERR_INVALID_STATE
+ *         (already registered) or ESP_ERR_INVALID_ARG (bad filter).
+ */
+esp_err_t mqtt_app_register_topic(const char *filter, int qos,
+                                  topic_handler_t handler, void *ctx);
+
+/**
+ * @brief Sets the largest payload accepted on a registered @p filter.
+ *
+ * @return ESP_OK or ESP_ERR_NOT_FOUND (filter not registered).
+ */
+esp_err_t mqtt_app_set_topic_limit(const char *filter, uint16_t max_len);
+
+/**
+ * @brief Keeps the message being handled past the handler's return.
+ *
+ * Call from a topic handler only. The payload stays valid in the
+ * returned buffer (data, len, topic) until mqtt_app_rx_return(), which
+ * may be called from any task. A topic holds at most
+ * MQTT_REASM_PER_ROUTE buffers; further fragmented messages on it are
+ * dropped until one is returned.
+ *
+ * @return the buffer, or NULL if the pool or the topic's share is used up.
+ */
+mqtt_reasm_buf_t *mqtt_app_rx_hold(void);
+
+/**
+ * @brief Gives a buffer from mqtt_app_rx_hold() back to the pool.
+ */
+void mqtt_app_rx_return(mqtt_reasm_buf_t *buf);
+
+/**
+ * @brief Receive pool usage and drop counters since boot.
+ */
+void mqtt_app_get_rx_stats(mqtt_reasm_stats_t *out);
+
+/**
+ * @brief Logs messages / bytes per registered topic, unmatched count and
+ * the receive pool counters.
+ */
+void mqtt_app_log_topic_stats(void);
+
 #endif // MQTT_CLIENT_APP_H 
\ No newline at end of file
@@ -0,0 +1,168 @@
+/*=====================================================================
+ * mqtt_reasm.c — Fragment reassembly over a static buffer pool
+ *====================================================================*/
+
+#include <string.h>
+#include "mqtt_reasm.h"
+
+enum {
+    BUF_FREE = 0,
+    BUF_FILLING,            // receiving fragments
+    BUF_DISPATCH,           // complete, handler running
+    BUF_HELD,               // kept by a handler
+    BUF_RETURNED,           // given back, reclaimed by the event task
+};
+
+void mqtt_reasm_init(mqtt_reasm_t *r)
+{
+    memset(r, 0, sizeof(*r));
+}
+
+static void buf_free(mqtt_reasm_t *r, mqtt_reasm_buf_t *b)
+{
+    b->state = BUF_FREE;
+    r->per_route[b->route]--;
+    r->stats.in_use--;
+}
+
+/* Buffers returned by other tasks only change state; account for them here. */
+static void reclaim(mqtt_reasm_t *r)
+{
+    for (int i = 0; i < MQTT_REASM_BUFS; i++) {
+        if (r->buf[i].state == BUF_RETURNED) buf_free(r, &r->buf[i]);
+    }
+}
+
+static mqtt_reasm_buf_t *buf_take(mqtt_reasm_t *r, int route)
+{
+    reclaim(r);
+    if (r->per_route[route] >= MQTT_REASM_PER_ROUTE) {
+        r->stats.route_busy++;
+        return NULL;
+    }
+    for (int i = 0; i < MQTT_REASM_BUFS; i++) {
+        mqtt_reasm_buf_t *b = &r->buf[i];
+        if (b->state != BUF_FREE) continue;
+        b->state = BUF_FILLING;
+        b->route = (uint8_t)route;
+        b->len = 0;
+        r->per_route[route]++;
+        if (++r->stats.in_use > r->stats.high_water) r->stats.high_water = r->stats.in_use;
+        return b;
+    }
+    r->stats.pool_empty++;
+    return NULL;
+}
+
+void mqtt_reasm_abort(mqtt_reasm_t *r)
+{
+    if (r->cur) {
+        buf_free(r, r->cur);
+        r->cur = NULL;
+        r->stats.aborted++;
+    }
+    r->skipping = false;
+}
+
+static mqtt_reasm_status_t drop_rest(mqtt_reasm_t *r, bool more)
+{
+    r->skipping = more;
+    return MQTT_REASM_DROP;
+}
+
+mqtt_reasm_status_t mqtt_reasm_feed(mqtt_reasm_t *r, int route, uint16_t max_len,
+                                    const char *topic, int topic_len,
+                                    const char *data, int len, int offset, int total,
+                                    mqtt_reasm_msg_t *out)
+{
+    mqtt_reasm_buf_t *b;
+
+    if (offset == 0) {
+        mqtt_reasm_abort(r);                // a new message ends any partial one
+        bool more = len < total;
+        if (route < 0 || route >= TOPIC_ROUTER_MAX_ROUTES) return drop_rest(r, more);
+        if (max_len && total > max_len) {
+            r->stats.oversize++;
+            return drop_rest(r, more);
+        }
+
+        if (!more) {
+            *out = (mqtt_reasm_msg_t){
+                .topic = topic, .topic_len = topic_len,
+                .data = data, .len = len, .route = route,
+            };
+            r->stats.messages++;
+            r->stats.direct++;
+            return MQTT_REASM_DONE;
+        }
+
+        if (total > MQTT_REASM_BUF_BYTES || topic_len > MQTT_REASM_TOPIC_MAX) {
+            r->stats.oversize++;
+            return drop_rest(r, true);
+        }
+        b = buf_take(r, route);
+        if (!b) return drop_rest(r, true);
+        b->total = total;
+        b->topic_len = (uint16_t)topic_len;
+        memcpy(b->topic, topic, (size_t)topic_len);
+        r->cur = b;
+    } else {
+        if (r->skipping) return MQTT_REASM_DROP;
+        b = r->cur;
+        if (!b || offset != b->len || total != b->total) {
+            mqtt_reasm_abort(r);
+            return drop_rest(r, true);
+        }
+    }
+
+    r->stats.fragments++;
+    if (len < 0 || len > total - offset) {
+        mqtt_reasm_abort(r);
+        return drop_rest(r, true);
+    }
+    memcpy(&b->data[offset], data, (size_t)len);
+    b->len += len;
+    if (b->len < total) return MQTT_REASM_MORE;
+
+    r->cur = NULL;
+    b->state = BUF_DISPATCH;
+    *out = (mqtt_reasm_msg_t){
+        .topic = b->topic, .topic_len = b->topic_len,
+        .data = b->data, .len = b->len, .route = b->route, .buf = b,
+    };
+    r->stats.messages++;
+    return MQTT_REASM_DONE;
+}
+
+mqtt_reasm_buf_t *mqtt_reasm_hold(mqtt_reasm_t *r, const mqtt_reasm_msg_t *msg)
+{
+    mqtt_reasm_buf_t *b = msg->buf;
+
+    if (!b) {
+        if (msg->len > MQTT_REASM_BUF_BYTES || msg->topic_len > MQTT_REASM_TOPIC_MAX) {
+            r->stats.oversize++;
+            return NULL;
+        }
+        b = buf_take(r, msg->route);
+        if (!b) return NULL;
+        memcpy(b->data, msg->data, (size_t)msg->len);
+        memcpy(b->topic, msg->topic, (size_t)msg->topic_len);
+        b->topic_len = (uint16_t)msg->topic_len;
+        b->len = b->total = msg->len;
+    } else if (b->state != BUF_DISPATCH) {
+        return b->state == BUF_HELD ? b : NULL;     // held twice
+    }
+    b->state = BUF_HELD;
+    r->stats.held++;
+    return b;
+}
+
+void mqtt_reasm_done(mqtt_reasm_t *r, const mqtt_reasm_msg_t *msg)
+{
+    if (msg->buf && msg->buf->state == BUF_DISPATCH) buf_free(r, msg->buf);
+}
+
+void mqtt_reasm_return(mqtt_reasm_buf_t *b)
+{
+    if (b && b->state == BUF_HELD) b->state = BUF_RETURNED;
+}
@@ -0,0 +1,134 @@
+/*=====================================================================
+ * mqtt_reasm.h — Reassembly of fragmented MQTT payloads into a pool
+ *
+ * esp‑mqtt hands a message larger than its receive buffer over as
+ * several MQTT_EVENT_DATA events (current_data_offset / total_data_len;
+ * topic on the first one only).  Fragments of one message arrive back
+ * to back, so one message is being filled at a time.
+ *
+ *  • A message that arrives whole is delivered in place — the event's
+ *    buffer, no copy.
+ *  • A fragmented message is copied once, fragment by fragment, into a
+ *    fixed‑size buffer from a static pool and delivered from there.
+ *  • Memory is bounded per topic: the route's max_len (topic_router)
+ *    is checked against total_data_len before anything is buffered,
+ *    and a route holds at most MQTT_REASM_PER_ROUTE pool buffers.
+ *  • A handler may keep a message past its return (mqtt_reasm_hold)
+ *    and give the buffer back later from any task (mqtt_reasm_return);
+ *    only a message delivered in place is copied for that.
+ *  • Anything that does not fit — over the limit, pool empty, route
+ *    at its share, a broken fragment sequence — is dropped as a whole
+ *    message and counted.
+ *
+ * Pure C, no ESP‑IDF dependencies.  Feed, hold and done run in the
+ * MQTT event task; mqtt_reasm_return may run in any task (it only
+ * flags the buffer, the event task reclaims it).
+ *====================================================================*/
+
+#ifndef MQTT_REASM_H
+#define MQTT_REASM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "topic_router.h"
+
+#ifndef MQTT_REASM_BUFS
+#define MQTT_REASM_BUFS         3
+#endif
+#ifndef MQTT_REASM_BUF_BYTES
+#define MQTT_REASM_BUF_BYTES    2048
+#endif
+#ifndef MQTT_REASM_PER_ROUTE
+#define MQTT_REASM_PER_ROUTE    1       // pool buffers one topic may hold
+#endif
+#ifndef MQTT_REASM_TOPIC_MAX
+#define MQTT_REASM_TOPIC_MAX    64
+#endif
+
+typedef struct {
+    char              data[MQTT_REASM_BUF_BYTES];
+    char              topic[MQTT_REASM_TOPIC_MAX];
+    uint16_t          topic_len;
+    int               len;              // bytes received so far
+    int               total;
+    uint8_t           route;
+    volatile uint8_t  state;            // internal
+} mqtt_reasm_buf_t;
+
+typedef struct {
+    uint32_t messages;      // complete messages delivered
+    uint32_t direct;        // … in place, without a copy
+    uint32_t fragments;     // events that carried part of a message
+    uint32_t held;          // messages kept past their handler
+    uint32_t oversize;      // over the route limit, buffer or topic size
+    uint32_t pool_empty;    // no free buffer
+    uint32_t route_busy;    // route already at MQTT_REASM_PER_ROUTE
+    uint32_t aborted;       // partial message superseded or out of sequence
+    uint8_t  in_use;        // pool buffers taken now
+    uint8_t  high_water;    // most taken at once
+} mqtt_reasm_stats_t;
+
+typedef struct {
+    mqtt_reasm_buf_t   buf[MQTT_REASM_BUFS];
+    mqtt_reasm_buf_t  *cur;             // being filled
+    bool               skipping;        // rest of a dropped message
+    uint8_t            per_route[TOPIC_ROUTER_MAX_ROUTES];
+    mqtt_reasm_stats_t stats;
+} mqtt_reasm_t;
+
+/** A complete message; @c buf is NULL when delivered in place. */
+typedef struct {
+    const char       *topic;
+    int               topic_len;
+    const char       *data;
+    int               len;
+    int               route;
+    mqtt_reasm_buf_t *buf;
+} mqtt_reasm_msg_t;
+
+typedef enum {
+    MQTT_REASM_MORE = 0,        /* fragment stored, message incomplete */
+    MQTT_REASM_DONE,            /* *out holds a complete message */
+    MQTT_REASM_DROP,            /* message (or its rest) discarded */
+} mqtt_reasm_status_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void mqtt_reasm_init(mqtt_reasm_t *r);
+
+/**
+ * Feed one data event.
+ * @param route    route index for the first fragment (offset 0), −1 if
+ *                 the topic is not routed; ignored for later fragments
+ * @param max_len  the route's payload limit, 0 = buffer size only
+ * @return MQTT_REASM_DONE with @p out filled once the message is whole;
+ *         then call mqtt_reasm_done() after dispatching it
+ */
+mqtt_reasm_status_t mqtt_reasm_feed(mqtt_reasm_t *r, int route, uint16_t max_len,
+                                    const char *topic, int topic_len,
+                                    const char *data, int len, int offset, int total,
+                                    mqtt_reasm_msg_t *out);
+
+/**
+ * Keep @p msg past mqtt_reasm_done() (call from its handler). Copies
+ * only a message delivered in place.
+ * @return the buffer to read and later return, or NULL (counted)
+ */
+mqtt_reasm_buf_t *mqtt_reasm_hold(mqtt_reasm_t *r, const mqtt_reasm_msg_t *msg);
+
+/** Finish dispatching @p msg: frees its buffer unless it is held. */
+void mqtt_reasm_done(mqtt_reasm_t *r, const mqtt_reasm_msg_t *msg);
+
+/** Give a held buffer back (any task). */
+void mqtt_reasm_return(mqtt_reasm_buf_t *b);
+
+/** Drop a partially received message (e.g. on disconnect). */
+void mqtt_reasm_abort(mqtt_reasm_t *r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MQTT_REASM_H */
@@ -0,0 +1,272 @@
+/*=====================================================================
+ * mqtt_wire.c — MQTT 5 aliases / properties, wire byte accounting
+ *====================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "deferred_log.h"
+#include "motor_control.h"
+#include "mqtt_wire.h"
+
+static const char *TAG = "MQTT_WIRE";
+
+#define WIRE_ALIAS_MAX          4       /* aliases we accept from the broker */
+#define WIRE_STATE_ALIAS        1
+#define WIRE_EXPIRY_S           1
+#define WIRE_SEQ_WINDOW         64      /* older by more → publisher restarted */
+#define WIRE_RX_STREAMS         8       /* route × publisher pairs tracked */
+#define WIRE_SRC_MAX            24      /* "src" bytes kept, NUL included */
+
+/* Wire accounting (publishing tasks hold the client lock) */
+static uint32_t g_tx_msgs = 0;
+static uint64_t g_tx_bytes = 0;         // as sent
+static uint64_t g_tx_bytes_311 = 0;     // same messages as MQTT 3.1.1
+static int64_t  g_report_us = 0;
+static uint32_t g_rx_dropped = 0;       // stale / out‑of‑order commands
+
+/* Bytes of a remaining‑length / property‑length varint. */
+static int varint_len(int n)
+{
+    return n < 128 ? 1 : n < 16384 ? 2 : n < 2097152 ? 3 : 4;
+}
+
+/* PUBLISH packet size: fixed header + topic + [packet id] + [props] + payload. */
+static int publish_size(int topic_len, int qos, int props_len, bool v5, int payload_len)
+{
+    int rem = 2 + topic_len + (qos ? 2 : 0) + payload_len;
+    if (v5) rem += varint_len(props_len) + props_len;
+    return 1 + varint_len(rem) + rem;
+}
+
+static void account(int sent, int as_311)
+{
+    g_tx_msgs++;
+    g_tx_bytes += sent;
+    g_tx_bytes_311 += as_311;
+
+    int64_t now = esp_timer_get_time();
+    if (g_report_us == 0) g_report_us = now;
+    int64_t win_us = now - g_report_us;
+    if (win_us < (int64_t)MQTT_WIRE_REPORT_S * 1000000) return;
+
+    uint32_t bps     = (uint32_t)(g_tx_bytes * 1000000 / win_us);
+    uint32_t bps_311 = (uint32_t)(g_tx_bytes_311 * 1000000 / win_us);
+    ESP_LOGI(TAG, "tx %" PRIu32 " msgs: %" PRIu32 " B/s sent, %" PRIu32
+             " B/s as MQTT 3.1.1 (%+" PRId32 " B/s); %" PRIu32 " stale commands dropped",
+             g_tx_msgs, bps, bps_311, (int32_t)bps_311 - (int32_t)bps, g_rx_dropped);
+    g_tx_msgs = 0;
+    g_tx_bytes = g_tx_bytes_311 = 0;
+    g_report_us = now;
+}
+
+#if CONFIG_MQTT_APP_V5
+
+/* Session state */
+static bool     g_alias_sent;           // full state topic went out with the alias
+static bool     g_alias_ok;             // broker accepts our alias
+static bool     g_empty_topic_ok;       // client accepts "" + alias
+static uint32_t g_tx_seq;
+
+/* Receive timing per command stream: one route × one publisher ("src"
+ * user property; publishers without one share a stream). Each has its
+ * own seq counter and clock offset, so two controllers never drop each
+ * other's commands. Only the MQTT event task touches these. */
+typedef struct {
+    bool        used;
+    const void *route;
+    char        src[WIRE_SRC_MAX];
+    bool        have_seq;
+    uint32_t    seq;
+    bool        have_delay;
+    int64_t     min_delay_ms;           // best (now − ts) seen this session
+    int64_t     used_ms;                // last command, for eviction
+} wire_stream_t;
+
+static wire_stream_t g_rx_streams[WIRE_RX_STREAMS];
+
+void mqtt_wire_configure(esp_mqtt_client_config_t *cfg)
+{
+    cfg->session.protocol_ver = MQTT_PROTOCOL_V_5;
+}
+
+void mqtt_wire_client_created(esp_mqtt_client_handle_t c)
+{
+    esp_mqtt5_connection_property_config_t prop = {
+        .session_expiry_interval = 0,           // nothing queued while away
+        .topic_alias_maximum     = WIRE_ALIAS_MAX,
+        .request_problem_info    = true,
+    };
+    if (esp_mqtt5_client_set_connect_property(c, &prop) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to set MQTT 5 connect properties");
+    }
+}
+
+void mqtt_wire_session_start(void)
+{
+    g_alias_sent     = false;
+    g_alias_ok       = true;
+    g_empty_topic_ok = true;
+    g_tx_seq         = 0;
+    memset(g_rx_streams, 0, sizeof(g_rx_streams));
+}
+
+/* user property entry: id + key (2+len) + value (2+len) */
+static int user_prop_len(const char *k, const char *v)
+{
+    return 1 + 2 + (int)strlen(k) + 2 + (int)strlen(v);
+}
+
+int mqtt_wire_publish(esp_mqtt_client_handle_t c, const char *topic,
+                      const char *data, int len, int qos, int flags)
+{
+    int topic_len = (int)strlen(topic);
+    esp_mqtt5_publish_property_config_t prop = {0};
+    int props_len = 0;
+    char seq[12], ts[21];
+
+    if (flags & MQTT_WIRE_TIMED) {
+        snprintf(seq, sizeof(seq), "%" PRIu32, g_tx_seq++);
+        snprintf(ts, sizeof(ts), "%" PRId64, esp_timer_get_time() / 1000);
+        esp_mqtt5_user_property_item_t items[] = { {"seq", seq}, {"ts", ts} };
+        esp_mqtt5_client_set_user_property(&prop.user_property, items, 2);
+        prop.message_expiry_interval = WIRE_EXPIRY_S;
+        props_len += user_prop_len("seq", seq) + user_prop_len("ts", ts) + 5;
+    }
+
+    const char *send_topic = topic;
+    if ((flags & MQTT_WIRE_ALIAS_STATE) && g_alias_ok) {
+        prop.topic_alias = WIRE_STATE_ALIAS;
+        props_len += 3;
+        if (g_alias_sent && g_empty_topic_ok) send_topic = "";
+    }
+
+    int msg_id = -1;
+    if (esp_mqtt5_client_set_publish_property(c, &prop) != ESP_OK && prop.topic_alias) {
+        /* broker's topic‑alias maximum is below our slot */
+        ESP_LOGW(TAG, "Broker refuses topic aliases; sending full topics");
+        g_alias_ok = false;
+        prop.topic_alias = 0;
+        props_len -= 3;
+        send_topic = topic;
+        esp_mqtt5_client_set_publish_property(c, &prop);
+    }
+    msg_id = esp_mqtt_client_publish(c, send_topic, data, len, qos, 0);
+    if (msg_id < 0 && send_topic != topic) {
+        ESP_LOGW(TAG, "Empty topic with alias rejected; keeping full topics");
+        g_empty_topic_ok = false;
+        send_topic = topic;
+        esp_mqtt5_client_set_publish_property(c, &prop);
+        msg_id = esp_mqtt_client_publish(c, send_topic, data, len, qos, 0);
+    }
+    if (prop.user_property) esp_mqtt5_client_delete_user_property(prop.user_property);
+
+    if (msg_id >= 0) {
+        if (prop.topic_alias) g_alias_sent = true;
+        account(publish_size(send_topic == topic ? topic_len : 0, qos, props_len, true, len),
+                publish_size(topic_len, qos, 0, false, len));
+    }
+    return msg_id;
+}
+
+/* The stream of @route from @src, or the least recently used one reset
+ * for it (a forgotten publisher just re-learns its seq and offset). */
+static wire_stream_t *rx_stream(const void *route, const char *src, int64_t now_ms)
+{
+    wire_stream_t *victim = &g_rx_streams[0];
+    for (int i = 0; i < WIRE_RX_STREAMS; i++) {
+        wire_stream_t *st = &g_rx_streams[i];
+        if (st->used && st->route == route && strncmp(st->src, src, WIRE_SRC_MAX - 1) == 0) {
+            st->used_ms = now_ms;
+            return st;
+        }
+        if (victim->used && (!st->used || st->used_ms < victim->used_ms)) victim = st;
+    }
+    memset(victim, 0, sizeof(*victim));
+    victim->used  = true;
+    victim->route = route;
+    strncpy(victim->src, src, WIRE_SRC_MAX - 1);
+    victim->used_ms = now_ms;
+    return victim;
+}
+
+bool mqtt_wire_command_fresh(const esp_mqtt_event_t *event, const void *route)
+{
+    if (!event->property || !event->property->user_property) return true;
+
+    esp_mqtt5_user_property_item_t items[4];
+    uint8_t count = sizeof(items) / sizeof(items[0]);
+    if (esp_mqtt5_client_get_user_property(event->property->user_property,
+                                           items, &count) != ESP_OK) {
+        return true;
+    }
+
+    const char *seq_str = NULL, *ts_str = NULL, *src = "";
+    for (uint8_t i = 0; i < count; i++) {
+        if      (strcmp(items[i].key, "seq") == 0) seq_str = items[i].value;
+        else if (strcmp(items[i].key, "ts")  == 0) ts_str  = items[i].value;
+        else if (strcmp(items[i].key, "src") == 0) src     = items[i].value;
+    }
+
+    bool fresh = true;
+    int64_t now_ms = esp_timer_get_time() / 1000;
+    wire_stream_t *st = (seq_str || ts_str) ? rx_stream(route, src, now_ms) : NULL;
+    if (seq_str) {
+        uint32_t seq = strtoul(seq_str, NULL, 10);
+        int32_t diff = (int32_t)(seq - st->seq);
+        if (st->have_seq && diff <= 0 && diff > -WIRE_SEQ_WINDOW) {
+            DLOGW(TAG, "Command seq %d not newer than %d, dropped",
+                  (int32_t)seq, (int32_t)st->seq);
+            fresh = false;
+        } else {
+            st->seq = seq;
+            st->have_seq = true;
+        }
+    }
+    if (fresh && ts_str) {
+        int64_t delay = now_ms - strtoll(ts_str, NULL, 10);
+        if (!st->have_delay || delay < st->min_delay_ms) {
+            st->min_delay_ms = delay;
+            st->have_delay = true;
+        } else if (delay - st->min_delay_ms > MOTOR_DECAY_MS) {
+            DLOGW(TAG, "Command %d ms late, dropped",
+                  (int32_t)(delay - st->min_delay_ms));
+            fresh = false;
+        }
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        free((void *)items[i].key);
+        free((void *)items[i].value);
+    }
+    if (!fresh) g_rx_dropped++;
+    return fresh;
+}
+
+#else  /* MQTT 3.1.1 */
+
+void mqtt_wire_configure(esp_mqtt_client_config_t *cfg) {}
+void mqtt_wire_client_created(esp_mqtt_client_handle_t c) {}
+void mqtt_wire_session_start(void) {}
+
+int mqtt_wire_publish(esp_mqtt_client_handle_t c, const char *topic,
+                      const char *data, int len, int qos, int flags)
+{
+    int msg_id = esp_mqtt_client_publish(c, topic, data, len, qos, 0);
+    if (msg_id >= 0) {
+        int size = publish_size((int)strlen(topic), qos, 0, false, len);
+        account(size, size);
+    }
+    return msg_id;
+}
+
+bool mqtt_wire_command_fresh(const esp_mqtt_event_t *event, const void *route)
+{
+    return true;
+}
+
+#endif /* CONFIG_MQTT_APP_V5 */
@@ -0,0 +1,76 @@
+/*=====================================================================
+ * mqtt_wire.h — Protocol‑level publish/receive helpers (3.1.1 / 5)
+ *
+ * With CONFIG_MQTT_APP_V5 the client connects with MQTT 5 and:
+ *  • announces a topic‑alias maximum, so the broker may alias the
+ *    high‑rate command topic towards the chair;
+ *  • publishes the state topic under a topic alias — the full topic
+ *    once per session, an empty topic after that;
+ *  • attaches user properties "seq" and "ts" (ms since boot) to state
+ *    messages, and a 1 s message expiry, so a broker never delivers
+ *    stale state late (CONFIG_MQTT_APP_V5_TIMING).  "seq" is one
+ *    counter per session shared by every MQTT_WIRE_TIMED publish —
+ *    contiguous per topic only while state is the one timed topic;
+ *  • drops motor commands whose "seq" user property is not newer than
+ *    the last one, or whose "ts" arrives more than MOTOR_DECAY_MS later
+ *    than the best delay seen this session (the offset between the
+ *    publisher's clock and ours is learnt, not assumed).  Both are kept
+ *    per route and per publisher, named by a "src" user property, so
+ *    several controllers each keep their own counter and clock.
+ * Without it everything is plain MQTT 3.1.1 and commands always pass.
+ *
+ * Every publish is sized both as sent and as the equivalent 3.1.1
+ * packet; the totals are logged every MQTT_WIRE_REPORT_S.
+ * tools/mqtt_wire_bytes.py computes the same for given message rates.
+ *====================================================================*/
+
+#ifndef MQTT_WIRE_H
+#define MQTT_WIRE_H
+
+#include <stdbool.h>
+#include "mqtt_client.h"
+
+#ifndef MQTT_WIRE_REPORT_S
+#define MQTT_WIRE_REPORT_S      60
+#endif
+
+/* Publish flags */
+#define MQTT_WIRE_TIMED         (1 << 0)    /* seq/ts properties, 1 s expiry; shared seq */
+#define MQTT_WIRE_ALIAS_STATE   (1 << 1)    /* topic alias slot 1 */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Select the protocol version in the client config. */
+void mqtt_wire_configure(esp_mqtt_client_config_t *cfg);
+
+/** Set connect properties on a freshly created client. */
+void mqtt_wire_client_created(esp_mqtt_client_handle_t c);
+
+/** New session: aliases must be re‑established, delays re‑learnt. */
+void mqtt_wire_session_start(void);
+
+/**
+ * esp_mqtt_client_publish() with the properties selected by @p flags.
+ * Call with the client lock held.
+ * @return message id, or −1
+ */
+int mqtt_wire_publish(esp_mqtt_client_handle_t c, const char *topic,
+                      const char *data, int len, int qos, int flags);
+
+/**
+ * Check the timing properties of an incoming command against the last
+ * ones from the same publisher on the same route. Call from the MQTT
+ * event task only.
+ * @param route  identifies the route, compared as a value: pass the
+ *               same constant every time (e.g. the route's ctx)
+ * @return false if it is a duplicate, out of order or stale
+ */
+bool mqtt_wire_command_fresh(const esp_mqtt_event_t *event, const void *route);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MQTT_WIRE_H */
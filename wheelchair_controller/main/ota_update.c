@@ -0,0 +1,406 @@
+/*=====================================================================
+ * ota_update.c — HTTP(S) streaming into the spare OTA slot
+ *====================================================================*/
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <inttypes.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "esp_app_format.h"
+#include "esp_http_client.h"
+#include "esp_crt_bundle.h"
+#include "esp_delta_ota.h"
+#include "mbedtls/sha256.h"
+#include "cJSON.h"
+#include "motor_control.h"
+#include "mqtt_client_app.h"
+#include "mem_report.h"
+#include "ota_update.h"
+
+static const char *TAG = "OTA";
+
+#define OTA_STACK_BYTES         8192    // esp_http_client + TLS handshake
+#define OTA_CHUNK_BYTES         4096
+#define OTA_URL_MAX             256
+#define OTA_HTTP_TIMEOUT_MS     10000
+#define OTA_STATUS_PERIOD_MS    1000
+
+#if CONFIG_OTA_ALLOW_HTTP
+#define OTA_ALLOW_HTTP          1
+#else
+#define OTA_ALLOW_HTTP          0
+#endif
+
+#if CONFIG_OTA_REQUIRE_SIGNED && !CONFIG_SECURE_SIGNED_ON_UPDATE
+#error "CONFIG_OTA_REQUIRE_SIGNED needs app signing (SECURE_SIGNED_APPS_NO_SECURE_BOOT or SECURE_BOOT)"
+#endif
+
+typedef struct {
+    char url[OTA_URL_MAX];
+    char sha256[65];                    // download digest (required)
+    char base[65];                      // delta only
+    bool delta;
+} ota_job_t;
+
+static ota_job_t g_job;
+static volatile bool g_busy = false;
+static TaskHandle_t s_ota_task = NULL;
+static StackType_t  s_ota_stack[OTA_STACK_BYTES];
+static StaticTask_t s_ota_tcb;
+static uint8_t      s_chunk[OTA_CHUNK_BYTES];
+
+/* Per‑update state shared with the delta callbacks */
+static const esp_partition_t *s_running;
+static esp_ota_handle_t s_ota_handle;
+static uint8_t  s_hdr[sizeof(esp_image_header_t)];
+static size_t   s_hdr_len;
+static uint32_t s_written;
+
+static esp_timer_handle_t s_verify_timer = NULL;
+
+/*---------------------------------------------------------------------
+ * Helpers
+ *-------------------------------------------------------------------*/
+
+static void publish_status(const char *state, uint32_t bytes, const char *err)
+{
+    char msg[160];
+    int len = snprintf(msg, sizeof(msg),
+                       "{\"state\":\"%s\",\"bytes\":%" PRIu32 "%s%s%s}",
+                       state, bytes,
+                       err ? ",\"error\":\"" : "", err ? err : "", err ? "\"" : "");
+    if (len > 0 && len < (int)sizeof(msg)) {
+        mqtt_app_publish(MQTT_OTA_STATUS_TOPIC, msg, len, 1);
+    }
+}
+
+static void to_hex(const uint8_t *in, size_t n, char *out)
+{
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < n; i++) {
+        out[2 * i]     = digits[in[i] >> 4];
+        out[2 * i + 1] = digits[in[i] & 0xF];
+    }
+    out[2 * n] = '\0';
+}
+
+/* Every byte of the new image goes through here (full and delta). */
+static esp_err_t image_sink(const uint8_t *buf, size_t size)
+{
+    /* Reject images for another chip before anything is written. */
+    if (s_hdr_len < sizeof(s_hdr)) {
+        size_t n = sizeof(s_hdr) - s_hdr_len;
+        if (n > size) n = size;
+        memcpy(s_hdr + s_hdr_len, buf, n);
+        s_hdr_len += n;
+        if (s_hdr_len == sizeof(s_hdr)) {
+            const esp_image_header_t *h = (const esp_image_header_t *)s_hdr;
+            if (h->magic != ESP_IMAGE_HEADER_MAGIC ||
+                h->chip_id != CONFIG_IDF_FIRMWARE_CHIP_ID) {
+                ESP_LOGE(TAG, "Not an image for this chip (magic 0x%02x, chip %d)",
+                         h->magic, h->chip_id);
+                return ESP_ERR_OTA_VALIDATE_FAILED;
+            }
+        }
+    }
+    s_written += size;
+    return esp_ota_write(s_ota_handle, buf, size);
+}
+
+static esp_err_t delta_write_cb(const uint8_t *buf_p, size_t size, void *user_data)
+{
+    return image_sink(buf_p, size);
+}
+
+static esp_err_t delta_read_cb(uint8_t *buf_p, size_t size, int src_offset)
+{
+    return esp_partition_read(s_running, src_offset, buf_p, size);
+}
+
+/*---------------------------------------------------------------------
+ * One update
+ *-------------------------------------------------------------------*/
+
+static esp_err_t run_update(const ota_job_t *job, const char **why)
+{
+    s_running = esp_ota_get_running_partition();
+    const esp_partition_t *target = esp_ota_get_next_update_partition(NULL);
+    if (target == NULL) {
+        *why = "no OTA slot";
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (job->delta) {
+        uint8_t digest[32];
+        char hex[65];
+        if (esp_partition_get_sha256(s_running, digest) != ESP_OK) {
+            *why = "cannot hash running image";
+            return ESP_FAIL;
+        }
+        to_hex(digest, sizeof(digest), hex);
+        if (strcasecmp(hex, job->base) != 0) {
+            *why = "patch base does not match running image";
+            return ESP_ERR_INVALID_VERSION;
+        }
+    }
+
+    esp_http_client_config_t http_cfg = {
+        .url               = job->url,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+        .timeout_ms        = OTA_HTTP_TIMEOUT_MS,
+        .buffer_size       = 1024,
+    };
+    esp_http_client_handle_t http = esp_http_client_init(&http_cfg);
+    if (http == NULL) {
+        *why = "http init";
+        return ESP_FAIL;
+    }
+
+    esp_err_t err = esp_http_client_open(http, 0);
+    if (err != ESP_OK) {
+        *why = "http open";
+        esp_http_client_cleanup(http);
+        return err;
+    }
+    int64_t total = esp_http_client_fetch_headers(http);
+    int status = esp_http_client_get_status_code(http);
+    if (status != 200) {
+        ESP_LOGE(TAG, "HTTP status %d", status);
+        *why = "http status";
+        esp_http_client_cleanup(http);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "%s update: %" PRId64 " bytes from %s into %s",
+             job->delta ? "Delta" : "Full", total, job->url, target->label);
+
+    err = esp_ota_begin(target, OTA_WITH_SEQUENTIAL_WRITES, &s_ota_handle);
+    if (err != ESP_OK) {
+        *why = "ota begin";
+        esp_http_client_cleanup(http);
+        return err;
+    }
+    s_hdr_len = 0;
+    s_written = 0;
+
+    esp_delta_ota_handle_t delta = NULL;
+    if (job->delta) {
+        esp_delta_ota_cfg_t dcfg = {
+            .read_cb  = delta_read_cb,
+            .write_cb = delta_write_cb,
+        };
+        delta = esp_delta_ota_init(&dcfg);
+        if (delta == NULL) {
+            *why = "delta init";
+            err = ESP_FAIL;
+        }
+    }
+
+    mbedtls_sha256_context sha;
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+
+    uint32_t received = 0;
+    int64_t next_status = 0;
+    while (err == ESP_OK) {
+        int n = esp_http_client_read(http, (char *)s_chunk, sizeof(s_chunk));
+        if (n < 0) {
+            *why = "http read";
+            err = ESP_FAIL;
+            break;
+        }
+        if (n == 0) {
+            if (!esp_http_client_is_complete_data_received(http)) {
+                *why = "connection closed early";
+                err = ESP_FAIL;
+            }
+            break;
+        }
+        received += n;
+        mbedtls_sha256_update(&sha, s_chunk, n);
+        err = job->delta ? esp_delta_ota_feed_patch(delta, s_chunk, n)
+                         : image_sink(s_chunk, n);
+        if (err != ESP_OK) {
+            *why = job->delta ? "patch apply" : "image write";
+        }
+
+        int64_t now = esp_timer_get_time();
+        if (now >= next_status) {
+            publish_status("downloading", received, NULL);
+            next_status = now + OTA_STATUS_PERIOD_MS * 1000;
+        }
+    }
+    esp_http_client_cleanup(http);
+
+    if (err == ESP_OK && delta) {
+        err = esp_delta_ota_finalize(delta);
+        if (err != ESP_OK) *why = "patch finalize";
+    }
+    if (delta) esp_delta_ota_deinit(delta);
+
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&sha, digest);
+    mbedtls_sha256_free(&sha);
+    if (err == ESP_OK) {
+        char hex[65];
+        to_hex(digest, sizeof(digest), hex);
+        if (strcasecmp(hex, job->sha256) != 0) {
+            *why = "download sha256 mismatch";
+            err = ESP_ERR_INVALID_CRC;
+        }
+    }
+
+    if (err != ESP_OK) {
+        esp_ota_abort(s_ota_handle);
+        return err;
+    }
+
+    publish_status("verifying", received, NULL);
+    err = esp_ota_end(s_ota_handle);            // full image hash / signature
+    if (err != ESP_OK) {
+        *why = "image validation";
+        return err;
+    }
+    err = esp_ota_set_boot_partition(target);
+    if (err != ESP_OK) {
+        *why = "set boot partition";
+        return err;
+    }
+    ESP_LOGI(TAG, "Update OK: %" PRIu32 " bytes downloaded, %" PRIu32 " bytes image",
+             received, s_written);
+    publish_status("rebooting", received, NULL);
+    return ESP_OK;
+}
+
+static void ota_task(void *arg)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        motor_set_lockout(MOTOR_LOCK_UPDATE, true);     // e‑stop for the whole update
+        const char *why = "";
+        esp_err_t err = run_update(&g_job, &why);
+        if (err == ESP_OK) {
+            vTaskDelay(pdMS_TO_TICKS(500));     // let the status go out
+            esp_restart();
+        }
+
+        ESP_LOGE(TAG, "Update failed: %s (%s)", why, esp_err_to_name(err));
+        publish_status("failed", 0, why);
+        motor_set_lockout(MOTOR_LOCK_UPDATE, false);
+        g_busy = false;
+    }
+}
+
+/*---------------------------------------------------------------------
+ * Rollback guard
+ *-------------------------------------------------------------------*/
+
+static void on_ota_command(const char *topic, int topic_len,
+                           const char *data, int data_len, void *ctx)
+{
+    ota_update_request(data, data_len);
+}
+
+static void verify_timeout_cb(void *arg)
+{
+    ESP_LOGE(TAG, "New image did not reach MQTT within %d s — rolling back",
+             CONFIG_OTA_VERIFY_TIMEOUT_S);
+    esp_ota_mark_app_invalid_rollback_and_reboot();
+}
+
+/*=====================================================================
+ * Public API
+ *====================================================================*/
+
+void ota_update_init(void)
+{
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    esp_ota_img_states_t state;
+    if (esp_ota_get_state_partition(running, &state) == ESP_OK &&
+        state == ESP_OTA_IMG_PENDING_VERIFY) {
+        ESP_LOGW(TAG, "Running new image from %s; confirming once MQTT connects",
+                 running->label);
+        const esp_timer_create_args_t targs = {
+            .callback = verify_timeout_cb,
+            .name     = "ota_verify",
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&targs, &s_verify_timer));
+        ESP_ERROR_CHECK(esp_timer_start_once(s_verify_timer,
+                                             CONFIG_OTA_VERIFY_TIMEOUT_S * 1000000ULL));
+    }
+
+#if !CONFIG_SECURE_SIGNED_ON_UPDATE
+    ESP_LOGW(TAG, "Updates are not signature-checked; only the commanded sha256 is verified");
+#endif
+    s_ota_task = xTaskCreateStatic(ota_task, "ota", OTA_STACK_BYTES, NULL,
+                                   tskIDLE_PRIORITY + 3, s_ota_stack, &s_ota_tcb);
+    mem_report_register_task(s_ota_task, OTA_STACK_BYTES);
+    mqtt_app_register_topic(MQTT_OTA_CMD_TOPIC, 1, on_ota_command, NULL);
+}
+
+void ota_update_mark_healthy(void)
+{
+    if (s_verify_timer == NULL) return;
+
+    esp_timer_stop(s_verify_timer);
+    esp_timer_delete(s_verify_timer);
+    s_verify_timer = NULL;
+    if (esp_ota_mark_app_valid_cancel_rollback() == ESP_OK) {
+        ESP_LOGI(TAG, "New image confirmed");
+        publish_status("valid", 0, NULL);
+    }
+}
+
+void ota_update_request(const char *data, int data_len)
+{
+    if (s_ota_task == NULL) return;
+    if (g_busy) {
+        ESP_LOGW(TAG, "Update already in progress");
+        return;
+    }
+
+    cJSON *root = cJSON_ParseWithLength(data, data_len);
+    if (root == NULL) {
+        ESP_LOGE(TAG, "Failed to parse OTA command JSON");
+        return;
+    }
+    const cJSON *url   = cJSON_GetObjectItemCaseSensitive(root, "url");
+    const cJSON *sha   = cJSON_GetObjectItemCaseSensitive(root, "sha256");
+    const cJSON *base  = cJSON_GetObjectItemCaseSensitive(root, "base");
+    const cJSON *delta = cJSON_GetObjectItemCaseSensitive(root, "delta");
+
+    const char *err = NULL;
+    if (!cJSON_IsString(url) || strlen(url->valuestring) >= OTA_URL_MAX) {
+        err = "missing or too long 'url'";
+    } else if (strncmp(url->valuestring, "https://", 8) != 0 &&
+               !(OTA_ALLOW_HTTP && strncmp(url->valuestring, "http://", 7) == 0)) {
+        err = "'url' must be https://";
+    } else if (!cJSON_IsString(sha) || strlen(sha->valuestring) != 64) {
+        err = "missing 'sha256' (64 hex digits)";
+    } else if (cJSON_IsTrue(delta) &&
+               (!cJSON_IsString(base) || strlen(base->valuestring) != 64)) {
+        err = "delta update needs 'base' (64 hex digits)";
+    }
+
+    if (err == NULL) {
+        memset(&g_job, 0, sizeof(g_job));
+        strcpy(g_job.url, url->valuestring);
+        strcpy(g_job.sha256, sha->valuestring);
+        g_job.delta = cJSON_IsTrue(delta);
+        if (g_job.delta) strcpy(g_job.base, base->valuestring);
+        g_busy = true;
+        xTaskNotifyGive(s_ota_task);
+    } else {
+        ESP_LOGE(TAG, "Invalid OTA command: %s", err);
+        publish_status("rejected", 0, err);
+    }
+    cJSON_Delete(root);
+}
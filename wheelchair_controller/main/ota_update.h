@@ -0,0 +1,52 @@
+/*=====================================================================
+ * ota_update.h — Streaming full / delta firmware updates with rollback
+ *
+ *  • Triggered by a JSON command on MQTT_OTA_CMD_TOPIC:
+ *      {"url":"https://…/fw.bin","sha256":"<hex>"}              full image
+ *      {"url":"https://…/patch.bin","sha256":"<hex>",
+ *       "delta":true,"base":"<hex>"}                            delta patch
+ *    "sha256" (required) is the digest of the downloaded file; "base"
+ *    is the image digest of the running app the patch was made against.
+ *    The digest comes over the same channel as the URL, so it only
+ *    guards the transfer: with CONFIG_OTA_REQUIRE_SIGNED, esp_ota_end()
+ *    also rejects images not signed with the project key.
+ *  • Downloads over HTTPS in fixed chunks straight into the inactive
+ *    OTA slot (delta patches through esp_delta_ota, reading the
+ *    running image as the source). The file digest is computed while
+ *    streaming; the image header is checked on the first bytes and the
+ *    whole image is validated by esp_ota_end().
+ *  • The motors are locked out (held at zero) for the whole update.
+ *  • A new image boots in "pending verify" state and must reach an
+ *    MQTT session within CONFIG_OTA_VERIFY_TIMEOUT_S; otherwise (or
+ *    if it resets before that) the bootloader rolls back.
+ *  • Progress is published on MQTT_OTA_STATUS_TOPIC.
+ *  tools/ota_publish.py builds the patch, serves it and sends the command.
+ *====================================================================*/
+
+#ifndef OTA_UPDATE_H
+#define OTA_UPDATE_H
+
+#define MQTT_OTA_CMD_TOPIC      "wheelchair/command/ota"
+#define MQTT_OTA_STATUS_TOPIC   "wheelchair/ota/status"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Start the OTA task, route MQTT_OTA_CMD_TOPIC to it and arm the
+ * rollback timer when booting a new image.
+ */
+void ota_update_init(void);
+
+/** Queue an update from an MQTT command payload (not NUL‑terminated). */
+void ota_update_request(const char *data, int data_len);
+
+/** Called once an MQTT session is up: confirms a pending new image. */
+void ota_update_mark_healthy(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OTA_UPDATE_H */
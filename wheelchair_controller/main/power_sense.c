@@ -0,0 +1,412 @@
+/*=====================================================================
+ * power_sense.c — ADC continuous sampling → sense_pipeline → cutback
+ *====================================================================*/
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "power_sense.h"
+
+static const char *TAG = "POWER_SENSE";
+
+#if CONFIG_POWER_SENSE
+
+#include "esp_attr.h"
+#include "motor_control.h"
+#include "mqtt_client_app.h"
+#include "mem_report.h"
+#include "sense_pipeline.h"
+#include "sense_fake.h"
+#if !CONFIG_POWER_SENSE_FAKE
+#include "esp_adc/adc_continuous.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#endif
+
+/*---------------------------------------------------------------------
+ * Configuration (may be overridden at compile time)
+ *-------------------------------------------------------------------*/
+#ifndef POWER_SENSE_FRAME_SAMPLES
+#define POWER_SENSE_FRAME_SAMPLES   128   /* per DMA frame, all channels */
+#endif
+#ifndef POWER_SENSE_CURRENT_LPF_SHIFT
+#define POWER_SENSE_CURRENT_LPF_SHIFT 2   /* telemetry only; trip uses raw decimated */
+#endif
+#ifndef POWER_SENSE_VOLTAGE_LPF_SHIFT
+#define POWER_SENSE_VOLTAGE_LPF_SHIFT 6
+#endif
+#ifndef POWER_SENSE_STACK_BYTES
+#define POWER_SENSE_STACK_BYTES     3072
+#endif
+#ifndef POWER_SENSE_TASK_PRIO
+#define POWER_SENSE_TASK_PRIO       (tskIDLE_PRIORITY + 6)  /* above MQTT */
+#endif
+#ifndef POWER_SENSE_FAKE_MA_PER_PERCENT
+#define POWER_SENSE_FAKE_MA_PER_PERCENT 150
+#endif
+#ifndef POWER_SENSE_FAKE_NOISE
+#define POWER_SENSE_FAKE_NOISE      12    /* ± counts */
+#endif
+
+#define PS_LEFT     0
+#define PS_RIGHT    1
+#define PS_PACK     2
+#define PS_NCHAN    3
+
+#define PS_RELEASE_PERCENT  80      /* of the trip level */
+#define PS_PAYLOAD_MAX      128
+
+/* Nominal ADC transfer at 12 dB when no eFuse calibration exists. */
+#define PS_NOMINAL_FULL_MV  3100
+
+/*---------------------------------------------------------------------
+ * State
+ *-------------------------------------------------------------------*/
+static sense_chan_t g_chan[PS_NCHAN];           // sense task only
+static sense_oc_t   g_oc[2];
+
+static power_sense_t g_snapshot;
+static portMUX_TYPE  g_lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint32_t g_overruns = 0;        // DMA pool overflows
+
+static char g_payload[PS_PAYLOAD_MAX];
+
+static StackType_t  s_sense_stack[POWER_SENSE_STACK_BYTES];
+static StaticTask_t s_sense_tcb;
+static TaskHandle_t g_task = NULL;
+
+/*---------------------------------------------------------------------
+ * Pipeline
+ *-------------------------------------------------------------------*/
+
+/* Configure the channel gains from the ADC transfer
+ * mV(raw) = mv0 + raw · mv_slope_q16 / 65536. */
+static void pipeline_init(int32_t mv0, int32_t mv_slope_q16)
+{
+    const int64_t mv_per_a = CONFIG_CURRENT_SENSE_MV_PER_A;
+    const int64_t zero_mv  = CONFIG_CURRENT_SENSE_ZERO_MV;
+    const int64_t div      = CONFIG_PACK_DIVIDER_RATIO_X1000;
+
+    for (int s = PS_LEFT; s <= PS_RIGHT; s++) {
+        sense_chan_init(&g_chan[s], CONFIG_POWER_SENSE_DECIMATION,
+                        POWER_SENSE_CURRENT_LPF_SHIFT,
+                        (int32_t)(mv_slope_q16 * 1000 / mv_per_a),
+                        (int32_t)((mv0 - zero_mv) * 1000 / mv_per_a));
+    }
+    sense_chan_init(&g_chan[PS_PACK], CONFIG_POWER_SENSE_DECIMATION,
+                    POWER_SENSE_VOLTAGE_LPF_SHIFT,
+                    (int32_t)(mv_slope_q16 * div / 1000),
+                    (int32_t)(mv0 * div / 1000));
+
+    /* decimated outputs per second and per channel */
+    uint32_t out_hz = CONFIG_POWER_SENSE_SAMPLE_HZ / PS_NCHAN / CONFIG_POWER_SENSE_DECIMATION;
+    uint32_t hold   = (uint32_t)CONFIG_OVERCURRENT_HOLD_MS * out_hz / 1000;
+    int32_t  trip   = CONFIG_OVERCURRENT_TRIP_MA;
+
+    for (int s = PS_LEFT; s <= PS_RIGHT; s++) {
+        sense_oc_init(&g_oc[s], trip, trip / 100 * PS_RELEASE_PERCENT,
+                      CONFIG_OVERCURRENT_TRIP_SAMPLES, hold ? hold : 1);
+    }
+    ESP_LOGI(TAG, "%" PRIu32 " Hz per channel after decimation; trip %" PRId32
+             " mA after %d samples, cutback to %d %%",
+             out_hz, trip, CONFIG_OVERCURRENT_TRIP_SAMPLES, CONFIG_OVERCURRENT_CUTBACK_PERCENT);
+}
+
+static void feed(const sense_sample_t *smp)
+{
+    sense_chan_t *c = &g_chan[smp->idx];
+    if (!sense_chan_push(c, smp->raw) || smp->idx == PS_PACK) return;
+
+    /* Trip on the decimated value, not the low‑passed one: the filter
+     * would add its own delay on top of the decimation window. */
+    if (!sense_oc_update(&g_oc[smp->idx], c->fast)) return;
+
+    const int cut = CONFIG_OVERCURRENT_CUTBACK_PERCENT;
+    motor_set_drive_cap(g_oc[PS_LEFT].tripped  ? cut : 100,
+                        g_oc[PS_RIGHT].tripped ? cut : 100);
+    if (g_oc[smp->idx].tripped) {
+        ESP_LOGW(TAG, "Overcurrent %s: %" PRId32 " mA, output capped at %d %%",
+                 smp->idx == PS_LEFT ? "left" : "right", c->fast, cut);
+    } else {
+        ESP_LOGI(TAG, "Overcurrent %s cleared", smp->idx == PS_LEFT ? "left" : "right");
+    }
+}
+
+static void publish_snapshot(void)
+{
+    power_sense_t s = {
+        .left_ma  = g_chan[PS_LEFT].value,
+        .right_ma = g_chan[PS_RIGHT].value,
+        .pack_mv  = g_chan[PS_PACK].value,
+        .oc_left  = g_oc[PS_LEFT].tripped,
+        .oc_right = g_oc[PS_RIGHT].tripped,
+        .trips    = g_oc[PS_LEFT].trips + g_oc[PS_RIGHT].trips,
+    };
+    portENTER_CRITICAL(&g_lock);
+    g_snapshot = s;
+    portEXIT_CRITICAL(&g_lock);
+}
+
+static void send_telemetry(void)
+{
+    power_sense_t s;
+    power_sense_get(&s);
+    int len = snprintf(g_payload, sizeof(g_payload),
+                       "{\"left_ma\":%" PRId32 ",\"right_ma\":%" PRId32
+                       ",\"pack_mv\":%" PRId32 ",\"oc\":[%d,%d],\"trips\":%" PRIu32
+                       ",\"ovf\":%" PRIu32 "}",
+                       s.left_ma, s.right_ma, s.pack_mv, s.oc_left, s.oc_right,
+                       s.trips, g_overruns);
+    if (len > 0 && len < (int)sizeof(g_payload)) {
+        mqtt_app_publish(MQTT_POWER_TOPIC, g_payload, len, 0);
+    }
+}
+
+/*---------------------------------------------------------------------
+ * Sample sources
+ *-------------------------------------------------------------------*/
+#if CONFIG_POWER_SENSE_FAKE
+
+static sense_fake_t g_fake;
+
+static esp_err_t source_init(void)
+{
+    pipeline_init(0, ((int32_t)PS_NOMINAL_FULL_MV << 16) / 4095);
+    sense_fake_init(&g_fake, PS_NCHAN, POWER_SENSE_FAKE_NOISE, 0x5eed);
+    ESP_LOGW(TAG, "Using synthetic samples (CONFIG_POWER_SENSE_FAKE)");
+    return ESP_OK;
+}
+
+/* Currents follow the commanded outputs; the pack sags 50 mΩ under load. */
+static void source_run(void)
+{
+    sense_sample_t frame[POWER_SENSE_FRAME_SAMPLES];
+    int64_t last_us = esp_timer_get_time();
+    int64_t next_tele_us = last_us;
+    uint64_t owed = 0;                              // samples × 1e6
+
+    while (1) {
+        vTaskDelay(1);
+        int64_t now = esp_timer_get_time();
+        owed += (uint64_t)(now - last_us) * CONFIG_POWER_SENSE_SAMPLE_HZ;
+        last_us = now;
+
+        int l, r;
+        motor_get_speeds(&l, &r);
+        int32_t l_ma = l * POWER_SENSE_FAKE_MA_PER_PERCENT;
+        int32_t r_ma = r * POWER_SENSE_FAKE_MA_PER_PERCENT;
+        int32_t sag  = ((l_ma < 0 ? -l_ma : l_ma) + (r_ma < 0 ? -r_ma : r_ma)) / 20;
+        sense_fake_set_level(&g_fake, PS_LEFT,  sense_chan_units_to_raw(&g_chan[PS_LEFT],  l_ma));
+        sense_fake_set_level(&g_fake, PS_RIGHT, sense_chan_units_to_raw(&g_chan[PS_RIGHT], r_ma));
+        sense_fake_set_level(&g_fake, PS_PACK,  sense_chan_units_to_raw(&g_chan[PS_PACK],
+                                                                        24000 - sag));
+
+        while (owed >= 1000000ull * POWER_SENSE_FRAME_SAMPLES) {
+            owed -= 1000000ull * POWER_SENSE_FRAME_SAMPLES;
+            sense_fake_fill(&g_fake, frame, POWER_SENSE_FRAME_SAMPLES);
+            for (int i = 0; i < POWER_SENSE_FRAME_SAMPLES; i++) feed(&frame[i]);
+        }
+        publish_snapshot();
+
+        if (now >= next_tele_us) {
+            next_tele_us = now + (int64_t)CONFIG_POWER_TELEMETRY_PERIOD_MS * 1000;
+            send_telemetry();
+        }
+    }
+}
+
+#else  /* real ADC */
+
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define PS_ADC_FORMAT       ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define PS_ADC_CHANNEL(d)   ((d)->type1.channel)
+#define PS_ADC_DATA(d)      ((d)->type1.data)
+#else
+#define PS_ADC_FORMAT       ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define PS_ADC_CHANNEL(d)   ((d)->type2.channel)
+#define PS_ADC_DATA(d)      ((d)->type2.data)
+#endif
+
+#define PS_FRAME_BYTES      (POWER_SENSE_FRAME_SAMPLES * SOC_ADC_DIGI_RESULT_BYTES)
+
+static adc_continuous_handle_t g_adc = NULL;
+static uint8_t g_frame[PS_FRAME_BYTES];
+static uint8_t g_idx_of_channel[SOC_ADC_CHANNEL_NUM(ADC_UNIT_1)];
+
+static bool IRAM_ATTR on_conv_done(adc_continuous_handle_t handle,
+                                   const adc_continuous_evt_data_t *edata,
+                                   void *user_data)
+{
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(g_task, &woken);
+    return woken == pdTRUE;
+}
+
+static bool IRAM_ATTR on_pool_ovf(adc_continuous_handle_t handle,
+                                  const adc_continuous_evt_data_t *edata,
+                                  void *user_data)
+{
+    g_overruns++;
+    return false;
+}
+
+/* Linear fit of the eFuse calibration: two points are exact for the
+ * line‑fitting scheme and let the pipeline stay in raw counts. */
+static void calibrate(int32_t *mv0, int32_t *mv_slope_q16)
+{
+    *mv0 = 0;
+    *mv_slope_q16 = ((int32_t)PS_NOMINAL_FULL_MV << 16) / 4095;
+
+#if ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    adc_cali_handle_t cali = NULL;
+    adc_cali_line_fitting_config_t cfg = {
+        .unit_id  = ADC_UNIT_1,
+        .atten    = ADC_ATTEN_DB_12,
+        .bitwidth = ADC_BITWIDTH_12,
+    };
+    if (adc_cali_create_scheme_line_fitting(&cfg, &cali) == ESP_OK) {
+        int lo = 0, hi = 0;
+        adc_cali_raw_to_voltage(cali, 0, &lo);
+        adc_cali_raw_to_voltage(cali, 4095, &hi);
+        adc_cali_delete_scheme_line_fitting(cali);
+        *mv0 = lo;
+        *mv_slope_q16 = ((int32_t)(hi - lo) << 16) / 4095;
+        ESP_LOGI(TAG, "ADC calibrated: %d … %d mV", lo, hi);
+        return;
+    }
+#endif
+    ESP_LOGW(TAG, "No ADC calibration, using nominal 0 … %d mV", PS_NOMINAL_FULL_MV);
+}
+
+static esp_err_t source_init(void)
+{
+    const uint8_t chans[PS_NCHAN] = {
+        [PS_LEFT]  = CONFIG_POWER_SENSE_LEFT_CHANNEL,
+        [PS_RIGHT] = CONFIG_POWER_SENSE_RIGHT_CHANNEL,
+        [PS_PACK]  = CONFIG_POWER_SENSE_PACK_CHANNEL,
+    };
+    adc_digi_pattern_config_t pattern[PS_NCHAN];
+
+    for (size_t i = 0; i < sizeof(g_idx_of_channel); i++) g_idx_of_channel[i] = 0xFF;
+    for (int i = 0; i < PS_NCHAN; i++) {
+        if (chans[i] >= sizeof(g_idx_of_channel) || g_idx_of_channel[chans[i]] != 0xFF) {
+            ESP_LOGE(TAG, "ADC1 channels must be distinct and < %d",
+                     (int)sizeof(g_idx_of_channel));
+            return ESP_ERR_INVALID_ARG;
+        }
+        g_idx_of_channel[chans[i]] = i;
+        pattern[i] = (adc_digi_pattern_config_t){
+            .atten     = ADC_ATTEN_DB_12,
+            .channel   = chans[i],
+            .unit      = ADC_UNIT_1,
+            .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+        };
+    }
+
+    int32_t mv0, slope;
+    calibrate(&mv0, &slope);
+    pipeline_init(mv0, slope);
+
+    adc_continuous_handle_cfg_t hcfg = {
+        .max_store_buf_size = PS_FRAME_BYTES * 4,
+        .conv_frame_size    = PS_FRAME_BYTES,
+    };
+    esp_err_t err = adc_continuous_new_handle(&hcfg, &g_adc);
+    if (err != ESP_OK) return err;
+
+    adc_continuous_config_t dcfg = {
+        .sample_freq_hz = CONFIG_POWER_SENSE_SAMPLE_HZ,
+        .conv_mode      = ADC_CONV_SINGLE_UNIT_1,
+        .format         = PS_ADC_FORMAT,
+        .pattern_num    = PS_NCHAN,
+        .adc_pattern    = pattern,
+    };
+    err = adc_continuous_config(g_adc, &dcfg);
+    if (err != ESP_OK) return err;
+
+    adc_continuous_evt_cbs_t cbs = {
+        .on_conv_done = on_conv_done,
+        .on_pool_ovf  = on_pool_ovf,
+    };
+    return adc_continuous_register_event_callbacks(g_adc, &cbs, NULL);
+}
+
+static void source_run(void)
+{
+    ESP_ERROR_CHECK(adc_continuous_start(g_adc));
+    int64_t next_tele_us = esp_timer_get_time();
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+
+        uint32_t got = 0;
+        while (adc_continuous_read(g_adc, g_frame, sizeof(g_frame), &got, 0) == ESP_OK) {
+            for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= got;
+                 i += SOC_ADC_DIGI_RESULT_BYTES) {
+                const adc_digi_output_data_t *d = (const adc_digi_output_data_t *)&g_frame[i];
+                uint32_t ch = PS_ADC_CHANNEL(d);
+                if (ch >= sizeof(g_idx_of_channel) || g_idx_of_channel[ch] == 0xFF) continue;
+                sense_sample_t smp = { .idx = g_idx_of_channel[ch], .raw = PS_ADC_DATA(d) };
+                feed(&smp);
+            }
+        }
+        publish_snapshot();
+
+        int64_t now = esp_timer_get_time();
+        if (now >= next_tele_us) {
+            next_tele_us = now + (int64_t)CONFIG_POWER_TELEMETRY_PERIOD_MS * 1000;
+            send_telemetry();
+        }
+    }
+}
+
+#endif /* CONFIG_POWER_SENSE_FAKE */
+
+/*---------------------------------------------------------------------
+ * Public API
+ *-------------------------------------------------------------------*/
+static void power_sense_task(void *arg)
+{
+    source_run();
+}
+
+void power_sense_init(void)
+{
+    esp_err_t err = source_init();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "ADC setup failed (%s); no current limiting", esp_err_to_name(err));
+        return;
+    }
+    g_task = xTaskCreateStatic(power_sense_task, "power_sense",
+                               POWER_SENSE_STACK_BYTES, NULL,
+                               POWER_SENSE_TASK_PRIO,
+                               s_sense_stack, &s_sense_tcb);
+    mem_report_register_task(g_task, POWER_SENSE_STACK_BYTES);
+}
+
+void power_sense_get(power_sense_t *out)
+{
+    if (!out) return;
+    portENTER_CRITICAL(&g_lock);
+    *out = g_snapshot;
+    portEXIT_CRITICAL(&g_lock);
+}
+
+#else  /* !CONFIG_POWER_SENSE */
+
+void power_sense_init(void)
+{
+    ESP_LOGI(TAG, "Power sensing disabled (CONFIG_POWER_SENSE)");
+}
+
+void power_sense_get(power_sense_t *out)
+{
+    if (out) *out = (power_sense_t){0};
+}
+
+#endif /* CONFIG_POWER_SENSE */
@@ -0,0 +1,54 @@
+/*=====================================================================
+ * power_sense.h — Motor current and pack voltage sensing
+ *
+ *  • ADC1 in continuous (DMA) mode samples the left/right current
+ *    sensors and the pack voltage divider round‑robin; frames are
+ *    drained by a task woken from the conversion‑done callback.
+ *  • sense_pipeline decimates and low‑passes each channel in fixed
+ *    point and converts to mA / mV (eFuse line‑fitting calibration is
+ *    folded into the channel gain at init).
+ *  • Overcurrent on a side caps that side's drive output
+ *    (motor_set_drive_cap) within a few decimated samples; the cap is
+ *    released once the current has stayed below 80 % of the trip level
+ *    for CONFIG_OVERCURRENT_HOLD_MS.
+ *  • Telemetry is published on MQTT_POWER_TOPIC:
+ *      {"left_ma":..,"right_ma":..,"pack_mv":..,"oc":[0|1,0|1],
+ *       "trips":n,"ovf":<DMA pool overflows>}
+ *
+ * With CONFIG_POWER_SENSE_FAKE the ADC is not touched: sense_fake
+ * generates samples from the commanded outputs and feeds the same
+ * pipeline, for benches without sensors.
+ *====================================================================*/
+
+#ifndef POWER_SENSE_H
+#define POWER_SENSE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MQTT_POWER_TOPIC        "wheelchair/telemetry/power"
+
+typedef struct {
+    int32_t  left_ma;           /* low‑passed, signed */
+    int32_t  right_ma;
+    int32_t  pack_mv;
+    bool     oc_left;           /* cutback active */
+    bool     oc_right;
+    uint32_t trips;             /* overcurrent trips since boot */
+} power_sense_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Start sampling (no‑op unless CONFIG_POWER_SENSE is set). */
+void power_sense_init(void);
+
+/** Latest readings; all zero when sensing is disabled. */
+void power_sense_get(power_sense_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POWER_SENSE_H */
@@ -0,0 +1,36 @@
+/*=====================================================================
+ * sense_fake.c — Round‑robin synthetic samples with LCG noise
+ *====================================================================*/
+
+#include "sense_fake.h"
+
+void sense_fake_init(sense_fake_t *f, uint8_t nchan, uint16_t noise, uint32_t seed)
+{
+    *f = (sense_fake_t){
+        .nchan = nchan > SENSE_FAKE_MAX_CHANNELS ? SENSE_FAKE_MAX_CHANNELS : nchan,
+        .noise = noise,
+        .rng   = seed ? seed : 1,
+    };
+}
+
+void sense_fake_set_level(sense_fake_t *f, uint8_t idx, int32_t raw)
+{
+    if (idx < f->nchan) f->level[idx] = raw;
+}
+
+void sense_fake_fill(sense_fake_t *f, sense_sample_t *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        f->rng = f->rng * 1664525u + 1013904223u;
+        int32_t v = f->level[f->next];
+        if (f->noise) {
+            v += (int32_t)((f->rng >> 16) % (2u * f->noise + 1)) - f->noise;
+        }
+        if (v < 0)    v = 0;
+        if (v > 4095) v = 4095;
+
+        out[i].idx = f->next;
+        out[i].raw = (uint16_t)v;
+        if (++f->next >= f->nchan) f->next = 0;
+    }
+}
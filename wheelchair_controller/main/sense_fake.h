@@ -0,0 +1,43 @@
+/*=====================================================================
+ * sense_fake.h — Synthetic ADC sample source
+ *
+ * Emits samples in the same round‑robin channel order as the ADC
+ * pattern, each at a settable raw level plus uniform noise, so the
+ * sensing pipeline can run without sensors (CONFIG_POWER_SENSE_FAKE)
+ * and on the host (tools/host_sim/sense_sim.c).  Pure C.
+ *====================================================================*/
+
+#ifndef SENSE_FAKE_H
+#define SENSE_FAKE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sense_pipeline.h"
+
+#define SENSE_FAKE_MAX_CHANNELS 4
+
+typedef struct {
+    uint8_t  nchan;
+    uint8_t  next;                      // channel of the next sample
+    uint16_t noise;                     // ± counts
+    uint32_t rng;
+    int32_t  level[SENSE_FAKE_MAX_CHANNELS];
+} sense_fake_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void sense_fake_init(sense_fake_t *f, uint8_t nchan, uint16_t noise, uint32_t seed);
+
+/** Set the mean raw level of channel @p idx (clamped to 12 bits on output). */
+void sense_fake_set_level(sense_fake_t *f, uint8_t idx, int32_t raw);
+
+/** Produce @p n samples in pattern order. */
+void sense_fake_fill(sense_fake_t *f, sense_sample_t *out, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSE_FAKE_H */
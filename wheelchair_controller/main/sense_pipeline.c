@@ -0,0 +1,83 @@
+/*=====================================================================
+ * sense_pipeline.c — Decimation, IIR low‑pass, overcurrent detection
+ *====================================================================*/
+
+#include "sense_pipeline.h"
+
+void sense_chan_init(sense_chan_t *c, uint16_t decim, uint8_t lpf_shift,
+                     int32_t scale_q16, int32_t offset)
+{
+    *c = (sense_chan_t){
+        .decim     = decim ? decim : 1,
+        .lpf_shift = lpf_shift,
+        .scale_q16 = scale_q16,
+        .offset    = offset,
+    };
+}
+
+static int32_t to_units(const sense_chan_t *c, int32_t raw_q8)
+{
+    return c->offset + (int32_t)(((int64_t)raw_q8 * c->scale_q16) >> 24);
+}
+
+bool sense_chan_push(sense_chan_t *c, uint16_t raw)
+{
+    c->acc += raw;
+    if (++c->count < c->decim) return false;
+
+    int32_t x_q8 = (int32_t)(((uint64_t)c->acc << 8) / c->count);
+    c->acc   = 0;
+    c->count = 0;
+
+    if (!c->primed) {
+        c->lpf_q8 = x_q8;               // start settled, not from zero
+        c->primed = true;
+    } else {
+        c->lpf_q8 += (x_q8 - c->lpf_q8) >> c->lpf_shift;
+    }
+    c->fast  = to_units(c, x_q8);
+    c->value = to_units(c, c->lpf_q8);
+    c->outputs++;
+    return true;
+}
+
+int32_t sense_chan_units_to_raw(const sense_chan_t *c, int32_t units)
+{
+    if (c->scale_q16 == 0) return 0;
+    return (int32_t)(((int64_t)(units - c->offset) << 16) / c->scale_q16);
+}
+
+void sense_oc_init(sense_oc_t *oc, int32_t trip, int32_t release,
+                   uint16_t trip_count, uint32_t hold_count)
+{
+    *oc = (sense_oc_t){
+        .trip       = trip,
+        .release    = release < trip ? release : trip,
+        .trip_count = trip_count ? trip_count : 1,
+        .hold_count = hold_count,
+    };
+}
+
+bool sense_oc_update(sense_oc_t *oc, int32_t value)
+{
+    int32_t mag = value < 0 ? -value : value;
+
+    if (!oc->tripped) {
+        oc->over = (mag >= oc->trip) ? oc->over + 1 : 0;
+        if (oc->over >= oc->trip_count) {
+            oc->tripped = true;
+            oc->clear   = 0;
+            oc->trips++;
+            return true;
+        }
+        return false;
+    }
+
+    oc->clear = (mag < oc->release) ? oc->clear + 1 : 0;
+    if (oc->clear >= oc->hold_count) {
+        oc->tripped = false;
+        oc->over    = 0;
+        return true;
+    }
+    return false;
+}
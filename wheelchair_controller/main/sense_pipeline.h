@@ -0,0 +1,81 @@
+/*=====================================================================
+ * sense_pipeline.h — Fixed‑point conditioning of ADC sample streams
+ *
+ *  • Per channel: decimate (average `decim` raw samples), then a
+ *    first‑order IIR low‑pass (y += (x − y) >> lpf_shift) in Q8.
+ *  • Linear conversion to engineering units (mA, mV) with a Q16 gain
+ *    and an offset, so calibration is folded into two integers.
+ *  • Overcurrent detector with a fast trip (N consecutive decimated
+ *    samples over the limit) and a slow, hysteretic release.
+ *
+ * Pure C, no ESP‑IDF dependencies, integer‑only: the same code runs on
+ * the host (tools/host_sim/sense_sim.c).  Not thread‑safe.
+ *====================================================================*/
+
+#ifndef SENSE_PIPELINE_H
+#define SENSE_PIPELINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** One raw sample, tagged with the pipeline channel it belongs to. */
+typedef struct {
+    uint8_t  idx;
+    uint16_t raw;
+} sense_sample_t;
+
+typedef struct {
+    /* configuration */
+    uint16_t decim;                     // raw samples per output
+    uint8_t  lpf_shift;                 // 0 = no low‑pass
+    int32_t  scale_q16;                 // units per raw count, Q16
+    int32_t  offset;                    // units at raw 0
+
+    /* state */
+    uint32_t acc;
+    uint16_t count;
+    bool     primed;
+    int32_t  lpf_q8;                    // filtered raw × 256
+    int32_t  fast;                      // newest decimated value (units)
+    int32_t  value;                     // low‑passed value (units)
+    uint32_t outputs;
+} sense_chan_t;
+
+typedef struct {
+    /* configuration */
+    int32_t  trip;                      // |value| ≥ trip counts as over
+    int32_t  release;                   // |value| < release counts as clear
+    uint16_t trip_count;                // consecutive overs to trip
+    uint32_t hold_count;                // consecutive clears to release
+
+    /* state */
+    uint16_t over;
+    uint32_t clear;
+    bool     tripped;
+    uint32_t trips;
+} sense_oc_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void sense_chan_init(sense_chan_t *c, uint16_t decim, uint8_t lpf_shift,
+                     int32_t scale_q16, int32_t offset);
+
+/** Add one raw sample. @return true when a new output was produced. */
+bool sense_chan_push(sense_chan_t *c, uint16_t raw);
+
+/** Raw count that reads as @p units (for fake sources and tests). */
+int32_t sense_chan_units_to_raw(const sense_chan_t *c, int32_t units);
+
+void sense_oc_init(sense_oc_t *oc, int32_t trip, int32_t release,
+                   uint16_t trip_count, uint32_t hold_count);
+
+/** Feed one decimated value. @return true when the trip state changed. */
+bool sense_oc_update(sense_oc_t *oc, int32_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSE_PIPELINE_H */
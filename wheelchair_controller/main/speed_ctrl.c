@@ -0,0 +1,116 @@
+/*=====================================================================
+ * speed_ctrl.c — Fixed‑point PI(D) + feedforward wheel speed loop
+ *====================================================================*/
+
+#include <string.h>
+#include "speed_ctrl.h"
+
+#define STANDSTILL_Q8   (1 << SPEED_CTRL_Q_SHIFT)           // < 1 % = stopped
+#define MOVING_Q8       (3 << SPEED_CTRL_Q_SHIFT)           // > 3 % = moving
+
+static inline int32_t clamp(int32_t v, int32_t lim)
+{
+    return v > lim ? lim : (v < -lim ? -lim : v);
+}
+
+static inline int32_t mul_q12(int32_t gain_q12, int32_t v)
+{
+    return (int32_t)(((int64_t)gain_q12 * v) >> SPEED_CTRL_GAIN_SHIFT);
+}
+
+void speed_ctrl_init(speed_ctrl_t *c, const speed_ctrl_cfg_t *cfg)
+{
+    memset(c, 0, sizeof(*c));
+    c->cfg = *cfg;
+}
+
+void speed_ctrl_reset(speed_ctrl_t *c)
+{
+    c->meas_q8 = 0;
+    c->prev_meas_q8 = 0;
+    c->i_acc = 0;
+    c->out_q8 = 0;
+    c->primed = false;
+    c->stuck_ticks = 0;
+}
+
+int32_t speed_ctrl_update(speed_ctrl_t *c, int32_t ref_q8, int32_t meas_q8,
+                          int32_t limit_q8)
+{
+    const speed_ctrl_cfg_t *k = &c->cfg;
+
+    /* -------- measurement filter --------------------------------- */
+    if (!c->primed) {
+        c->meas_q8 = c->prev_meas_q8 = meas_q8;
+        c->primed = true;
+    } else {
+        c->meas_q8 += (meas_q8 - c->meas_q8) >> k->meas_shift;
+    }
+    const int32_t meas = c->meas_q8;
+    const int32_t speed = meas < 0 ? -meas : meas;
+
+    /* -------- feedforward ----------------------------------------- */
+    int32_t ff = mul_q12(k->kff_q12, ref_q8);
+    if (ref_q8 > 0) ff += k->ks_q8;
+    if (ref_q8 < 0) ff -= k->ks_q8;
+
+    /* -------- encoder fault: open loop until the wheel moves ----- */
+    if (c->fault) {
+        if (speed > MOVING_Q8) {
+            c->fault = false;
+            c->stuck_ticks = 0;
+            c->i_acc = 0;
+        } else {
+            c->prev_meas_q8 = meas;
+            c->out_q8 = clamp(ff, limit_q8);
+            return c->out_q8;
+        }
+    }
+
+    /* -------- standstill: no holding torque, no creep ------------ */
+    if (ref_q8 == 0 && speed < STANDSTILL_Q8) {
+        c->i_acc = 0;
+        c->prev_meas_q8 = meas;
+        c->stuck_ticks = 0;
+        c->out_q8 = 0;
+        return 0;
+    }
+
+    /* -------- PI(D) trim with conditional integration ------------ */
+    const int32_t err = ref_q8 - meas;
+    const int32_t i_lim = k->trim_q8 << SPEED_CTRL_GAIN_SHIFT;
+    int32_t i_new = clamp(c->i_acc + (int32_t)((int64_t)k->ki_q12 * err), i_lim);
+
+    int32_t trim = mul_q12(k->kp_q12, err)
+                 - mul_q12(k->kd_q12, meas - c->prev_meas_q8)
+                 + (i_new >> SPEED_CTRL_GAIN_SHIFT);
+    c->prev_meas_q8 = meas;
+
+    int32_t u = ff + clamp(trim, k->trim_q8);
+    int over = 0;                                   // saturated direction
+    if (trim > k->trim_q8 || u > limit_q8)   over = 1;
+    if (trim < -k->trim_q8 || u < -limit_q8) over = -1;
+
+    if (over) {
+        c->saturated_ticks++;
+        /* keep the step only if it unwinds the saturated direction */
+        if ((over > 0) != (err > 0)) c->i_acc = i_new;
+        u = clamp(u, limit_q8);
+    } else {
+        c->i_acc = i_new;
+    }
+    c->out_q8 = u;
+
+    /* -------- fault detection ------------------------------------ */
+    if (k->fault_ticks && (u >= k->fault_duty_q8 || u <= -k->fault_duty_q8) &&
+        speed < STANDSTILL_Q8) {
+        if (++c->stuck_ticks >= k->fault_ticks) {
+            c->fault = true;
+            c->faults++;
+            c->i_acc = 0;
+        }
+    } else {
+        c->stuck_ticks = 0;
+    }
+    return u;
+}
@@ -0,0 +1,91 @@
+/*=====================================================================
+ * speed_ctrl.h — Per‑wheel closed‑loop speed controller
+ *
+ *  • u = feedforward + P + I − D(measurement), all in Q8 percent
+ *    (100 % = 100 << 8) so it slots into the motor tick unchanged.
+ *  • Feedforward: kff × reference plus a static‑friction offset with
+ *    the reference's sign — most of the output on a ramp comes from
+ *    here, the PI part only trims load, slope and battery sag.
+ *  • The feedback part (trim) is bounded to ±trim_q8 around the
+ *    feedforward, so a lost encoder cannot drive the wheel to full
+ *    output before the fault is detected.
+ *  • Anti‑windup by conditional integration: while the trim or the
+ *    output is clamped the integrator only moves back out of
+ *    saturation, and it is bounded to ±trim_q8.
+ *  • Standstill: reference 0 and the wheel (nearly) stopped → output 0
+ *    and the integrator is cleared, so a stopped chair never creeps.
+ *  • Encoder fault: output ≥ fault_duty with no measured motion for
+ *    fault_ticks → fall back to feedforward only (the old open‑loop
+ *    behaviour) until the wheel is seen moving again.
+ *
+ * Gains are Q12 (1.0 = 4096), integral and derivative gains are per
+ * tick.  Pure C, no ESP‑IDF dependencies, integer only; runs in the
+ * host simulation (tools/host_sim/speed_sim.c).  Not thread‑safe.
+ *====================================================================*/
+
+#ifndef SPEED_CTRL_H
+#define SPEED_CTRL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SPEED_CTRL_Q_SHIFT      8
+#define SPEED_CTRL_Q_FULL       (100 << SPEED_CTRL_Q_SHIFT)
+#define SPEED_CTRL_GAIN_SHIFT   12
+
+/* gain × 100 → Q12 (e.g. Kconfig values) */
+#define SPEED_CTRL_GAIN_X100(g) ((int32_t)(g) * (1 << SPEED_CTRL_GAIN_SHIFT) / 100)
+
+typedef struct {
+    int32_t  kp_q12;
+    int32_t  ki_q12;            // per tick (Ki [1/s] × period)
+    int32_t  kd_q12;            // per tick (Kd [s] / period)
+    int32_t  kff_q12;
+    int32_t  ks_q8;             // static friction offset
+    int32_t  trim_q8;           // feedback authority around the feedforward
+    uint8_t  meas_shift;        // measurement IIR: y += (x − y) >> shift
+    int32_t  fault_duty_q8;     // output that should move the wheel
+    uint16_t fault_ticks;       // 0 disables fault detection
+} speed_ctrl_cfg_t;
+
+typedef struct {
+    speed_ctrl_cfg_t cfg;
+
+    int32_t  meas_q8;           // filtered measured speed
+    int32_t  prev_meas_q8;
+    int32_t  i_acc;             // integrator, Q8 << GAIN_SHIFT
+    int32_t  out_q8;
+    bool     primed;
+    bool     fault;
+    uint16_t stuck_ticks;
+
+    /* counters */
+    uint32_t saturated_ticks;
+    uint32_t faults;
+} speed_ctrl_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void speed_ctrl_init(speed_ctrl_t *c, const speed_ctrl_cfg_t *cfg);
+
+/** Clear the integrator and filter state (e.g. after an emergency stop);
+ *  the fault flag and counters are kept. */
+void speed_ctrl_reset(speed_ctrl_t *c);
+
+/**
+ * One controller step.
+ * @param ref_q8    speed reference
+ * @param meas_q8   measured wheel speed this tick (unfiltered)
+ * @param limit_q8  output magnitude limit (channel limit / drive cap)
+ * @return output duty, within ±limit_q8
+ */
+int32_t speed_ctrl_update(speed_ctrl_t *c, int32_t ref_q8, int32_t meas_q8,
+                          int32_t limit_q8);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPEED_CTRL_H */
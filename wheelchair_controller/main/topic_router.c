@@ -0,0 +1,150 @@
+/*=====================================================================
+ * topic_router.c — Hashed exact routes + wildcard list
+ *====================================================================*/
+
+#include <string.h>
+#include "topic_router.h"
+
+_Static_assert((TOPIC_ROUTER_SLOTS & (TOPIC_ROUTER_SLOTS - 1)) == 0,
+               "TOPIC_ROUTER_SLOTS must be a power of 2");
+_Static_assert(TOPIC_ROUTER_MAX_ROUTES < 0xFF, "route index must fit below 0xFF");
+
+#define SLOT_EMPTY  0xFF
+
+static uint32_t fnv1a(const char *s, int len)
+{
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < len; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* '+' and '#' must fill a whole level; '#' only as the last one. */
+static bool filter_valid(const char *f, int len, bool *wildcard)
+{
+    *wildcard = false;
+    if (len <= 0) return false;
+    for (int i = 0; i < len; i++) {
+        if (f[i] != '+' && f[i] != '#') continue;
+        bool level_start = (i == 0 || f[i - 1] == '/');
+        bool level_end   = (i == len - 1 || f[i + 1] == '/');
+        if (!level_start || !level_end) return false;
+        if (f[i] == '#' && i != len - 1) return false;
+        *wildcard = true;
+    }
+    return true;
+}
+
+void topic_router_init(topic_router_t *r)
+{
+    memset(r, 0, sizeof(*r));
+    memset(r->slots, SLOT_EMPTY, sizeof(r->slots));
+}
+
+topic_router_status_t topic_router_add(topic_router_t *r, const char *filter,
+                                       uint8_t qos, topic_handler_t fn, void *ctx)
+{
+    int len = filter ? (int)strlen(filter) : 0;
+    bool wildcard;
+    if (!fn || !filter_valid(filter, len, &wildcard)) return TOPIC_ROUTER_BAD_FILTER;
+
+    for (int i = 0; i < r->count; i++) {
+        if (r->routes[i].len == len && memcmp(r->routes[i].filter, filter, len) == 0) {
+            return TOPIC_ROUTER_DUPLICATE;
+        }
+    }
+    if (r->count >= TOPIC_ROUTER_MAX_ROUTES) return TOPIC_ROUTER_FULL;
+
+    uint8_t idx = r->count;
+    r->routes[idx] = (topic_route_t){
+        .filter   = filter,
+        .len      = (uint16_t)len,
+        .qos      = qos,
+        .wildcard = wildcard,
+        .fn       = fn,
+        .ctx      = ctx,
+    };
+
+    if (wildcard) {
+        r->wild[r->nwild++] = idx;
+    } else {
+        /* at most half full, so a free slot always exists */
+        uint32_t s = fnv1a(filter, len) & (TOPIC_ROUTER_SLOTS - 1);
+        while (r->slots[s] != SLOT_EMPTY) s = (s + 1) & (TOPIC_ROUTER_SLOTS - 1);
+        r->slots[s] = idx;
+    }
+    r->count++;
+    return TOPIC_ROUTER_OK;
+}
+
+bool topic_router_set_limit(topic_router_t *r, const char *filter, uint16_t max_len)
+{
+    int len = filter ? (int)strlen(filter) : 0;
+    for (int i = 0; i < r->count; i++) {
+        if (r->routes[i].len == len && memcmp(r->routes[i].filter, filter, len) == 0) {
+            r->routes[i].max_len = max_len;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool topic_filter_match(const char *f, int flen, const char *t, int tlen)
+{
+    if (tlen > 0 && t[0] == '$' && flen > 0 && (f[0] == '+' || f[0] == '#')) {
+        return false;
+    }
+
+    int  fi = 0, ti = 0;
+    bool t_more = true;                 // topic still has a level at ti
+    for (;;) {
+        int fe = fi;
+        while (fe < flen && f[fe] != '/') fe++;
+        if (fe - fi == 1 && f[fi] == '#') return true;     // "a/#" also matches "a"
+        if (!t_more) return false;
+
+        int te = ti;
+        while (te < tlen && t[te] != '/') te++;
+        bool plus = (fe - fi == 1 && f[fi] == '+');
+        if (!plus && (fe - fi != te - ti || memcmp(f + fi, t + ti, fe - fi) != 0)) {
+            return false;
+        }
+
+        if (fe >= flen) return te >= tlen;
+        fi = fe + 1;
+        if (te >= tlen) t_more = false;
+        else            ti = te + 1;
+    }
+}
+
+topic_route_t *topic_router_match(topic_router_t *r, const char *topic,
+                                  int topic_len, int data_len)
+{
+    topic_route_t *hit = NULL;
+
+    if (topic && topic_len > 0) {
+        uint32_t s = fnv1a(topic, topic_len) & (TOPIC_ROUTER_SLOTS - 1);
+        while (r->slots[s] != SLOT_EMPTY) {
+            topic_route_t *rt = &r->routes[r->slots[s]];
+            if (rt->len == topic_len && memcmp(rt->filter, topic, topic_len) == 0) {
+                hit = rt;
+                break;
+            }
+            s = (s + 1) & (TOPIC_ROUTER_SLOTS - 1);
+        }
+        for (int i = 0; !hit && i < r->nwild; i++) {
+            topic_route_t *rt = &r->routes[r->wild[i]];
+            if (topic_filter_match(rt->filter, rt->len, topic, topic_len)) hit = rt;
+        }
+    }
+
+    if (!hit) {
+        r->unmatched++;
+        return NULL;
+    }
+    hit->messages++;
+    hit->bytes += (uint32_t)(data_len > 0 ? data_len : 0);
+    return hit;
+}
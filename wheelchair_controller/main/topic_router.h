@@ -0,0 +1,95 @@
+/*=====================================================================
+ * topic_router.h — MQTT topic → handler dispatch table
+ *
+ *  • Exact filters live in an open‑addressed hash table (FNV‑1a over
+ *    the topic bytes, linear probing): one hash + one memcmp per
+ *    message, independent of the number of routes.
+ *  • Filters with MQTT wildcards ('+' one level, '#' the rest) are
+ *    kept in a short list that is only scanned when no exact filter
+ *    matches; the first match in registration order wins.
+ *  • Every route counts the messages and payload bytes it handled; the
+ *    router counts topics nothing matched.
+ *  • A route may carry a payload size limit (max_len, 0 = none) that
+ *    the receive path enforces before buffering anything.
+ *
+ * Topics are compared by length and bytes — esp‑mqtt topics are not
+ * NUL‑terminated, so a prefix of a registered topic never matches.
+ * Filter strings are not copied and must outlive the router.
+ *
+ * Pure C, no ESP‑IDF dependencies.  Not thread‑safe: the caller
+ * serialises registration against lookups.
+ *====================================================================*/
+
+#ifndef TOPIC_ROUTER_H
+#define TOPIC_ROUTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef TOPIC_ROUTER_MAX_ROUTES
+#define TOPIC_ROUTER_MAX_ROUTES 16
+#endif
+#define TOPIC_ROUTER_SLOTS      (2 * TOPIC_ROUTER_MAX_ROUTES)   /* power of 2 */
+
+typedef void (*topic_handler_t)(const char *topic, int topic_len,
+                                const char *data, int data_len, void *ctx);
+
+typedef struct {
+    const char     *filter;
+    uint16_t        len;
+    uint8_t         qos;
+    bool            wildcard;
+    topic_handler_t fn;
+    void           *ctx;
+    uint16_t        max_len;            // largest accepted payload, 0 = no limit
+    uint32_t        messages;
+    uint32_t        bytes;
+} topic_route_t;
+
+typedef struct {
+    topic_route_t routes[TOPIC_ROUTER_MAX_ROUTES];
+    uint8_t       count;
+    uint8_t       slots[TOPIC_ROUTER_SLOTS];        // exact: route index, 0xFF = empty
+    uint8_t       wild[TOPIC_ROUTER_MAX_ROUTES];    // wildcard route indices
+    uint8_t       nwild;
+    uint32_t      unmatched;
+} topic_router_t;
+
+typedef enum {
+    TOPIC_ROUTER_OK = 0,
+    TOPIC_ROUTER_FULL,                  /* TOPIC_ROUTER_MAX_ROUTES reached */
+    TOPIC_ROUTER_DUPLICATE,             /* same filter registered twice */
+    TOPIC_ROUTER_BAD_FILTER,            /* empty, or misplaced '+' / '#' */
+} topic_router_status_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void topic_router_init(topic_router_t *r);
+
+topic_router_status_t topic_router_add(topic_router_t *r, const char *filter,
+                                       uint8_t qos, topic_handler_t fn, void *ctx);
+
+/**
+ * Limit the payload size accepted on the route registered as @p filter.
+ * @return false if no route has exactly this filter
+ */
+bool topic_router_set_limit(topic_router_t *r, const char *filter, uint16_t max_len);
+
+/**
+ * Find the route for @p topic and count the message against it.
+ * @return the route, or NULL (counted as unmatched)
+ */
+topic_route_t *topic_router_match(topic_router_t *r, const char *topic,
+                                  int topic_len, int data_len);
+
+/** MQTT filter matching ('+', '#', no wildcard match on '$' topics). */
+bool topic_filter_match(const char *filter, int filter_len,
+                        const char *topic, int topic_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TOPIC_ROUTER_H */
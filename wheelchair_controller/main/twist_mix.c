@@ -0,0 +1,49 @@
+/*=====================================================================
+ * twist_mix.c — Curvature‑preserving differential mixing
+ *====================================================================*/
+
+#include "twist_mix.h"
+
+void twist_mix_init(twist_mix_cfg_t *c, int turn_percent, int min_percent, int max_percent)
+{
+    if (max_percent > 100) max_percent = 100;
+    if (min_percent > max_percent) min_percent = max_percent;
+    c->turn_pct = turn_percent;
+    c->min_q8 = (int32_t)min_percent << TWIST_Q_SHIFT;
+    c->max_q8 = (int32_t)max_percent << TWIST_Q_SHIFT;
+}
+
+void twist_mix(const twist_mix_cfg_t *c, int32_t v_q8, int32_t w_q8, int32_t wheels_q8[2])
+{
+    int32_t turn = w_q8 * c->turn_pct / 100;
+    int32_t l = v_q8 - turn;
+    int32_t r = v_q8 + turn;
+    int32_t al = l < 0 ? -l : l;
+    int32_t ar = r < 0 ? -r : r;
+    int32_t m = al > ar ? al : ar;
+
+    if (m == 0) {
+        wheels_q8[0] = wheels_q8[1] = 0;
+        return;
+    }
+
+    /* faster wheel: saturate at full, then map onto min … max */
+    int32_t mc = m < TWIST_Q_FULL ? m : TWIST_Q_FULL;
+    int32_t top = c->min_q8 + (int32_t)((int64_t)(c->max_q8 - c->min_q8) * mc / TWIST_Q_FULL);
+
+    wheels_q8[0] = (int32_t)((int64_t)l * top / m);
+    wheels_q8[1] = (int32_t)((int64_t)r * top / m);
+}
+
+void twist_limit(int16_t val[2], int16_t lim)
+{
+    int32_t a = val[0] < 0 ? -val[0] : val[0];
+    int32_t b = val[1] < 0 ? -val[1] : val[1];
+    int32_t m = a > b ? a : b;
+
+    if (m <= lim) return;
+    for (int i = 0; i < 2; i++) {
+        int32_t x = (int32_t)val[i] * lim;
+        val[i] = (int16_t)(x >= 0 ? (x + m / 2) / m : -((-x + m / 2) / m));
+    }
+}
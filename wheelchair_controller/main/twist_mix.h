@@ -0,0 +1,52 @@
+/*=====================================================================
+ * twist_mix.h — Linear/angular (v, ω) commands → wheel speeds
+ *
+ *   left  = v − ω · turn        right = v + ω · turn
+ *
+ *  • v, ω and the wheel speeds are Q8 percent (100 % = 100 << 8);
+ *    positive ω speeds up the right wheel.
+ *  • Saturation keeps the ratio of the two wheels — and so the turn
+ *    radius — instead of clipping each side: when the faster wheel
+ *    would exceed 100 %, both are scaled down together.
+ *  • min/max: the faster wheel's magnitude is mapped from 0 … 100 %
+ *    to min … max (any non‑zero command starts at min, e.g. to clear
+ *    a motor deadband), the slower wheel follows in proportion.
+ *  • twist_limit() applies the same ratio‑preserving clamp to a
+ *    left/right pair; the control tick uses it for the speed limit.
+ *
+ * Pure C, integer only.
+ *====================================================================*/
+
+#ifndef TWIST_MIX_H
+#define TWIST_MIX_H
+
+#include <stdint.h>
+
+#define TWIST_Q_SHIFT   8
+#define TWIST_Q_FULL    (100 << TWIST_Q_SHIFT)
+
+typedef struct {
+    int32_t turn_pct;           // wheel difference at ω = 100 %, per side
+    int32_t min_q8;
+    int32_t max_q8;
+} twist_mix_cfg_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void twist_mix_init(twist_mix_cfg_t *c, int turn_percent, int min_percent, int max_percent);
+
+/** Mix (v, ω) into wheels[0] = left, wheels[1] = right (all Q8 %). */
+void twist_mix(const twist_mix_cfg_t *c, int32_t v_q8, int32_t w_q8, int32_t wheels_q8[2]);
+
+/** Scale a left/right pair (whole %) so neither exceeds ±@p lim,
+ *  keeping their ratio; rounds to nearest.  Runs in the control tick
+ *  (placed in IRAM by linker.lf). */
+void twist_limit(int16_t val[2], int16_t lim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TWIST_MIX_H */
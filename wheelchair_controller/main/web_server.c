@@ -1,5 +1,6 @@
 #include <string.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include "esp_log.h"
 #include "esp_http_server.h"
 #include "web_server.h"      // Include the header for this module
@@ -15,6 +16,7 @@ static esp_err_t control_get_handler(httpd_req_t *req)
     char*  buf;
     size_t buf_len;
     char speed_str[10];
+    char turn_str[10] = "";
     char stop_str[5];
 
     // Get query string
@@ -32,11 +34,17 @@ static esp_err_t control_get_handler(httpd_req_t *req)
             // Check for emergency stop parameter
             if (httpd_query_key_value(buf, "stop", stop_str, sizeof(stop_str)) == ESP_OK) {
                 ESP_LOGI(TAG, "Found URL query parameter => stop=%s", stop_str);
+                // Latched for every source, like the MQTT STOP; stop=0 releases it
                 if (atoi(stop_str) == 1) {
-                     motor_emergency_stop();
+                     motor_set_lockout(MOTOR_LOCK_ESTOP, true);
                      httpd_resp_send(req, "Emergency Stop Activated", HTTPD_RESP_USE_STRLEN);
                      free(buf);
                      return ESP_OK;
+                } else if (strcmp(stop_str, "0") == 0) {
+                     motor_set_lockout(MOTOR_LOCK_ESTOP, false);
+                     httpd_resp_send(req, "Emergency Stop Released", HTTPD_RESP_USE_STRLEN);
+                     free(buf);
+                     return ESP_OK;
                 }
             }
 
@@ -47,10 +55,30 @@ static esp_err_t control_get_handler(httpd_req_t *req)
                 char *endptr;
                 int speed = (int)strtol(speed_str, &endptr, 10);
                 if (*endptr == '\0') { // Check if conversion was successful
-                    motor_set_state(speed);
-                    // Respond to the client
                     char resp_str[50];
-                    snprintf(resp_str, sizeof(resp_str), "Motor speed set to %d%%", speed);
+                    // Optional turn rate makes it a twist command, mixed on the controller;
+                    // a turn= that is empty, too long or not a number is refused, never
+                    // driven straight ahead instead
+                    esp_err_t turn_err = httpd_query_key_value(buf, "turn", turn_str, sizeof(turn_str));
+                    bool twist = turn_err != ESP_ERR_NOT_FOUND;
+                    int turn = 0;
+                    if (twist) {
+                        turn = turn_err == ESP_OK ? (int)strtol(turn_str, &endptr, 10) : 0;
+                        if (turn_err != ESP_OK || endptr == turn_str || *endptr != '\0') {
+                            ESP_LOGW(TAG, "Invalid turn value: %s", turn_str);
+                            free(buf);
+                            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid turn value");
+                            return ESP_FAIL;
+                        }
+                    }
+                    if (twist) {
+                        motor_submit_twist(CMD_SRC_HTTP, speed, turn);
+                        snprintf(resp_str, sizeof(resp_str), "Motor twist set to %d%% / %d%%", speed, turn);
+                    } else {
+                        // Both wheels; the HTTP source only drives while it owns the chair
+                        motor_submit_speeds(CMD_SRC_HTTP, speed, speed);
+                        snprintf(resp_str, sizeof(resp_str), "Motor speed set to %d%%", speed);
+                    }
                     httpd_resp_send(req, resp_str, HTTPD_RESP_USE_STRLEN);
                     free(buf);
                     return ESP_OK;
@@ -0,0 +1,143 @@
+/*=====================================================================
+ * wheel_encoder.c — PCNT quadrature decoding for the drive wheels
+ *====================================================================*/
+
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "wheel_encoder.h"
+
+static const char *TAG = "WHEEL_ENC";
+
+#if CONFIG_MOTOR_ENCODERS
+
+#include "driver/pulse_cnt.h"
+
+/* An encoder on one of the power sensing ADC1 inputs would corrupt both. */
+#if CONFIG_POWER_SENSE && !CONFIG_POWER_SENSE_FAKE
+#include "soc/adc_channel.h"
+#define ENC_ADC1_GPIO_(ch)      ADC1_CHANNEL_##ch##_GPIO_NUM
+#define ENC_ADC1_GPIO(ch)       ENC_ADC1_GPIO_(ch)
+#define ENC_USES_GPIO(gpio) \
+    ((gpio) == CONFIG_MOTOR_ENCODER_LEFT_A_GPIO  || (gpio) == CONFIG_MOTOR_ENCODER_LEFT_B_GPIO || \
+     (gpio) == CONFIG_MOTOR_ENCODER_RIGHT_A_GPIO || (gpio) == CONFIG_MOTOR_ENCODER_RIGHT_B_GPIO)
+#if ENC_USES_GPIO(ENC_ADC1_GPIO(CONFIG_POWER_SENSE_LEFT_CHANNEL))  || \
+    ENC_USES_GPIO(ENC_ADC1_GPIO(CONFIG_POWER_SENSE_RIGHT_CHANNEL)) || \
+    ENC_USES_GPIO(ENC_ADC1_GPIO(CONFIG_POWER_SENSE_PACK_CHANNEL))
+#error "A wheel encoder GPIO is also a power sensing ADC1 input; move one of them in menuconfig"
+#endif
+#endif
+
+#ifndef WHEEL_ENCODER_LIMIT
+#define WHEEL_ENCODER_LIMIT     30000   /* hardware counter wraps here */
+#endif
+#ifndef WHEEL_ENCODER_GLITCH_NS
+#define WHEEL_ENCODER_GLITCH_NS 1000
+#endif
+
+#if CONFIG_MOTOR_CONTROL_IN_IRAM
+#define ENC_IRAM_ATTR   IRAM_ATTR
+#else
+#define ENC_IRAM_ATTR
+#endif
+
+static pcnt_unit_handle_t s_unit[2];
+static bool s_invert[2];
+
+/* ×4 decoding: each phase counts both edges, direction from the other
+ * phase's level (as in the IDF rotary encoder example). */
+static esp_err_t encoder_unit(int pin_a, int pin_b, pcnt_unit_handle_t *out)
+{
+    pcnt_unit_config_t ucfg = {
+        .high_limit = WHEEL_ENCODER_LIMIT,
+        .low_limit  = -WHEEL_ENCODER_LIMIT,
+        .flags.accum_count = 1,
+    };
+    pcnt_unit_handle_t unit;
+    esp_err_t err = pcnt_new_unit(&ucfg, &unit);
+    if (err != ESP_OK) return err;
+
+    pcnt_glitch_filter_config_t filter = { .max_glitch_ns = WHEEL_ENCODER_GLITCH_NS };
+    err = pcnt_unit_set_glitch_filter(unit, &filter);
+    if (err != ESP_OK) return err;
+
+    pcnt_chan_config_t acfg = { .edge_gpio_num = pin_a, .level_gpio_num = pin_b };
+    pcnt_chan_config_t bcfg = { .edge_gpio_num = pin_b, .level_gpio_num = pin_a };
+    pcnt_channel_handle_t a, b;
+    err = pcnt_new_channel(unit, &acfg, &a);
+    if (err != ESP_OK) return err;
+    err = pcnt_new_channel(unit, &bcfg, &b);
+    if (err != ESP_OK) return err;
+
+    pcnt_channel_set_edge_action(a, PCNT_CHANNEL_EDGE_ACTION_DECREASE,
+                                    PCNT_CHANNEL_EDGE_ACTION_INCREASE);
+    pcnt_channel_set_level_action(a, PCNT_CHANNEL_LEVEL_ACTION_KEEP,
+                                     PCNT_CHANNEL_LEVEL_ACTION_INVERSE);
+    pcnt_channel_set_edge_action(b, PCNT_CHANNEL_EDGE_ACTION_INCREASE,
+                                    PCNT_CHANNEL_EDGE_ACTION_DECREASE);
+    pcnt_channel_set_level_action(b, PCNT_CHANNEL_LEVEL_ACTION_KEEP,
+                                     PCNT_CHANNEL_LEVEL_ACTION_INVERSE);
+
+    /* accum_count needs watch points at both limits */
+    pcnt_unit_add_watch_point(unit, WHEEL_ENCODER_LIMIT);
+    pcnt_unit_add_watch_point(unit, -WHEEL_ENCODER_LIMIT);
+
+    err = pcnt_unit_enable(unit);
+    if (err != ESP_OK) return err;
+    pcnt_unit_clear_count(unit);
+    err = pcnt_unit_start(unit);
+    if (err != ESP_OK) return err;
+
+    *out = unit;
+    return ESP_OK;
+}
+
+esp_err_t wheel_encoder_init(void)
+{
+    esp_err_t err = encoder_unit(CONFIG_MOTOR_ENCODER_LEFT_A_GPIO,
+                                 CONFIG_MOTOR_ENCODER_LEFT_B_GPIO, &s_unit[WHEEL_ENCODER_LEFT]);
+    if (err == ESP_OK) {
+        err = encoder_unit(CONFIG_MOTOR_ENCODER_RIGHT_A_GPIO,
+                           CONFIG_MOTOR_ENCODER_RIGHT_B_GPIO, &s_unit[WHEEL_ENCODER_RIGHT]);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "PCNT setup failed: %s", esp_err_to_name(err));
+        return err;
+    }
+#if CONFIG_MOTOR_ENCODER_LEFT_INVERT
+    s_invert[WHEEL_ENCODER_LEFT] = true;
+#endif
+#if CONFIG_MOTOR_ENCODER_RIGHT_INVERT
+    s_invert[WHEEL_ENCODER_RIGHT] = true;
+#endif
+    ESP_LOGI(TAG, "Encoders L=%d/%d R=%d/%d, %d counts/s at full speed",
+             CONFIG_MOTOR_ENCODER_LEFT_A_GPIO, CONFIG_MOTOR_ENCODER_LEFT_B_GPIO,
+             CONFIG_MOTOR_ENCODER_RIGHT_A_GPIO, CONFIG_MOTOR_ENCODER_RIGHT_B_GPIO,
+             CONFIG_MOTOR_ENCODER_FULL_SPEED_CPS);
+    return ESP_OK;
+}
+
+void ENC_IRAM_ATTR wheel_encoder_get_counts(int32_t counts[2])
+{
+    for (int s = 0; s < 2; s++) {
+        int v = 0;
+        if (s_unit[s]) pcnt_unit_get_count(s_unit[s], &v);
+        counts[s] = s_invert[s] ? -v : v;
+    }
+}
+
+#else  /* !CONFIG_MOTOR_ENCODERS */
+
+esp_err_t wheel_encoder_init(void)
+{
+    ESP_LOGI(TAG, "Wheel encoders disabled (CONFIG_MOTOR_ENCODERS)");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void wheel_encoder_get_counts(int32_t counts[2])
+{
+    counts[0] = counts[1] = 0;
+}
+
+#endif /* CONFIG_MOTOR_ENCODERS */
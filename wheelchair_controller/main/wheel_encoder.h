@@ -0,0 +1,35 @@
+/*=====================================================================
+ * wheel_encoder.h — Quadrature wheel encoders on the PCNT peripheral
+ *
+ *  • One PCNT unit per side, both edges of both phases counted (×4),
+ *    with the hardware glitch filter and overflow accumulation, so the
+ *    count is a free‑running 32‑bit position.
+ *  • Forward is positive after CONFIG_MOTOR_ENCODER_*_INVERT.
+ *  • Read from the motor control tick; with CONFIG_MOTOR_CONTROL_IN_IRAM
+ *    the PCNT read path is placed in IRAM (PCNT_CTRL_FUNC_IN_IRAM).
+ *====================================================================*/
+
+#ifndef WHEEL_ENCODER_H
+#define WHEEL_ENCODER_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#define WHEEL_ENCODER_LEFT      0
+#define WHEEL_ENCODER_RIGHT     1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Configure and start both encoder units (needs CONFIG_MOTOR_ENCODERS). */
+esp_err_t wheel_encoder_init(void);
+
+/** Cumulative counts per side since init. ISR‑safe. */
+void wheel_encoder_get_counts(int32_t counts[2]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WHEEL_ENCODER_H */
@@ -13,11 +13,13 @@
 #include "wifi_manager.h" // Include the header for this module
 // #include "web_server.h"   // Old HTTP server
 #include "mqtt_client_app.h" // Include MQTT application functions
+#include "deferred_log.h"
 
 static const char *TAG = "WIFI_MANAGER";
 
 // Event group to signal when we are connected
 static EventGroupHandle_t s_wifi_event_group;
+static StaticEventGroup_t s_wifi_event_group_buf;
 #define WIFI_CONNECTED_BIT BIT0
 #define WIFI_FAIL_BIT      BIT1
 
@@ -38,11 +40,11 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
         if (s_retry_num < WIFI_MAXIMUM_RETRY) {
             esp_wifi_connect();
             s_retry_num++;
-            ESP_LOGI(TAG, "retry to connect to the AP");
+            DLOGI(TAG, "retry to connect to the AP (%d/%d)", s_retry_num, WIFI_MAXIMUM_RETRY);
         } else {
             xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
         }
-        ESP_LOGW(TAG,"connect to the AP fail");
+        DLOGW(TAG, "connect to the AP fail");
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "got ip:" IPSTR, IP2STR(&event->ip_info.ip));
@@ -59,7 +61,7 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
 // --- WiFi Initialization ---
 void wifi_init_sta(const char *ssid, const char *password)
 {
-    s_wifi_event_group = xEventGroupCreate();
+    s_wifi_event_group = xEventGroupCreateStatic(&s_wifi_event_group_buf);
 
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
@@ -0,0 +1,183 @@
+/*=====================================================================
+ * wired_joystick.c — UART event task feeding the local command source
+ *====================================================================*/
+
+#include <string.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "wired_joystick.h"
+
+static const char *TAG = "WIRED_JOY";
+
+#if CONFIG_WIRED_JOYSTICK
+
+#include "freertos/queue.h"
+#include "driver/uart.h"
+#include "motor_control.h"
+#include "mem_report.h"
+#include "joy_frame.h"
+
+/* The UART must not share a pin with a configured motor or encoder
+ * (symbols of disabled channels are not defined). */
+#define JOY_ON(gpio)    (CONFIG_WIRED_JOY_RX_GPIO == (gpio) || CONFIG_WIRED_JOY_TX_GPIO == (gpio))
+#if (defined(CONFIG_MOTOR1_PWM_GPIO)     && JOY_ON(CONFIG_MOTOR1_PWM_GPIO))     || \
+    (defined(CONFIG_MOTOR1_DIR_GPIO)     && JOY_ON(CONFIG_MOTOR1_DIR_GPIO))     || \
+    (defined(CONFIG_MOTOR2_PWM_GPIO)     && JOY_ON(CONFIG_MOTOR2_PWM_GPIO))     || \
+    (defined(CONFIG_MOTOR2_DIR_GPIO)     && JOY_ON(CONFIG_MOTOR2_DIR_GPIO))     || \
+    (defined(CONFIG_MOTOR3_PWM_GPIO)     && JOY_ON(CONFIG_MOTOR3_PWM_GPIO))     || \
+    (defined(CONFIG_MOTOR3_DIR_GPIO)     && JOY_ON(CONFIG_MOTOR3_DIR_GPIO))     || \
+    (defined(CONFIG_MOTOR4_PWM_GPIO)     && JOY_ON(CONFIG_MOTOR4_PWM_GPIO))     || \
+    (defined(CONFIG_MOTOR4_DIR_GPIO)     && JOY_ON(CONFIG_MOTOR4_DIR_GPIO))     || \
+    (defined(CONFIG_MOTOR_AUX1_PWM_GPIO) && JOY_ON(CONFIG_MOTOR_AUX1_PWM_GPIO)) || \
+    (defined(CONFIG_MOTOR_AUX1_DIR_GPIO) && JOY_ON(CONFIG_MOTOR_AUX1_DIR_GPIO)) || \
+    (defined(CONFIG_MOTOR_AUX2_PWM_GPIO) && JOY_ON(CONFIG_MOTOR_AUX2_PWM_GPIO)) || \
+    (defined(CONFIG_MOTOR_AUX2_DIR_GPIO) && JOY_ON(CONFIG_MOTOR_AUX2_DIR_GPIO))
+#error "Wired joystick RX/TX GPIO is also a motor channel pin; move one of them in menuconfig"
+#endif
+#if CONFIG_MOTOR_ENCODERS && \
+    (JOY_ON(CONFIG_MOTOR_ENCODER_LEFT_A_GPIO)  || JOY_ON(CONFIG_MOTOR_ENCODER_LEFT_B_GPIO) || \
+     JOY_ON(CONFIG_MOTOR_ENCODER_RIGHT_A_GPIO) || JOY_ON(CONFIG_MOTOR_ENCODER_RIGHT_B_GPIO))
+#error "Wired joystick RX/TX GPIO is also a wheel encoder pin; move one of them in menuconfig"
+#endif
+
+#define JOY_STACK_BYTES     3072
+#define JOY_RX_BUF_BYTES    256         // driver ring buffer (min > FIFO)
+#define JOY_EVENT_DEPTH     8
+#define JOY_READ_CHUNK      64
+#define JOY_TASK_PRIO       (tskIDLE_PRIORITY + 6)  /* with power_sense, above MQTT */
+
+static QueueHandle_t  s_events;
+static joy_parser_t   s_parser;
+/* Counters are 32‑bit words written only by the RX task; readers take
+ * them without a lock (each field is consistent, the set is not). */
+static uint32_t       s_overflows;
+static uint32_t       s_bytes;
+static bool           s_seen = false;
+
+static StackType_t  s_joy_stack[JOY_STACK_BYTES];
+static StaticTask_t s_joy_tcb;
+
+static void on_frame(const joy_frame_t *f, void *ctx)
+{
+    int a, b;
+    if (joy_frame_drive(f, &a, &b)) {
+        motor_submit_speeds(CMD_SRC_LOCAL, a, b);
+    } else if (joy_frame_twist(f, &a, &b)) {
+        motor_submit_twist(CMD_SRC_LOCAL, a, b);
+    } else {
+        return;
+    }
+    if (!s_seen) {
+        s_seen = true;
+        ESP_LOGI(TAG, "Joystick online (seq %u)", f->seq);
+    }
+}
+
+static void rx_drain(size_t len)
+{
+    uint8_t buf[JOY_READ_CHUNK];
+
+    while (len) {
+        int n = uart_read_bytes(CONFIG_WIRED_JOY_UART_PORT, buf,
+                                len < sizeof(buf) ? len : sizeof(buf), 0);
+        if (n <= 0) break;
+        s_bytes += (uint32_t)n;
+        joy_parser_feed(&s_parser, buf, (size_t)n, on_frame, NULL);
+        len -= (size_t)n;
+    }
+}
+
+static void wired_joystick_task(void *arg)
+{
+    uart_event_t ev;
+
+    for (;;) {
+        if (xQueueReceive(s_events, &ev, portMAX_DELAY) != pdTRUE) continue;
+
+        switch (ev.type) {
+        case UART_DATA:
+            rx_drain(ev.size);
+            break;
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            ESP_LOGW(TAG, "RX overflow (%d), flushing", ev.type);
+            uart_flush_input(CONFIG_WIRED_JOY_UART_PORT);
+            xQueueReset(s_events);
+            s_overflows++;
+            joy_parser_reset(&s_parser);
+            break;
+        case UART_FRAME_ERR:
+        case UART_PARITY_ERR:
+            /* the CRC rejects the damaged frame */
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void wired_joystick_init(void)
+{
+    const uart_config_t cfg = {
+        .baud_rate  = CONFIG_WIRED_JOY_BAUD,
+        .data_bits  = UART_DATA_8_BITS,
+        .parity     = UART_PARITY_DISABLE,
+        .stop_bits  = UART_STOP_BITS_1,
+        .flow_ctrl  = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+    const uart_port_t port = CONFIG_WIRED_JOY_UART_PORT;
+
+    joy_parser_init(&s_parser);
+
+    esp_err_t err = uart_driver_install(port, JOY_RX_BUF_BYTES, 0,
+                                        JOY_EVENT_DEPTH, &s_events, 0);
+    if (err == ESP_OK) err = uart_param_config(port, &cfg);
+    if (err == ESP_OK) err = uart_set_pin(port, CONFIG_WIRED_JOY_TX_GPIO,
+                                          CONFIG_WIRED_JOY_RX_GPIO,
+                                          UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    if (err == ESP_OK) err = uart_set_rx_timeout(port, CONFIG_WIRED_JOY_RX_TIMEOUT_SYMBOLS);
+    if (err == ESP_OK) err = uart_set_rx_full_threshold(port, JOY_FRAME_MAX);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "UART%d setup failed: %s", (int)port, esp_err_to_name(err));
+        return;
+    }
+
+    TaskHandle_t h = xTaskCreateStatic(wired_joystick_task, "wired_joy",
+                                       JOY_STACK_BYTES, NULL,
+                                       JOY_TASK_PRIO,
+                                       s_joy_stack, &s_joy_tcb);
+    mem_report_register_task(h, JOY_STACK_BYTES);
+    ESP_LOGI(TAG, "UART%d rx=%d tx=%d @ %d baud", (int)port,
+             CONFIG_WIRED_JOY_RX_GPIO, CONFIG_WIRED_JOY_TX_GPIO, CONFIG_WIRED_JOY_BAUD);
+}
+
+void wired_joystick_get_stats(wired_joystick_stats_t *out)
+{
+    if (!out) return;
+    *out = (wired_joystick_stats_t){
+        .frames     = s_parser.frames,
+        .crc_errors = s_parser.crc_errors,
+        .resyncs    = s_parser.resyncs,
+        .lost       = s_parser.lost,
+        .duplicates = s_parser.duplicates,
+        .overflows  = s_overflows,
+        .bytes      = s_bytes,
+    };
+}
+
+#else  /* !CONFIG_WIRED_JOYSTICK */
+
+void wired_joystick_init(void)
+{
+    ESP_LOGI(TAG, "Wired joystick disabled (CONFIG_WIRED_JOYSTICK)");
+}
+
+void wired_joystick_get_stats(wired_joystick_stats_t *out)
+{
+    if (out) *out = (wired_joystick_stats_t){0};
+}
+
+#endif /* CONFIG_WIRED_JOYSTICK */
@@ -0,0 +1,47 @@
+/*=====================================================================
+ * wired_joystick.h — Joystick on a UART (or USB‑UART bridge)
+ *
+ *  • Frames per joy_frame.h; each valid drive frame is submitted as
+ *    CMD_SRC_LOCAL, the same path MQTT commands take, so the arbiter
+ *    lets the wired stick take over from remote sources.
+ *  • Event driven: the task blocks on the UART driver's event queue;
+ *    the RX timeout interrupt (CONFIG_WIRED_JOY_RX_TIMEOUT_SYMBOLS
+ *    idle symbols) delivers a frame as soon as it ends instead of
+ *    waiting for the FIFO threshold.  No polling.
+ *  • A FIFO overflow or full ring buffer flushes the input and the
+ *    parser; the sender's next frame resynchronises.
+ *  • Silence is handled by the arbiter: the local source goes stale
+ *    after CONFIG_MOTOR_SRC_LOCAL_TIMEOUT_MS, so the sender should
+ *    repeat its state at least every ~50 ms.
+ *====================================================================*/
+
+#ifndef WIRED_JOYSTICK_H
+#define WIRED_JOYSTICK_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t frames;        /* accepted frames */
+    uint32_t crc_errors;
+    uint32_t resyncs;       /* bytes skipped hunting for sync */
+    uint32_t lost;          /* sequence gaps */
+    uint32_t duplicates;
+    uint32_t overflows;     /* FIFO / ring buffer overflows */
+    uint32_t bytes;
+} wired_joystick_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Install the UART driver and start the RX task (CONFIG_WIRED_JOYSTICK). */
+void wired_joystick_init(void);
+
+/** Link counters since boot (zeros when disabled). */
+void wired_joystick_get_stats(wired_joystick_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WIRED_JOYSTICK_H */
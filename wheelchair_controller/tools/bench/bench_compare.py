@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""Compare a benchmark run against a stored baseline.
+
+The run is either a results file written by fw_bench or a target boot
+log containing the "BENCH: " line (CONFIG_BENCH_SUITE). Cases are
+compared on cycles/op when both sides have them (target), else ns/op.
+A case regresses when it is slower than the threshold percentage AND
+by more than the noise floor in absolute terms, so a few-ns case does
+not fail on clock granularity alone.
+
+Exit status: 0 = within threshold, 1 = regression, 2 = usage / missing
+baseline.
+
+Usage:
+    bench_compare.py RESULTS --baseline baselines/host.json [--threshold 10]
+                     [--noise-floor N]
+    bench_compare.py RESULTS --baseline baselines/host.json --update
+"""
+import argparse
+import json
+import os
+import sys
+
+MARKER = 'BENCH: '
+
+# Smallest absolute slowdown per op that counts as a regression
+NOISE_FLOOR = {'ns': 2.0, 'cycles': 10.0}
+
+
+def load_run(path: str) -> dict:
+    with open(path, encoding='utf-8', errors='replace') as f:
+        text = f.read()
+    idx = text.rfind(MARKER)
+    if idx >= 0:
+        text = text[idx + len(MARKER):].splitlines()[0]
+    return json.loads(text)
+
+
+def metric(entry: dict) -> tuple:
+    if entry.get('cycles', 0) > 0:
+        return 'cycles', entry['cycles']
+    return 'ns', entry['ns']
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('results')
+    parser.add_argument('--baseline', required=True)
+    parser.add_argument('--threshold', type=float, default=10.0,
+                        help='allowed slowdown in percent (per-case "threshold_pct" in the baseline wins)')
+    parser.add_argument('--noise-floor', type=float,
+                        help='ignore slowdowns below this many ns (or cycles) per op '
+                             f'(default {NOISE_FLOOR["ns"]:g} ns / {NOISE_FLOOR["cycles"]:g} cycles)')
+    parser.add_argument('--update', action='store_true', help='store this run as the baseline')
+    args = parser.parse_args()
+
+    run = load_run(args.results)
+
+    if args.update:
+        old = {}
+        if os.path.exists(args.baseline):
+            with open(args.baseline, encoding='utf-8') as f:
+                old = {e['name']: e for e in json.load(f).get('results', [])}
+        for entry in run['results']:
+            if 'threshold_pct' in old.get(entry['name'], {}):
+                entry['threshold_pct'] = old[entry['name']]['threshold_pct']
+        os.makedirs(os.path.dirname(args.baseline) or '.', exist_ok=True)
+        with open(args.baseline, 'w', encoding='utf-8') as f:
+            json.dump(run, f, indent=2)
+            f.write('\n')
+        print(f'baseline written: {args.baseline}')
+        return 0
+
+    if not os.path.exists(args.baseline):
+        print(f'no baseline at {args.baseline}; record one with --update', file=sys.stderr)
+        return 2
+    with open(args.baseline, encoding='utf-8') as f:
+        base_doc = json.load(f)
+    base = {e['name']: e for e in base_doc.get('results', [])}
+    if base_doc.get('platform') != run.get('platform'):
+        print('warning: baseline was recorded on a different platform', file=sys.stderr)
+
+    failed = False
+    print(f"{'case':<20} {'unit':>6} {'baseline':>10} {'now':>10} {'delta':>8}")
+    for entry in run['results']:
+        name = entry['name']
+        if name not in base:
+            print(f'{name:<20} {"":>6} {"(new)":>10}')
+            continue
+        unit, now = metric(entry)
+        ref = base[name].get(unit, 0)
+        if ref <= 0:
+            print(f'{name:<20} {unit:>6} {"n/a":>10} {now:10.1f}')
+            continue
+        delta = (now - ref) / ref * 100.0
+        limit = base[name].get('threshold_pct', args.threshold)
+        floor = args.noise_floor if args.noise_floor is not None else NOISE_FLOOR[unit]
+        regressed = delta > limit and now - ref > floor
+        verdict = 'REGRESSED' if regressed else ''
+        failed |= regressed
+        print(f'{name:<20} {unit:>6} {ref:10.1f} {now:10.1f} {delta:+7.1f}% {verdict}')
+
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
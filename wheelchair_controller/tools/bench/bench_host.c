@@ -0,0 +1,25 @@
+/*=====================================================================
+ * bench_host.c — Host entry point for the hot‑path benchmark
+ *
+ * Builds main/bench.c against the real firmware sources plus the IDF
+ * shims in ./shim.  Usage: ./fw_bench [results.json]
+ *====================================================================*/
+
+#include <stdio.h>
+#include "motor_control.h"
+#include "bench.h"
+
+int main(int argc, char **argv)
+{
+    FILE *out = stdout;
+    if (argc > 1 && (out = fopen(argv[1], "w")) == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    motor_control_init();               // shims: no timer, no hardware
+    bench_run(out);
+
+    if (out != stdout) fclose(out);
+    return 0;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <stdint.h>
+#include "esp_err.h"
+typedef int gpio_num_t;
+typedef enum { GPIO_INTR_DISABLE } gpio_int_type_t;
+typedef enum { GPIO_MODE_OUTPUT = 2 } gpio_mode_t;
+typedef struct {
+    uint64_t        pin_bit_mask;
+    gpio_mode_t     mode;
+    int             pull_up_en;
+    int             pull_down_en;
+    gpio_int_type_t intr_type;
+} gpio_config_t;
+esp_err_t gpio_config(const gpio_config_t *cfg);
+esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level);
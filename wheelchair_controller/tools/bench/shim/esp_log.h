@@ -0,0 +1,16 @@
+/* Host shim: ESP_LOGx compiled out, DLOGx records counted (see shim.c). */
+#pragma once
+#include <stdint.h>
+#include "esp_err.h"
+typedef enum {
+    ESP_LOG_NONE, ESP_LOG_ERROR, ESP_LOG_WARN, ESP_LOG_INFO, ESP_LOG_DEBUG, ESP_LOG_VERBOSE
+} esp_log_level_t;
+#ifndef LOG_LOCAL_LEVEL
+#define LOG_LOCAL_LEVEL         ESP_LOG_INFO    /* IDF default */
+#endif
+#define ESP_LOG_SHIM(tag, ...)  do { (void)(tag); } while (0)
+#define ESP_LOGE(tag, ...)      ESP_LOG_SHIM(tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...)      ESP_LOG_SHIM(tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...)      ESP_LOG_SHIM(tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...)      ESP_LOG_SHIM(tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...)      ESP_LOG_SHIM(tag, __VA_ARGS__)
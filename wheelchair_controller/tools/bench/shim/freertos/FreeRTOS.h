@@ -0,0 +1,8 @@
+/* Host shim: the benchmark is single threaded, critical sections are no‑ops. */
+#pragma once
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED    0
+#define portENTER_CRITICAL(m)           (void)(m)
+#define portEXIT_CRITICAL(m)            (void)(m)
+#define portENTER_CRITICAL_SAFE(m)      (void)(m)
+#define portEXIT_CRITICAL_SAFE(m)       (void)(m)
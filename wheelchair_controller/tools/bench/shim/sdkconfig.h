@@ -0,0 +1,27 @@
+/* Host benchmark configuration — mirrors the Kconfig defaults. */
+#pragma once
+#define CONFIG_IDF_TARGET                   "host"
+#define CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ     240
+#define CONFIG_BENCH_SUITE                  1
+#define CONFIG_MOTOR_DRIVE_CHANNELS         2
+#define CONFIG_MOTOR_AUX_CHANNELS           0
+#define CONFIG_MOTOR_PWM_FREQ_HZ            5000
+#define CONFIG_MOTOR_DECAY_MS               300
+#define CONFIG_MOTOR_TASK_PERIOD_MS         10
+#define CONFIG_MOTOR_PLAYOUT_MAX_GRACE_MS   350
+#define CONFIG_MOTOR_PLAYOUT_MAX_EXTRAP_MS  100
+#define CONFIG_MOTOR_SRC_DEADBAND_PERCENT   5
+#define CONFIG_MOTOR_SRC_ATTENDANT_TIMEOUT_MS 300
+#define CONFIG_MOTOR_SRC_LOCAL_TIMEOUT_MS   150
+#define CONFIG_MOTOR_SRC_LOCAL_RELEASE_MS   2000
+#define CONFIG_MOTOR_SRC_MQTT_TIMEOUT_MS    350
+#define CONFIG_MOTOR_SRC_HTTP_TIMEOUT_MS    350
+#define CONFIG_MOTOR_TWIST_TURN_PERCENT     100
+#define CONFIG_MOTOR_TWIST_MIN_PERCENT      0
+#define CONFIG_MOTOR_TWIST_MAX_PERCENT      100
+#define CONFIG_MOTOR1_PWM_GPIO              23
+#define CONFIG_MOTOR1_DIR_GPIO              22
+#define CONFIG_MOTOR1_MAX_PERCENT           100
+#define CONFIG_MOTOR2_PWM_GPIO              18
+#define CONFIG_MOTOR2_DIR_GPIO              19
+#define CONFIG_MOTOR2_MAX_PERCENT           100
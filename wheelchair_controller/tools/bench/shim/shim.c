@@ -0,0 +1,84 @@
+/*=====================================================================
+ * shim.c — Host stand‑ins for the IDF calls on the benchmarked paths
+ *
+ * GPIO/LEDC writes land in a volatile register image so the apply pass
+ * keeps its stores; the deferred logger only counts records.
+ *====================================================================*/
+
+#include <time.h>
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "esp_spiffs.h"
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "deferred_log.h"
+
+static volatile uint32_t s_gpio_out;
+static volatile uint32_t s_ledc_duty[LEDC_CHANNEL_MAX];
+static volatile uint32_t s_dlog_records;
+
+const char *esp_err_to_name(esp_err_t err) { return err ? "ESP_FAIL" : "ESP_OK"; }
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out)
+{
+    (void)args;
+    *out = NULL;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    (void)timer; (void)period_us;
+    return ESP_OK;                      // the benchmark never runs the tick
+}
+
+esp_err_t gpio_config(const gpio_config_t *cfg) { (void)cfg; return ESP_OK; }
+
+esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level)
+{
+    if (level) s_gpio_out |= 1u << (gpio & 31);
+    else       s_gpio_out &= ~(1u << (gpio & 31));
+    return ESP_OK;
+}
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t *cfg) { (void)cfg; return ESP_OK; }
+esp_err_t ledc_channel_config(const ledc_channel_config_t *cfg) { (void)cfg; return ESP_OK; }
+
+esp_err_t ledc_set_duty(ledc_mode_t mode, ledc_channel_t ch, uint32_t duty)
+{
+    (void)mode;
+    s_ledc_duty[ch] = duty;
+    return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t mode, ledc_channel_t ch)
+{
+    (void)mode; (void)ch;
+    return ESP_OK;
+}
+
+esp_err_t esp_vfs_spiffs_register(const esp_vfs_spiffs_conf_t *conf)
+{
+    (void)conf;
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t esp_spiffs_info(const char *label, size_t *total, size_t *used)
+{
+    (void)label; *total = *used = 0;
+    return ESP_FAIL;
+}
+
+void deferred_log_write(esp_log_level_t level, const char *tag,
+                        const char *fmt, uint32_t nargs, const int32_t *args)
+{
+    (void)level; (void)tag; (void)fmt; (void)nargs; (void)args;
+    s_dlog_records++;
+}
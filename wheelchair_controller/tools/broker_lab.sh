@@ -0,0 +1,62 @@
+#!/bin/bash
+# Two local Mosquitto brokers for exercising MQTT broker failover.
+#
+#   "lan"   listens on port 1883  -> MQTT_LAN_URI=mqtt://<host-ip>:1883
+#   "cloud" listens on port 1884  -> MQTT_BROKER_URI=mqtt://<host-ip>:1884
+#
+# Put both URIs into spiffs/.env, flash, then:
+#   tools/broker_lab.sh start           - start both brokers
+#   tools/broker_lab.sh impair lan      - freeze a broker (TCP still accepts, MQTT hangs)
+#   tools/broker_lab.sh restore lan     - unfreeze it
+#   tools/broker_lab.sh kill cloud      - stop one broker outright
+#   tools/broker_lab.sh stop            - stop both
+#
+# Watch the controller log for "Lost broker", "Broker N RTT" and "Using broker".
+
+set -e
+
+LAB_DIR="${TMPDIR:-/tmp}/wheelchair_broker_lab"
+declare -A PORTS=( [lan]=1883 [cloud]=1884 )
+
+pidfile() { echo "$LAB_DIR/$1.pid"; }
+
+start_one() {
+  local name=$1 port=${PORTS[$1]}
+  cat > "$LAB_DIR/$name.conf" <<CONF
+listener $port 0.0.0.0
+allow_anonymous true
+persistence false
+CONF
+  mosquitto -c "$LAB_DIR/$name.conf" -d
+  sleep 0.2
+  pgrep -n -f "mosquitto -c $LAB_DIR/$name.conf" > "$(pidfile "$name")"
+  echo "$name broker on port $port (pid $(cat "$(pidfile "$name")"))"
+}
+
+signal_one() {
+  local sig=$1 name=$2
+  [ -n "${PORTS[$name]}" ] || { echo "unknown broker: $name (lan|cloud)"; exit 1; }
+  kill "-$sig" "$(cat "$(pidfile "$name")")"
+}
+
+case "$1" in
+  start)
+    mkdir -p "$LAB_DIR"
+    start_one lan
+    start_one cloud
+    ;;
+  impair)  signal_one STOP "$2"; echo "$2 frozen" ;;
+  restore) signal_one CONT "$2"; echo "$2 resumed" ;;
+  kill)    signal_one TERM "$2"; echo "$2 stopped" ;;
+  stop)
+    for name in lan cloud; do
+      [ -f "$(pidfile $name)" ] && kill -CONT "$(cat "$(pidfile $name)")" 2>/dev/null \
+        && kill "$(cat "$(pidfile $name)")" 2>/dev/null || true
+    done
+    rm -rf "$LAB_DIR"
+    ;;
+  *)
+    sed -n '2,15p' "$0"
+    exit 1
+    ;;
+esac
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+"""Render the controller's CPU profiler reports as a table.
+
+Reads the JSON reports either from a serial log (lines tagged CPU_PROF,
+e.g. `idf.py monitor | tee log.txt`) or live from MQTT
+(wheelchair/diag/cpu).
+
+Usage:
+    tools/cpu_report.py log.txt
+    idf.py -p PORT monitor | tools/cpu_report.py -
+    tools/cpu_report.py --mqtt broker.local [--port 1883] [--user U --password P] [--tls]
+"""
+import argparse
+import json
+import sys
+
+TOPIC = 'wheelchair/diag/cpu'
+MARKER = 'CPU_PROF: '
+
+
+def render(report: dict) -> None:
+    load = report.get('core', [0, 0])
+    calls, avg_us, max_us, late_us, pwm_err = (report.get('tick', []) + [0, 0, 0, 0, 0])[:5]
+    print(f"\n=== window {report.get('t', 0)} ms | "
+          f"core0 {load[0] / 10:5.1f} %  core1 {load[1] / 10:5.1f} % | "
+          f"motor tick: {calls} calls, avg {avg_us} us, max {max_us} us, late {late_us} us"
+          f"{f', {pwm_err} PWM errors' if pwm_err else ''} ===")
+    print(f"{'task':<16} {'core':>4} {'cpu %':>7}")
+    for name, core, share in sorted(report.get('tasks', []), key=lambda t: -t[2]):
+        core_s = '*' if core < 0 else str(core)
+        print(f'{name:<16} {core_s:>4} {share / 10:7.1f}')
+
+
+def handle_line(line: str) -> None:
+    idx = line.find(MARKER)
+    if idx < 0:
+        return
+    payload = line[idx + len(MARKER):].strip()
+    # strip the ANSI colour reset that esp_log may append
+    payload = payload.split('\x1b')[0]
+    try:
+        render(json.loads(payload))
+    except json.JSONDecodeError:
+        pass
+
+
+def run_mqtt(args: argparse.Namespace) -> None:
+    try:
+        import paho.mqtt.client as mqtt
+    except ImportError:
+        sys.exit('paho-mqtt is required for --mqtt (pip install paho-mqtt)')
+
+    def on_message(_client, _userdata, msg):
+        try:
+            render(json.loads(msg.payload))
+        except json.JSONDecodeError:
+            print('invalid report:', msg.payload, file=sys.stderr)
+
+    client = mqtt.Client()
+    if args.user:
+        client.username_pw_set(args.user, args.password)
+    if args.tls:
+        client.tls_set()
+    client.on_message = on_message
+    client.connect(args.mqtt, args.port)
+    client.subscribe(TOPIC)
+    client.loop_forever()
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('log', nargs='?', default='-', help="serial log file, '-' for stdin")
+    parser.add_argument('--mqtt', help='broker host to subscribe to instead of reading a log')
+    parser.add_argument('--port', type=int, default=1883)
+    parser.add_argument('--user')
+    parser.add_argument('--password')
+    parser.add_argument('--tls', action='store_true')
+    args = parser.parse_args()
+
+    if args.mqtt:
+        run_mqtt(args)
+        return
+
+    stream = sys.stdin if args.log == '-' else open(args.log, encoding='utf-8', errors='replace')
+    with stream:
+        for line in stream:
+            handle_line(line)
+
+
+if __name__ == '__main__':
+    main()
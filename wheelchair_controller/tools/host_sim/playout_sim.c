@@ -0,0 +1,188 @@
+/*=====================================================================
+ * playout_sim.c — Replay command arrival traces through cmd_playout
+ *
+ * A reference joystick signal is "sent" every SEND_PERIOD_MS; each
+ * packet arrives at the time given by the trace (recorded, or a
+ * synthetic in‑order TCP‑like trace with jitter and stalls).  The
+ * 10 ms control tick then samples two configurations:
+ *   fixed    — hold last command, fixed 300 ms watchdog (old firmware)
+ *   adaptive — cmd_playout with the firmware's default Kconfig values
+ *
+ * Reported per configuration: RMS error of the target against the
+ * reference (delayed by the median one‑way latency), watchdog expiries,
+ * ticks wrongly forced to zero while the operator was driving, and the
+ * mean / worst watchdog grace — how long the chair would keep driving
+ * after the link died at that moment.
+ *
+ * Trace format: one "send_ms,arrival_ms" pair per line.
+ *====================================================================*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "cmd_playout.h"
+
+#define SEND_PERIOD_MS      30
+#define TICK_MS             10
+#define DECAY_MS            300
+#define MAX_GRACE_MS        350
+#define MAX_EXTRAP_MS       100
+#define SYNTH_DURATION_MS   120000
+#define MAX_PACKETS         20000
+
+typedef struct {
+    double send_ms;
+    double arrival_ms;
+} packet_t;
+
+typedef struct {
+    const char  *name;
+    cmd_playout_t p;
+    double       sq_err;
+    long         samples;
+    long         false_stops;
+    double       grace_sum_ms;
+    int32_t      grace_max_us;
+} run_t;
+
+static packet_t g_pkts[MAX_PACKETS];
+static int      g_npkts;
+
+/* Operator input: slow figure‑of‑eight with a 2 s rest every 20 s. */
+static void reference(double t_ms, int16_t out[2])
+{
+    double t = t_ms / 1000.0;
+    if (fmod(t, 20.0) >= 18.0) {
+        out[0] = out[1] = 0;
+        return;
+    }
+    double v = 50.0 * sin(2.0 * M_PI * t / 6.0);
+    double w = 30.0 * sin(2.0 * M_PI * t / 2.5);
+    out[0] = (int16_t)lround(v - w);
+    out[1] = (int16_t)lround(v + w);
+}
+
+static double rand_exp(double mean)
+{
+    double u = (rand() + 1.0) / ((double)RAND_MAX + 2.0);
+    return -mean * log(u);
+}
+
+/* In‑order delivery: 20 ms base, exponential jitter, 1 % 250 ms stalls. */
+static void synth_trace(void)
+{
+    double last_arrival = 0;
+    srand(1);
+    for (double t = 0; t < SYNTH_DURATION_MS && g_npkts < MAX_PACKETS;
+         t += SEND_PERIOD_MS) {
+        double d = 20.0 + rand_exp(25.0);
+        if (rand() % 100 == 0) d += 250.0;
+        double a = t + d;
+        if (a < last_arrival) a = last_arrival;     // TCP head‑of‑line
+        last_arrival = a;
+        g_pkts[g_npkts++] = (packet_t){ t, a };
+    }
+}
+
+static int load_trace(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    char line[128];
+    while (fgets(line, sizeof(line), f) && g_npkts < MAX_PACKETS) {
+        packet_t pk;
+        if (sscanf(line, "%lf,%lf", &pk.send_ms, &pk.arrival_ms) == 2) {
+            g_pkts[g_npkts++] = pk;
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) {
+        if (load_trace(argv[1]) != 0) return 1;
+    } else {
+        synth_trace();
+    }
+    if (g_npkts < 2) {
+        fprintf(stderr, "trace has fewer than 2 packets\n");
+        return 1;
+    }
+
+    static double lat[MAX_PACKETS];
+    for (int i = 0; i < g_npkts; i++) {
+        lat[i] = g_pkts[i].arrival_ms - g_pkts[i].send_ms;
+    }
+    qsort(lat, g_npkts, sizeof(lat[0]), cmp_double);
+    double median = lat[g_npkts / 2];
+    double p99    = lat[(int)(g_npkts * 0.99)];
+
+    run_t runs[2] = {
+        { .name = "fixed" },
+        { .name = "adaptive" },
+    };
+    cmd_playout_init(&runs[0].p, DECAY_MS * 1000, DECAY_MS * 1000, 0);
+    cmd_playout_init(&runs[1].p, DECAY_MS * 1000, MAX_GRACE_MS * 1000,
+                     MAX_EXTRAP_MS * 1000);
+
+    double end_ms = g_pkts[g_npkts - 1].arrival_ms;
+    double last_send = g_pkts[g_npkts - 1].send_ms;
+    int next = 0;
+    for (double t = 0; t <= end_ms; t += TICK_MS) {
+        int64_t now_us = (int64_t)(t * 1000.0);
+
+        while (next < g_npkts && g_pkts[next].arrival_ms <= t) {
+            int16_t cmd[2];
+            reference(g_pkts[next].send_ms, cmd);
+            for (int r = 0; r < 2; r++) {
+                cmd_playout_push(&runs[r].p,
+                                 (int64_t)(g_pkts[next].arrival_ms * 1000.0),
+                                 cmd[0], cmd[1]);
+            }
+            next++;
+        }
+
+        int16_t ref[2];
+        double ref_t = t - median;
+        if (ref_t < 0 || ref_t > last_send) continue;
+        reference(ref_t, ref);
+
+        for (int r = 0; r < 2; r++) {
+            int16_t out[2];
+            int32_t grace = cmd_playout_grace_us(&runs[r].p);
+            runs[r].grace_sum_ms += grace / 1000.0;
+            if (grace > runs[r].grace_max_us) runs[r].grace_max_us = grace;
+            bool ok = cmd_playout_sample(&runs[r].p, now_us, out);
+            double e0 = out[0] - ref[0], e1 = out[1] - ref[1];
+            runs[r].sq_err += e0 * e0 + e1 * e1;
+            runs[r].samples += 2;
+            if (!ok && (ref[0] != 0 || ref[1] != 0)) runs[r].false_stops++;
+        }
+    }
+
+    printf("packets=%d  latency median=%.1f ms  p99=%.1f ms\n",
+           g_npkts, median, p99);
+    printf("%-9s %10s %9s %12s %12s %10s %10s\n",
+           "config", "rms_err_%", "expiries", "false_stops", "extrap_ticks",
+           "grace_avg", "grace_max");
+    for (int r = 0; r < 2; r++) {
+        printf("%-9s %10.2f %9u %12ld %12u %10.0f %10d\n", runs[r].name,
+               sqrt(runs[r].sq_err / (double)runs[r].samples),
+               runs[r].p.expiries, runs[r].false_stops,
+               runs[r].p.extrapolated_ticks,
+               runs[r].grace_sum_ms / (double)(runs[r].samples / 2),
+               runs[r].grace_max_us / 1000);
+    }
+    return 0;
+}
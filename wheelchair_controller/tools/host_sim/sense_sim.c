@@ -0,0 +1,129 @@
+/*=====================================================================
+ * sense_sim.c — Drive sense_pipeline from sense_fake through a stall
+ *
+ * Same sample path as the firmware with CONFIG_POWER_SENSE_FAKE: a
+ * round‑robin L/R/pack sample stream at SAMPLE_HZ, decimated and
+ * filtered by sense_pipeline, overcurrent checked on the decimated
+ * left/right currents.  Scenario (left side):
+ *   0 … 3000 ms   cruise at 8 A
+ *   500 ms        1 ms inrush spike to 60 A (must not trip)
+ *   1000 … 2200   wheel stalled: current = 45 A × output cap
+ * Cutback caps the output at CUTBACK_PERCENT, so a stall keeps
+ * re‑tripping after each hold period — as it would on the chair.
+ *
+ * Reported per (decimation, trip samples) pair: stall‑to‑trip latency,
+ * trips during the stall and spurious trips outside it.
+ *
+ * Usage: ./sense_sim [noise_counts]     (default 12)
+ *====================================================================*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "sense_pipeline.h"
+#include "sense_fake.h"
+
+#define SAMPLE_HZ           20000
+#define NCHAN               3
+#define DURATION_MS         3000
+#define FULL_MV             3100        /* nominal ADC span */
+#define MV_PER_A            40
+#define ZERO_MV             1650
+#define DIVIDER_X1000       11000
+#define TRIP_MA             30000
+#define RELEASE_MA          (TRIP_MA / 100 * 80)
+#define CUTBACK_PERCENT     30
+#define HOLD_MS             500
+
+#define CRUISE_MA           8000
+#define STALL_MA            45000
+#define SPIKE_MA            60000
+#define SPIKE_AT_MS         500
+#define SPIKE_LEN_MS        1
+#define STALL_FROM_MS       1000
+#define STALL_TO_MS         2200
+
+typedef struct {
+    double first_trip_ms;
+    int    stall_trips;
+    int    spurious;
+    int32_t pack_mv;
+    int32_t right_ma;
+} result_t;
+
+static result_t run(uint16_t decim, uint16_t trip_samples, uint16_t noise)
+{
+    const int32_t slope_q16 = ((int32_t)FULL_MV << 16) / 4095;
+    sense_chan_t ch[NCHAN];
+    sense_oc_t oc;
+    sense_fake_t fake;
+
+    for (int i = 0; i < 2; i++) {
+        sense_chan_init(&ch[i], decim, 2, slope_q16 * 1000 / MV_PER_A,
+                        -ZERO_MV * 1000 / MV_PER_A);
+    }
+    sense_chan_init(&ch[2], decim, 6, (int32_t)((int64_t)slope_q16 * DIVIDER_X1000 / 1000), 0);
+
+    uint32_t out_hz = SAMPLE_HZ / NCHAN / decim;
+    uint32_t hold = (uint32_t)HOLD_MS * out_hz / 1000;
+    sense_oc_init(&oc, TRIP_MA, RELEASE_MA, trip_samples, hold ? hold : 1);
+    sense_fake_init(&fake, NCHAN, noise, 12345);
+
+    result_t res = { .first_trip_ms = -1 };
+    const long total = (long)SAMPLE_HZ * DURATION_MS / 1000;
+
+    for (long n = 0; n < total; n++) {
+        double t_ms = n * 1000.0 / SAMPLE_HZ;
+        int cap = oc.tripped ? CUTBACK_PERCENT : 100;
+        int32_t left = CRUISE_MA;
+        if (t_ms >= STALL_FROM_MS && t_ms < STALL_TO_MS) left = STALL_MA * cap / 100;
+        if (t_ms >= SPIKE_AT_MS && t_ms < SPIKE_AT_MS + SPIKE_LEN_MS) left = SPIKE_MA;
+
+        sense_fake_set_level(&fake, 0, sense_chan_units_to_raw(&ch[0], left));
+        sense_fake_set_level(&fake, 1, sense_chan_units_to_raw(&ch[1], CRUISE_MA));
+        sense_fake_set_level(&fake, 2, sense_chan_units_to_raw(&ch[2], 24000));
+
+        sense_sample_t s;
+        sense_fake_fill(&fake, &s, 1);
+        if (!sense_chan_push(&ch[s.idx], s.raw) || s.idx != 0) continue;
+
+        if (sense_oc_update(&oc, ch[0].fast) && oc.tripped) {
+            if (t_ms >= STALL_FROM_MS && t_ms < STALL_TO_MS) {
+                if (res.first_trip_ms < 0) res.first_trip_ms = t_ms - STALL_FROM_MS;
+                res.stall_trips++;
+            } else {
+                res.spurious++;
+            }
+        }
+    }
+    res.pack_mv  = ch[2].value;
+    res.right_ma = ch[1].value;
+    return res;
+}
+
+int main(int argc, char **argv)
+{
+    uint16_t noise = argc > 1 ? (uint16_t)atoi(argv[1]) : 12;
+    static const uint16_t decims[] = {4, 8, 16, 32};
+    static const uint16_t trips[]  = {1, 2, 3};
+
+    printf("sample rate %d Hz over %d channels, noise ±%u counts\n"
+           "trip %d mA, release %d mA after %d ms, cutback %d %%\n\n",
+           SAMPLE_HZ, NCHAN, noise, TRIP_MA, RELEASE_MA, HOLD_MS, CUTBACK_PERCENT);
+    printf("%6s %6s %10s %12s %9s %9s %10s\n",
+           "decim", "trip_n", "out_ms", "latency_ms", "stall_tr", "spurious", "pack_mv");
+
+    for (size_t d = 0; d < sizeof(decims) / sizeof(decims[0]); d++) {
+        for (size_t k = 0; k < sizeof(trips) / sizeof(trips[0]); k++) {
+            result_t r = run(decims[d], trips[k], noise);
+            double out_ms = 1000.0 * decims[d] * NCHAN / SAMPLE_HZ;
+            if (r.first_trip_ms < 0) {
+                printf("%6u %6u %10.2f %12s %9d %9d %10d\n", decims[d], trips[k],
+                       out_ms, "none", r.stall_trips, r.spurious, (int)r.pack_mv);
+            } else {
+                printf("%6u %6u %10.2f %12.2f %9d %9d %10d\n", decims[d], trips[k],
+                       out_ms, r.first_trip_ms, r.stall_trips, r.spurious, (int)r.pack_mv);
+            }
+        }
+    }
+    return 0;
+}
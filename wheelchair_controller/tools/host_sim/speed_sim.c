@@ -0,0 +1,214 @@
+/*=====================================================================
+ * speed_sim.c — Wheel speed loop against a DC‑motor + chair plant
+ *
+ * Plant per wheel, speeds in % of no‑load full speed at nominal pack
+ * voltage:
+ *     drive = duty × vbat − speed            (back‑EMF limited current)
+ *     accel = (drive − friction − load) / TAU_S
+ * with stiction at standstill and a quadrature encoder quantised to
+ * whole counts per 10 ms tick.  The reference goes through the same
+ * 300 ms full‑scale slew as the firmware tick.
+ *
+ * Scenarios: step to 50 %, both wheels climbing a slope, a side slope
+ * loading only the left wheel, a sagging pack, and a slow joystick
+ * ramp.  Each is run open loop (duty = reference, the old firmware)
+ * and through speed_ctrl with the default Kconfig gains.
+ *
+ * Reported: settling time to ±2 % after the reference stops moving,
+ * overshoot, RMS and final tracking error of the left wheel, and the
+ * heading error built up from left/right mismatch (0.55 m track,
+ * 1.9 m/s full speed).
+ *
+ * Usage: ./speed_sim [KP_X100 KI_X100 [KFF_X100 KS_PERCENT]]
+ *====================================================================*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "speed_ctrl.h"
+
+#define TICK_MS             10
+#define DECAY_MS            300
+#define FULL_CPS            4800        /* encoder counts/s at 100 % */
+#define DURATION_MS         6000
+
+/* plant */
+#define TAU_S               0.25
+#define FRICTION_PCT        6.0
+#define STICTION_PCT        9.0
+#define FULL_SPEED_MPS      1.9
+#define TRACK_M             0.55
+
+/* firmware defaults (Kconfig) */
+#define DEF_KP_X100         300
+#define DEF_KI_X100         600
+#define DEF_KD_MS           0
+#define DEF_KFF_X100        100
+#define DEF_KS_PCT          5
+#define DEF_MEAS_SHIFT      1
+#define DEF_TRIM_PCT        40
+#define DEF_FAULT_MS        300
+
+#define Q8(p)               ((int32_t)lround((p) * 256.0))
+
+typedef struct {
+    const char *name;
+    double load_left, load_right;       /* % of full torque */
+    double vbat;                        /* pack / nominal */
+    int    ramp_ms;                     /* reference ramp 0 → 50 %; 0 = step */
+} scenario_t;
+
+typedef struct {
+    double speed;                       /* % */
+    double pos_counts;
+    long   counts;                      /* encoder, whole counts */
+} wheel_t;
+
+typedef struct {
+    double settle_ms;
+    double overshoot;
+    double rms;
+    double final_err;
+    double heading_deg;
+} result_t;
+
+static const scenario_t k_scen[] = {
+    { "step 50%",       0,  0, 1.00, 0    },
+    { "slope 20%",     20, 20, 1.00, 0    },
+    { "side slope",    15,  0, 1.00, 0    },
+    { "pack sag 85%",   0,  0, 0.85, 0    },
+    { "slow ramp",      5,  5, 1.00, 2000 },
+};
+
+static void plant_step(wheel_t *w, double duty, double vbat, double load, double dt)
+{
+    double drive = duty * vbat - w->speed;
+    if (fabs(w->speed) < 1e-6) {
+        /* at rest: only breaks away above stiction */
+        double net = drive - load;
+        if (fabs(net) <= STICTION_PCT) return;
+        drive -= copysign(FRICTION_PCT, net);
+    } else {
+        drive -= copysign(FRICTION_PCT, w->speed);
+    }
+    double next = w->speed + (drive - load) * dt / TAU_S;
+    /* friction stops the wheel, it does not reverse it */
+    if (fabs(w->speed) > 1e-6 && (next > 0) != (w->speed > 0) && fabs(duty) < 1e-6) next = 0;
+    w->speed = next;
+    w->pos_counts += w->speed / 100.0 * FULL_CPS * dt;
+    w->counts = (long)floor(w->pos_counts);
+}
+
+static double reference(const scenario_t *s, int t_ms)
+{
+    if (t_ms < 200) return 0;
+    if (s->ramp_ms == 0) return 50;
+    double r = 50.0 * (t_ms - 200) / s->ramp_ms;
+    return r > 50 ? 50 : r;
+}
+
+static result_t run(const scenario_t *s, const speed_ctrl_cfg_t *cfg)
+{
+    wheel_t w[2] = {0};
+    speed_ctrl_t c[2];
+    long prev_counts[2] = {0, 0};
+    int32_t ref_q = 0;
+    const int32_t slew_q = SPEED_CTRL_Q_FULL * TICK_MS / DECAY_MS;
+    const double loads[2] = { s->load_left, s->load_right };
+    const double dt = TICK_MS / 1000.0;
+    const int sub = 10;                             /* plant steps per tick */
+
+    for (int i = 0; i < 2; i++) if (cfg) speed_ctrl_init(&c[i], cfg);
+
+    result_t r = { .settle_ms = -1 };
+    double sq = 0, heading = 0, peak = 0;
+    long n = 0;
+    int settled_since = -1, ref_done = -1;
+
+    for (int t = 0; t < DURATION_MS; t += TICK_MS) {
+        /* firmware slew toward the commanded value */
+        int32_t tgt = Q8(reference(s, t));
+        int32_t diff = tgt - ref_q;
+        ref_q += diff > slew_q ? slew_q : (diff < -slew_q ? -slew_q : diff);
+        if (ref_done < 0 && ref_q == Q8(50)) ref_done = t;
+
+        double duty[2];
+        for (int i = 0; i < 2; i++) {
+            long delta = w[i].counts - prev_counts[i];
+            prev_counts[i] = w[i].counts;
+            int32_t meas_q = (int32_t)(delta * SPEED_CTRL_Q_FULL * 1000 / (FULL_CPS * TICK_MS));
+            int32_t out = cfg ? speed_ctrl_update(&c[i], ref_q, meas_q, SPEED_CTRL_Q_FULL)
+                              : ref_q;
+            duty[i] = out / 256.0;
+        }
+        for (int k = 0; k < sub; k++) {
+            for (int i = 0; i < 2; i++) plant_step(&w[i], duty[i], s->vbat, loads[i], dt / sub);
+        }
+
+        double ref = ref_q / 256.0;
+        double err = ref - w[0].speed;
+        if (t >= 200) {
+            sq += err * err;
+            n++;
+        }
+        heading += (w[1].speed - w[0].speed) / 100.0 * FULL_SPEED_MPS * dt / TRACK_M;
+        if (ref_done >= 0) {
+            if (w[0].speed - 50 > peak) peak = w[0].speed - 50;
+            if (fabs(err) <= 2.0) {
+                if (settled_since < 0) settled_since = t;
+            } else {
+                settled_since = -1;
+            }
+        }
+    }
+    r.settle_ms   = settled_since < 0 ? -1 : settled_since - ref_done;
+    r.overshoot   = peak;
+    r.rms         = n ? sqrt(sq / n) : 0;
+    r.final_err   = 50 - w[0].speed;
+    r.heading_deg = heading * 180.0 / M_PI;
+    return r;
+}
+
+static void print_row(const char *scen, const char *mode, const result_t *r)
+{
+    char settle[16];
+    if (r->settle_ms < 0) snprintf(settle, sizeof(settle), "never");
+    else                  snprintf(settle, sizeof(settle), "%.0f", r->settle_ms);
+    printf("%-14s %-7s %9s %10.1f %8.2f %10.2f %12.1f\n",
+           scen, mode, settle, r->overshoot, r->rms, r->final_err, r->heading_deg);
+}
+
+int main(int argc, char **argv)
+{
+    int kp  = argc > 2 ? atoi(argv[1]) : DEF_KP_X100;
+    int ki  = argc > 2 ? atoi(argv[2]) : DEF_KI_X100;
+    int kff = argc > 4 ? atoi(argv[3]) : DEF_KFF_X100;
+    int ks  = argc > 4 ? atoi(argv[4]) : DEF_KS_PCT;
+
+    speed_ctrl_cfg_t cfg = {
+        .kp_q12        = SPEED_CTRL_GAIN_X100(kp),
+        .ki_q12        = SPEED_CTRL_GAIN_X100(ki) * TICK_MS / 1000,
+        .kd_q12        = SPEED_CTRL_GAIN_X100(DEF_KD_MS * 100) / TICK_MS,
+        .kff_q12       = SPEED_CTRL_GAIN_X100(kff),
+        .ks_q8         = ks << SPEED_CTRL_Q_SHIFT,
+        .trim_q8       = DEF_TRIM_PCT << SPEED_CTRL_Q_SHIFT,
+        .meas_shift    = DEF_MEAS_SHIFT,
+        .fault_duty_q8 = 40 << SPEED_CTRL_Q_SHIFT,
+        .fault_ticks   = DEF_FAULT_MS / TICK_MS,
+    };
+
+    printf("Kp %.2f  Ki %.2f/s  Kff %.2f  Ks %d %%  | plant tau %.2f s, friction %.0f %%, "
+           "encoder %d counts/s at 100 %%\n\n",
+           kp / 100.0, ki / 100.0, kff / 100.0, ks, TAU_S, FRICTION_PCT, FULL_CPS);
+    printf("%-14s %-7s %9s %10s %8s %10s %12s\n",
+           "scenario", "mode", "settle_ms", "overshoot", "rms_%", "final_%", "heading_deg");
+
+    for (size_t i = 0; i < sizeof(k_scen) / sizeof(k_scen[0]); i++) {
+        result_t open = run(&k_scen[i], NULL);
+        result_t pid  = run(&k_scen[i], &cfg);
+        print_row(k_scen[i].name, "open", &open);
+        print_row("", "closed", &pid);
+    }
+    return 0;
+}
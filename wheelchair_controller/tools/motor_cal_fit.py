@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+"""Fit per-motor output calibrations (deadband, curve, gain) from a duty sweep.
+
+Input is a CSV log of a wheels-up sweep, one row per steady-state point:
+
+    channel,duty_pm,speed
+
+duty_pm is the PWM duty in per mille (0-1000, one direction). speed is
+the wheel speed in any unit common to all channels, e.g. encoder counts/s
+(CONFIG_MOTOR_ENCODERS) or a tachometer reading. A header row is allowed.
+Several rows per duty are averaged.
+
+For each channel the fit finds:
+- the deadband: the duty where the wheel starts to turn (speed above
+  --start of the channel's top speed);
+- the duty needed for 0, 10, ... 100 % of the common top speed. The common
+  top speed is the slowest channel's top speed, so matched sides drive
+  straight;
+- the firmware's gain and curve values (main/motor_lut.h) for those duties.
+
+The result is printed as the JSON the chair accepts on
+wheelchair/config/motor_cal. With --mqtt it is also published, and the
+chair stores it in NVS and answers on wheelchair/diag/motor_cal.
+
+Usage:
+    tools/motor_cal_fit.py sweep.csv
+    tools/motor_cal_fit.py sweep.csv --table          # also show the duty LUT
+    tools/motor_cal_fit.py sweep.csv --mqtt broker.local
+
+Publishing requires paho-mqtt.
+"""
+import argparse
+import csv
+import json
+import sys
+from collections import defaultdict
+
+CMD_TOPIC = 'wheelchair/config/motor_cal'
+STATUS_TOPIC = 'wheelchair/diag/motor_cal'
+POINTS = 11                     # MOTOR_CAL_POINTS
+LUT_SIZE = 401                  # MOTOR_LUT_SIZE, 1/4 % steps
+DEADBAND_MAX, GAIN_MIN, GAIN_MAX = 500, 100, 2000
+
+
+def load(path):
+    """{channel: [(duty_pm, mean speed)], sorted by duty}"""
+    acc = defaultdict(lambda: defaultdict(list))
+    with open(path, newline='') as f:
+        for row in csv.reader(f):
+            if not row or row[0].strip().startswith('#'):
+                continue
+            try:
+                ch, duty, speed = int(row[0]), float(row[1]), abs(float(row[2]))
+            except (ValueError, IndexError):
+                continue                                # header / junk
+            acc[ch][duty].append(speed)
+    return {ch: sorted((d, sum(v) / len(v)) for d, v in pts.items())
+            for ch, pts in acc.items()}
+
+
+def monotone(points):
+    """Running maximum of speed, so the inverse is well defined."""
+    out, top = [], 0.0
+    for duty, speed in points:
+        top = max(top, speed)
+        out.append((duty, top))
+    return out
+
+
+def duty_for(points, speed):
+    """Smallest duty reaching @speed, linearly interpolated."""
+    for (d0, s0), (d1, s1) in zip(points, points[1:]):
+        if s1 >= speed:
+            if s1 == s0:
+                return d0
+            return d0 + (d1 - d0) * (speed - s0) / (s1 - s0)
+    return points[-1][0]
+
+
+def fit(points, v_top, start):
+    pts = monotone(points)
+    deadband = duty_for(pts, start * pts[-1][1])
+    # duty for each knot of the common speed range; knot 0 = deadband
+    duties = [deadband] + [duty_for(pts, v_top * k / (POINTS - 1)) for k in range(1, POINTS)]
+    duties = [max(deadband, d) for d in duties]
+    span_used = duties[-1] - deadband
+    deadband_pm = min(DEADBAND_MAX, round(deadband))
+    gain = round(1000 * span_used / (1000 - deadband_pm)) if span_used > 0 else 1000
+    gain = max(GAIN_MIN, min(GAIN_MAX, gain))
+    curve = [0 if span_used <= 0 else round(1000 * (d - deadband) / span_used) for d in duties]
+    for k in range(1, POINTS):                          # keep it non-decreasing
+        curve[k] = max(curve[k - 1], min(1000, curve[k]))
+    return {'deadband': deadband_pm, 'gain': gain, 'curve': curve}
+
+
+def lut(cal, max_duty=1023):
+    """Mirror of motor_lut_build(): duty counts per 1/4 % of command."""
+    steps = (LUT_SIZE - 1) // (POINTS - 1)
+    span = 1000 - cal['deadband']
+    out = [0]
+    for i in range(1, LUT_SIZE):
+        k, f = divmod(i, steps)
+        y = cal['curve'][k] * (steps - f) + (cal['curve'][k + 1] * f if f else 0)
+        ppm = min(1000000, cal['deadband'] * 1000 + span * y * cal['gain'] // (steps * 1000))
+        out.append((ppm * max_duty + 500000) // 1000000)
+    return out
+
+
+def predicted_speed(points, duty_pm):
+    pts = monotone(points)
+    if duty_pm <= pts[0][0]:
+        return pts[0][1]
+    for (d0, s0), (d1, s1) in zip(pts, pts[1:]):
+        if d1 >= duty_pm:
+            return s0 + (s1 - s0) * (duty_pm - d0) / (d1 - d0)
+    return pts[-1][1]
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('csv', help='sweep log: channel,duty_pm,speed')
+    parser.add_argument('--start', type=float, default=0.02,
+                        help='moving above this share of top speed (default 0.02)')
+    parser.add_argument('--table', action='store_true', help='print the resulting duty tables')
+    parser.add_argument('--resolution', type=int, default=10, help='PWM bits (MOTOR_PWM_RESOLUTION)')
+    parser.add_argument('--mqtt', help='broker host: publish the calibrations')
+    parser.add_argument('--port', type=int, default=1883)
+    parser.add_argument('--user')
+    parser.add_argument('--password')
+    parser.add_argument('--tls', action='store_true')
+    args = parser.parse_args()
+
+    data = load(args.csv)
+    if not data:
+        sys.exit('no samples in ' + args.csv)
+    v_top = min(max(s for _, s in pts) for pts in data.values())
+    print(f'common top speed {v_top:.1f} (slowest channel)', file=sys.stderr)
+
+    max_duty = (1 << args.resolution) - 1
+    cmds = []
+    for ch, pts in sorted(data.items()):
+        cal = fit(pts, v_top, args.start)
+        cmds.append(dict(ch=ch, **cal))
+        table = lut(cal, max_duty)
+        # straightness check: speed at each 10 % through the fitted table
+        errs = []
+        for k in range(1, POINTS):
+            duty_pm = table[k * (LUT_SIZE - 1) // (POINTS - 1)] * 1000 / max_duty
+            errs.append(predicted_speed(pts, duty_pm) / v_top * 100 - k * 10)
+        print(f'ch{ch}: deadband {cal["deadband"]} pm, gain {cal["gain"]}, '
+              f'max speed error {max(map(abs, errs)):.1f} % of top', file=sys.stderr)
+        if args.table:
+            print(f'ch{ch} duty per 1/4 %:', table, file=sys.stderr)
+
+    for cmd in cmds:
+        print(json.dumps(cmd, separators=(',', ':')))
+
+    if args.mqtt:
+        try:
+            import paho.mqtt.client as mqtt
+        except ImportError:
+            sys.exit('paho-mqtt is required (pip install paho-mqtt)')
+        client = mqtt.Client()
+        if args.user:
+            client.username_pw_set(args.user, args.password)
+        if args.tls:
+            client.tls_set()
+        client.on_message = lambda _c, _u, msg: print('chair:', msg.payload.decode())
+        client.connect(args.mqtt, args.port)
+        client.subscribe(STATUS_TOPIC, qos=1)
+        client.loop_start()
+        for cmd in cmds:
+            client.publish(CMD_TOPIC, json.dumps(cmd, separators=(',', ':')), qos=1).wait_for_publish()
+        import time
+        time.sleep(2)                                   # collect the answers
+        client.loop_stop()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""Bytes on the wire for the chair's high-rate topics, MQTT 3.1.1 vs 5.
+
+Sizes every PUBLISH the same way as main/mqtt_wire.c. The MQTT 5 rows
+use a topic alias after the first message, so the topic string is not
+resent. They are shown with and without the "seq"/"ts" user properties
+and the 1 s message expiry. The optional TLS column adds the per-record
+overhead of an AES-GCM TLS 1.2 record (5 header + 8 nonce + 16 tag),
+assuming one PUBLISH per record, as esp-mqtt sends them.
+
+The chair logs the same comparison for its own publishes every minute
+(tag MQTT_WIRE) when built with CONFIG_MQTT_APP_V5.
+
+Usage:
+    tools/mqtt_wire_bytes.py [--state-hz 5] [--cmd-hz 10] [--tls]
+"""
+import argparse
+
+TLS_RECORD = 5 + 8 + 16
+
+STATE_TOPIC = 'wheelchair/state'
+STATE_PAYLOAD = '{"left_speed":-100,"right_speed":-100}'
+CMD_TOPIC = 'wheelchair/command/motor'
+CMD_PAYLOAD = '{"left":-100,"right":-100}'
+
+
+def varint_len(n: int) -> int:
+    return 1 if n < 128 else 2 if n < 16384 else 3 if n < 2097152 else 4
+
+
+def user_prop(key: str, value: str) -> int:
+    return 1 + 2 + len(key) + 2 + len(value)
+
+
+def publish_size(topic: str, payload: str, qos: int, v5: bool,
+                 alias: bool = False, timed: bool = False) -> int:
+    props = 0
+    if v5:
+        if alias:
+            props += 3                                  # topic alias
+            topic = ''
+        if timed:
+            props += user_prop('seq', '12345')          # typical seq
+            props += user_prop('ts', '123456789')       # ~34 h uptime in ms
+            props += 5                                  # message expiry
+    rem = 2 + len(topic) + (2 if qos else 0) + len(payload)
+    if v5:
+        rem += varint_len(props) + props
+    return 1 + varint_len(rem) + rem
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--state-hz', type=float, default=5, help='state publish rate (chair)')
+    parser.add_argument('--cmd-hz', type=float, default=10, help='motor command rate (web client)')
+    parser.add_argument('--tls', action='store_true', help='add TLS record overhead')
+    args = parser.parse_args()
+
+    extra = TLS_RECORD if args.tls else 0
+    flows = [
+        ('state    (chair -> broker, QoS 0)', STATE_TOPIC, STATE_PAYLOAD, 0, args.state_hz),
+        ('command  (broker -> chair, QoS 1)', CMD_TOPIC, CMD_PAYLOAD, 1, args.cmd_hz),
+    ]
+    variants = [
+        ('3.1.1', dict(v5=False)),
+        ('5 alias', dict(v5=True, alias=True)),
+        ('5 alias+seq/ts+expiry', dict(v5=True, alias=True, timed=True)),
+    ]
+
+    print(f"{'flow':<36} {'variant':<24} {'B/msg':>6} {'B/s':>8} {'vs 3.1.1':>9}")
+    for name, topic, payload, qos, hz in flows:
+        base = (publish_size(topic, payload, qos, False) + extra) * hz
+        for vname, kw in variants:
+            size = publish_size(topic, payload, qos, **kw) + extra
+            print(f'{name:<36} {vname:<24} {size:>6} {size * hz:>8.0f} {size * hz - base:>+9.0f}')
+
+
+if __name__ == '__main__':
+    main()
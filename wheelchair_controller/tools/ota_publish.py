@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""Push a firmware update to the controller over MQTT.
+
+Builds a compressed delta patch against the image the chair is running
+(if --base is given), serves the file over HTTP and publishes the update
+command on wheelchair/command/ota. Progress from wheelchair/ota/status is
+printed until the chair confirms the new image after rebooting, or fails.
+
+A plain-HTTP server needs CONFIG_OTA_ALLOW_HTTP on the chair; for field
+updates upload the file to an HTTPS host and pass --url instead.
+
+Usage:
+    # full image
+    tools/ota_publish.py --new build/hello_world.bin --mqtt broker.local --serve 192.168.1.20
+    # delta against the image currently on the chair (keep that .bin!)
+    tools/ota_publish.py --new build/hello_world.bin --base releases/1.4.0.bin \\
+                         --mqtt broker.local --serve 192.168.1.20
+    # file already on an HTTPS host
+    tools/ota_publish.py --new patch.bin --base releases/1.4.0.bin --delta-file \\
+                         --url https://updates.example.com/patch.bin --mqtt broker.local
+
+Requires paho-mqtt; delta patches also need detools (pip install detools).
+"""
+import argparse
+import functools
+import hashlib
+import http.server
+import json
+import os
+import sys
+import tempfile
+import threading
+
+CMD_TOPIC = 'wheelchair/command/ota'
+STATUS_TOPIC = 'wheelchair/ota/status'
+FINAL_STATES = {'failed', 'rejected', 'valid'}
+
+
+def image_digest(path: str) -> str:
+    """Digest the chair reports for an app image: the SHA-256 appended to the .bin."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    return data[-32:].hex()
+
+
+def file_sha256(path: str) -> str:
+    h = hashlib.sha256()
+    with open(path, 'rb') as f:
+        for chunk in iter(lambda: f.read(65536), b''):
+            h.update(chunk)
+    return h.hexdigest()
+
+
+def make_patch(base: str, new: str, out: str) -> None:
+    try:
+        import detools
+    except ImportError:
+        sys.exit('detools is required for delta updates (pip install detools)')
+    with open(base, 'rb') as fsrc, open(new, 'rb') as fto, open(out, 'wb') as fpatch:
+        detools.create_patch(fsrc, fto, fpatch, compression='heatshrink')
+
+
+def serve(path: str, host: str, port: int) -> str:
+    handler = functools.partial(http.server.SimpleHTTPRequestHandler,
+                                directory=os.path.dirname(os.path.abspath(path)))
+    httpd = http.server.ThreadingHTTPServer(('', port), handler)
+    threading.Thread(target=httpd.serve_forever, daemon=True).start()
+    return f'http://{host}:{port}/{os.path.basename(path)}'
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--new', required=True, help='new app image (or patch with --delta-file)')
+    parser.add_argument('--base', help='app image currently running on the chair -> delta update')
+    parser.add_argument('--delta-file', action='store_true', help='--new already is a patch')
+    parser.add_argument('--url', help='where the chair downloads the file (default: serve it)')
+    parser.add_argument('--serve', metavar='HOST', help='serve the file from this host address')
+    parser.add_argument('--http-port', type=int, default=8070)
+    parser.add_argument('--mqtt', required=True, help='broker host')
+    parser.add_argument('--port', type=int, default=1883)
+    parser.add_argument('--user')
+    parser.add_argument('--password')
+    parser.add_argument('--tls', action='store_true')
+    parser.add_argument('--timeout', type=float, default=600, help='seconds to wait for the result')
+    args = parser.parse_args()
+
+    try:
+        import paho.mqtt.client as mqtt
+    except ImportError:
+        sys.exit('paho-mqtt is required (pip install paho-mqtt)')
+
+    payload_file = args.new
+    if args.base and not args.delta_file:
+        payload_file = os.path.join(tempfile.mkdtemp(), 'patch.bin')
+        make_patch(args.base, args.new, payload_file)
+        full = os.path.getsize(args.new)
+        size = os.path.getsize(payload_file)
+        print(f'delta patch: {size} bytes ({size / full:.1%} of the {full}-byte image)')
+
+    cmd = {'sha256': file_sha256(payload_file)}
+    if args.base:
+        cmd['delta'] = True
+        cmd['base'] = image_digest(args.base)
+
+    if args.url:
+        cmd['url'] = args.url
+    elif args.serve:
+        cmd['url'] = serve(payload_file, args.serve, args.http_port)
+    else:
+        sys.exit('give --url or --serve')
+
+    done = threading.Event()
+    sent = threading.Event()
+
+    def on_connect(client, _userdata, _flags, _rc):
+        client.subscribe(STATUS_TOPIC, qos=1)
+        if not sent.is_set():                   # not again on reconnect
+            sent.set()
+            client.publish(CMD_TOPIC, json.dumps(cmd), qos=1)
+            print('sent:', json.dumps(cmd))
+
+    def on_message(_client, _userdata, msg):
+        try:
+            status = json.loads(msg.payload)
+        except json.JSONDecodeError:
+            return
+        print('status:', status)
+        if status.get('state') in FINAL_STATES:
+            done.set()
+
+    client = mqtt.Client()
+    if args.user:
+        client.username_pw_set(args.user, args.password)
+    if args.tls:
+        client.tls_set()
+    client.on_connect = on_connect
+    client.on_message = on_message
+    client.connect(args.mqtt, args.port)
+    client.loop_start()
+    ok = done.wait(args.timeout)
+    client.loop_stop()
+    if not ok:
+        sys.exit('timed out waiting for the chair')
+
+
+if __name__ == '__main__':
+    main()
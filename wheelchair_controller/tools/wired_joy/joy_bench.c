@@ -0,0 +1,391 @@
+/*=====================================================================
+ * joy_bench.c — Wired joystick path vs MQTT path, on the host
+ *
+ * Wired: a pseudo‑terminal stands in for the UART.  The sender writes
+ * joy_frame drive frames to the master side; the receiver thread
+ * sleeps in poll() on the raw slave side (as the firmware task sleeps
+ * on the UART event queue), feeds joy_parser and submits
+ * CMD_SRC_LOCAL to a cmd_arbiter.
+ *
+ * MQTT: the same commands as MQTT 3.1.1 PUBLISH packets
+ * ({"left":l,"right":r} on wheelchair/command/motor) over a TCP
+ * loopback connection; the receiver decodes the packet, routes the
+ * topic with topic_router, parses with motor_cmd_parse and submits
+ * CMD_SRC_MQTT.  There is no broker in between — on the chair the
+ * message crosses Wi‑Fi twice and the broker once — so this is the
+ * floor of the MQTT path's cost, not its real latency.
+ *
+ * Latency is write() to arbiter submit.  A last pass corrupts the
+ * wired byte stream (bit flips, dropped and inserted bytes) and
+ * checks that no damaged frame is accepted.
+ *
+ * Usage: ./joy_bench [commands] [period_us]    (default 2000, 1000)
+ *====================================================================*/
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "joy_frame.h"
+#include "cmd_arbiter.h"
+#include "motor_cmd.h"
+#include "topic_router.h"
+
+#define MOTOR_TOPIC     "wheelchair/command/motor"
+#define MAX_CMDS        100000
+
+typedef struct {
+    int      fd;
+    int      count;
+    int64_t *sent_ns;
+    int64_t *lat_ns;
+    int      received;
+    size_t   bytes;
+} path_t;
+
+static cmd_arbiter_t s_arb;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void sleep_until(int64_t t_ns)
+{
+    struct timespec ts = { .tv_sec = t_ns / 1000000000, .tv_nsec = t_ns % 1000000000 };
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+static void write_all(int fd, const uint8_t *p, size_t n)
+{
+    while (n) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            perror("write");
+            exit(1);
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+}
+
+static void cmd_for(int i, int *l, int *r)
+{
+    *l = (i * 7) % 201 - 100;
+    *r = 100 - (i * 3) % 201;
+}
+
+static void record(path_t *p, cmd_source_t src, int l, int r)
+{
+    int64_t t = now_ns();
+    cmd_arbiter_submit(&s_arb, src, t / 1000, (int16_t)l, (int16_t)r);
+    if (p->received < p->count) {
+        p->lat_ns[p->received] = t - p->sent_ns[p->received];
+    }
+    p->received++;
+}
+
+/* -------- wired: pty ----------------------------------------------- */
+
+static void on_frame(const joy_frame_t *f, void *ctx)
+{
+    int l, r;
+    if (joy_frame_drive(f, &l, &r)) record(ctx, CMD_SRC_LOCAL, l, r);
+}
+
+static void *wired_rx(void *arg)
+{
+    path_t *p = arg;
+    joy_parser_t parser;
+    uint8_t buf[256];
+    struct pollfd pfd = { .fd = p->fd, .events = POLLIN };
+
+    joy_parser_init(&parser);
+    while (p->received < p->count) {
+        if (poll(&pfd, 1, 1000) <= 0) break;
+        ssize_t n = read(p->fd, buf, sizeof(buf));
+        if (n <= 0) break;
+        joy_parser_feed(&parser, buf, (size_t)n, on_frame, p);
+    }
+    return NULL;
+}
+
+static int open_pty(int *slave)
+{
+    int m = posix_openpt(O_RDWR | O_NOCTTY);
+    if (m < 0 || grantpt(m) || unlockpt(m)) return -1;
+    *slave = open(ptsname(m), O_RDWR | O_NOCTTY);
+    if (*slave < 0) return -1;
+
+    struct termios t;
+    tcgetattr(*slave, &t);
+    cfmakeraw(&t);
+    tcsetattr(*slave, TCSANOW, &t);
+    tcgetattr(m, &t);
+    cfmakeraw(&t);
+    tcsetattr(m, TCSANOW, &t);
+    return m;
+}
+
+/* -------- MQTT: minimal PUBLISH over TCP loopback ------------------ */
+
+static size_t mqtt_publish(uint8_t *buf, const char *topic, const char *payload)
+{
+    size_t tl = strlen(topic), pl = strlen(payload);
+    size_t rem = 2 + tl + pl;               // QoS 0: no packet id
+    size_t n = 0;
+
+    buf[n++] = 0x30;
+    do {
+        uint8_t b = rem & 0x7F;
+        rem >>= 7;
+        buf[n++] = rem ? (b | 0x80) : b;
+    } while (rem);
+    buf[n++] = (uint8_t)(tl >> 8);
+    buf[n++] = (uint8_t)tl;
+    memcpy(&buf[n], topic, tl);
+    n += tl;
+    memcpy(&buf[n], payload, pl);
+    return n + pl;
+}
+
+static void on_motor(const char *topic, int topic_len,
+                     const char *data, int data_len, void *ctx)
+{
+    motor_cmd_t cmd;
+    if (motor_cmd_parse(data, data_len, &cmd) == MOTOR_CMD_OK) {
+        record(ctx, CMD_SRC_MQTT, cmd.left, cmd.right);
+    }
+}
+
+static void *mqtt_rx(void *arg)
+{
+    path_t *p = arg;
+    topic_router_t router;
+    uint8_t buf[4096];
+    size_t have = 0;
+    struct pollfd pfd = { .fd = p->fd, .events = POLLIN };
+
+    topic_router_init(&router);
+    topic_router_add(&router, MOTOR_TOPIC, 0, on_motor, p);
+
+    while (p->received < p->count) {
+        if (poll(&pfd, 1, 1000) <= 0) break;
+        ssize_t n = read(p->fd, &buf[have], sizeof(buf) - have);
+        if (n <= 0) break;
+        have += (size_t)n;
+
+        size_t off = 0;
+        for (;;) {
+            size_t rem = 0, hdr = 1;
+            int shift = 0;
+            while (off + hdr < have) {
+                uint8_t b = buf[off + hdr++];
+                rem |= (size_t)(b & 0x7F) << shift;
+                shift += 7;
+                if (!(b & 0x80)) break;
+            }
+            if (off + hdr + rem > have || off + hdr >= have) break;
+
+            const uint8_t *v = &buf[off + hdr];
+            int tl = (v[0] << 8) | v[1];
+            const char *topic = (const char *)&v[2];
+            const char *data = topic + tl;
+            int dl = (int)rem - 2 - tl;
+            topic_route_t *rt = topic_router_match(&router, topic, tl, dl);
+            if (rt) rt->fn(topic, tl, data, dl, rt->ctx);
+            off += hdr + rem;
+        }
+        memmove(buf, &buf[off], have - off);
+        have -= off;
+    }
+    return NULL;
+}
+
+static int tcp_pair(int *rx)
+{
+    int ls = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in a = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t al = sizeof(a);
+    if (bind(ls, (struct sockaddr *)&a, sizeof(a)) || listen(ls, 1) ||
+        getsockname(ls, (struct sockaddr *)&a, &al)) return -1;
+
+    int tx = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(tx, (struct sockaddr *)&a, sizeof(a))) return -1;
+    *rx = accept(ls, NULL, NULL);
+    close(ls);
+
+    int one = 1;
+    setsockopt(tx, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return tx;
+}
+
+/* -------- driver ----------------------------------------------------- */
+
+typedef size_t (*encode_fn)(uint8_t *buf, int i, int l, int r);
+
+static size_t enc_wired(uint8_t *buf, int i, int l, int r)
+{
+    return joy_frame_encode_drive(buf, JOY_FRAME_MAX, (uint8_t)i, l, r);
+}
+
+static size_t enc_mqtt(uint8_t *buf, int i, int l, int r)
+{
+    char payload[40];
+    snprintf(payload, sizeof(payload), "{\"left\":%d,\"right\":%d}", l, r);
+    return mqtt_publish(buf, MOTOR_TOPIC, payload);
+}
+
+static int cmp64(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void run(const char *name, int tx, path_t *p, void *(*rx)(void *),
+                encode_fn enc, int period_us)
+{
+    pthread_t th;
+    uint8_t buf[256];
+
+    pthread_create(&th, NULL, rx, p);
+    usleep(10000);
+
+    int64_t t = now_ns();
+    for (int i = 0; i < p->count; i++) {
+        int l, r;
+        cmd_for(i, &l, &r);
+        size_t n = enc(buf, i, l, r);
+        t += (int64_t)period_us * 1000;
+        sleep_until(t);
+        p->sent_ns[i] = now_ns();
+        write_all(tx, buf, n);
+        p->bytes += n;
+    }
+    pthread_join(th, NULL);
+
+    int n = p->received < p->count ? p->received : p->count;
+    qsort(p->lat_ns, (size_t)n, sizeof(int64_t), cmp64);
+    if (n == 0) {
+        printf("%-22s no commands received\n", name);
+        return;
+    }
+    printf("%-22s %6d/%-6d %8.1f %8.1f %8.1f %8.1f %7.1f\n", name, n, p->count,
+           p->lat_ns[n / 2] / 1000.0, p->lat_ns[n * 9 / 10] / 1000.0,
+           p->lat_ns[n * 99 / 100] / 1000.0, p->lat_ns[n - 1] / 1000.0,
+           (double)p->bytes / p->count);
+}
+
+static path_t path_new(int fd, int count)
+{
+    return (path_t){
+        .fd = fd, .count = count,
+        .sent_ns = calloc((size_t)count, sizeof(int64_t)),
+        .lat_ns  = calloc((size_t)count, sizeof(int64_t)),
+    };
+}
+
+/* Corrupt a stream of frames; every accepted frame must match what was
+ * sent for its sequence number. */
+typedef struct { int bad; int ok; } check_t;
+
+static void on_check(const joy_frame_t *f, void *ctx)
+{
+    check_t *c = ctx;
+    int l, r, el, er;
+    if (!joy_frame_drive(f, &l, &r)) {
+        c->bad++;
+        return;
+    }
+    cmd_for(f->seq, &el, &er);
+    if (l != el || r != er) c->bad++;
+    else c->ok++;
+}
+
+static void corruption_test(int frames)
+{
+    joy_parser_t p;
+    check_t c = {0};
+    uint8_t buf[JOY_FRAME_MAX];
+    int damaged = 0;
+
+    srand(1);
+    joy_parser_init(&p);
+    for (int i = 0; i < frames; i++) {
+        int l, r;
+        cmd_for((uint8_t)i, &l, &r);
+        size_t n = joy_frame_encode_drive(buf, sizeof(buf), (uint8_t)i, l, r);
+        int k = rand() % 20;
+        if (k == 0) {
+            buf[rand() % n] ^= (uint8_t)(1u << (rand() % 8));
+            damaged++;
+        } else if (k == 1) {
+            size_t at = (size_t)(rand() % (int)n);
+            memmove(&buf[at], &buf[at + 1], n - at - 1);
+            n--;
+            damaged++;
+        } else if (k == 2) {
+            uint8_t junk = (uint8_t)rand();
+            joy_parser_feed(&p, &junk, 1, on_check, &c);
+        }
+        joy_parser_feed(&p, buf, n, on_check, &c);
+    }
+    printf("\ncorruption: %d frames, %d damaged, 1 in 20 followed by a junk byte\n"
+           "  accepted %d, wrong %d, crc errors %u, resync bytes %u, seq gaps %u\n",
+           frames, damaged, c.ok, c.bad, p.crc_errors, p.resyncs, p.lost);
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 2000;
+    int period_us = argc > 2 ? atoi(argv[2]) : 1000;
+    if (count < 1 || count > MAX_CMDS) count = 2000;
+
+    static const cmd_source_cfg_t cfg[CMD_SRC_COUNT] = {
+        [CMD_SRC_ATTENDANT] = { 300000, 0, true },
+        [CMD_SRC_LOCAL]     = { 150000, 2000000, false },
+        [CMD_SRC_MQTT]      = { 600000, 0, false },
+        [CMD_SRC_HTTP]      = { 1000000, 0, false },
+    };
+    cmd_arbiter_init(&s_arb, cfg, 5);
+
+    printf("%d commands every %d us; latency write() -> arbiter submit (us)\n\n",
+           count, period_us);
+    printf("%-22s %13s %8s %8s %8s %8s %7s\n",
+           "path", "received", "p50", "p90", "p99", "max", "B/cmd");
+
+    int slave, master = open_pty(&slave);
+    if (master < 0) {
+        perror("pty");
+        return 1;
+    }
+    path_t wired = path_new(slave, count);
+    run("wired (pty)", master, &wired, wired_rx, enc_wired, period_us);
+
+    int rx, tx = tcp_pair(&rx);
+    if (tx < 0) {
+        perror("tcp");
+        return 1;
+    }
+    path_t mqtt = path_new(rx, count);
+    run("mqtt (tcp, no broker)", tx, &mqtt, mqtt_rx, enc_mqtt, period_us);
+
+    printf("\non the chair add the wire time of a frame: %.2f ms at 115200 baud\n",
+           (JOY_OVERHEAD + JOY_DRIVE_LEN) * 10 * 1000.0 / 115200);
+    corruption_test(20000);
+    return 0;
+}
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""Send wired-joystick drive frames to the controller over a serial port.
+
+Frames follow main/joy_frame.h: A5 5A, len, seq, type, payload, CRC-16
+(CCITT-FALSE, little-endian). The chair drops the local source after
+CONFIG_MOTOR_SRC_LOCAL_TIMEOUT_MS without frames, so the state is repeated
+at --hz while the script runs; Ctrl-C sends neutral before exiting.
+
+Usage:
+    tools/wired_joy/joy_send.py /dev/ttyUSB0 --left 30 --right 30 --seconds 2
+    tools/wired_joy/joy_send.py /dev/ttyUSB0 --v 40 --w -20 --seconds 2
+    tools/wired_joy/joy_send.py /dev/ttyUSB0 --sweep --seconds 10
+
+--v/--w send twist frames (forward speed, turn rate; mixed on the chair)
+instead of left/right drive frames.
+
+Requires pyserial (pip install pyserial).
+"""
+import argparse
+import math
+import struct
+import sys
+import time
+
+SYNC = b'\xa5\x5a'
+TYPE_DRIVE = 0x01
+TYPE_TWIST = 0x02
+
+
+def crc16(data: bytes) -> int:
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def frame(seq: int, ftype: int, a: int, b: int) -> bytes:
+    clip = lambda v: max(-100, min(100, int(v)))
+    body = struct.pack('<BBBbbB', 3, seq & 0xFF, ftype, clip(a), clip(b), 0)
+    return SYNC + body + struct.pack('<H', crc16(body))
+
+
+def drive_frame(seq: int, left: int, right: int) -> bytes:
+    return frame(seq, TYPE_DRIVE, left, right)
+
+
+def twist_frame(seq: int, v: int, w: int) -> bytes:
+    return frame(seq, TYPE_TWIST, v, w)
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('port', help='serial device (USB-UART bridge)')
+    parser.add_argument('--baud', type=int, default=115200, help='CONFIG_WIRED_JOY_BAUD')
+    parser.add_argument('--left', type=int, default=0, help='-100 ... 100')
+    parser.add_argument('--right', type=int, default=0, help='-100 ... 100')
+    parser.add_argument('--v', type=int, help='twist forward speed, -100 ... 100')
+    parser.add_argument('--w', type=int, help='twist turn rate, -100 ... 100 (+ = left)')
+    parser.add_argument('--sweep', action='store_true', help='slow sine on both sides instead')
+    parser.add_argument('--hz', type=float, default=50, help='frame rate')
+    parser.add_argument('--seconds', type=float, default=1, help='how long to send')
+    args = parser.parse_args()
+
+    try:
+        import serial
+    except ImportError:
+        sys.exit('pyserial is required (pip install pyserial)')
+
+    port = serial.Serial(args.port, args.baud)
+    seq = 0
+    start = time.monotonic()
+    try:
+        while (now := time.monotonic() - start) < args.seconds:
+            left, right = args.left, args.right
+            if args.sweep:
+                left = right = 30 * math.sin(2 * math.pi * now / 5)
+            if args.v is not None or args.w is not None:
+                port.write(twist_frame(seq, args.v or 0, args.w or 0))
+            else:
+                port.write(drive_frame(seq, left, right))
+            seq += 1
+            time.sleep(1 / args.hz)
+    except KeyboardInterrupt:
+        pass
+    port.write(drive_frame(seq, 0, 0))
+    port.flush()
+    print(f'sent {seq + 1} frames')
+
+
+if __name__ == '__main__':
+    main()